@@ -4,6 +4,11 @@
 
 #include "utils/memory.hpp"
 #include <cstddef>
+#include <limits> // std::numeric_limits
+#include <map> // std::map
+#include <source_location> // std::source_location
+#include <string_view> // std::string_view
+#include <utility> // std::pair
 #include <vector>
 
 namespace utils {
@@ -11,8 +16,61 @@ namespace utils {
     // Arena bump allocator
     class BumpAllocator {
         public:
+            // Where block memory comes from
+            enum class Backing {
+                Heap = 0, // malloc / free
+                Mapped,   // Anonymous private mapping (mmap / munmap), falls back to Heap on platforms without mmap
+            };
+
+            // Huge page usage for Mapped blocks (ignored for Heap blocks)
+            enum class HugePages {
+                None = 0,
+                Explicit,    // MAP_HUGETLB, requires pre-reserved huge pages and falls back to Transparent if the mapping fails
+                Transparent, // Regular mapping advised with MADV_HUGEPAGE
+            };
+
+            // What happens to blocks beyond the retention limit on reset()
+            enum class ReleasePolicy {
+                Unmap = 0, // Block is returned to the system and removed from the arena
+                Decommit,  // Physical pages are dropped (MADV_DONTNEED) but the address range is kept for reuse, only applies to Mapped blocks
+            };
+
+            struct Configuration {
+                std::size_t size = kilobytes(4); // Initial block size
+                float growth_factor = 2.0f;
+
+                Backing backing = Backing::Heap;
+                HugePages huge_pages = HugePages::None;
+                bool prefault = false; // Touch (MAP_POPULATE) block pages up front so the first allocations do not page fault
+
+                // Number of bytes of block capacity kept resident across reset(), blocks are retained in allocation order until this is exceeded
+                std::size_t retain = std::numeric_limits<std::size_t>::max();
+                ReleasePolicy release_policy = ReleasePolicy::Unmap;
+            };
+
+            // Snapshot of allocator usage, for tuning the initial block size and growth factor
+            // Counters marked 'since the last reset' are cleared by reset(), all others accumulate over the lifetime of the allocator
+            struct Statistics {
+                std::size_t allocation_count; // Since the last reset
+                std::size_t bytes_requested; // Since the last reset
+                std::size_t bytes_padding; // Bytes lost to alignment, since the last reset
+                std::size_t bytes_skipped; // Unused tails of blocks abandoned when an allocation moved on to the next block, since the last reset
+                std::size_t bytes_reserved; // Total capacity of all blocks currently held
+                std::size_t block_count;
+                std::size_t high_water_mark; // Largest number of bytes in use (requested + padding + skipped) between two resets
+                std::size_t reset_count;
+            };
+
+            // Allocation histogram entry, only recorded in debug builds
+            struct AllocationSite {
+                std::source_location source;
+                std::size_t count;
+                std::size_t bytes;
+            };
+
             // Accepts the initial block size to use
             explicit BumpAllocator(std::size_t size = kilobytes(4), float growth_factor = 2.0f);
+            explicit BumpAllocator(const Configuration& configuration);
             ~BumpAllocator();
 
             // Bump allocator should not be copied, only moved
@@ -22,24 +80,85 @@ namespace utils {
             BumpAllocator(BumpAllocator&& other) noexcept;
             BumpAllocator& operator=(BumpAllocator&& other) noexcept;
 
-            [[nodiscard]] void* allocate(std::size_t size, std::size_t alignment);
+            [[nodiscard]] void* allocate(std::size_t size, std::size_t alignment, std::source_location source = std::source_location::current());
+
+            // Rewinds all blocks, releasing any capacity past the configured retention limit
             void reset();
 
+            [[nodiscard]] Statistics statistics() const;
+
+            // Returns allocation sites ordered by total bytes allocated (descending)
+            // Always empty in release (NDEBUG) builds
+            [[nodiscard]] std::vector<AllocationSite> allocation_sites() const;
+
         private:
             struct Block {
                 void* data;
                 std::size_t size;  // Current allocation size
                 std::size_t capacity;
+                Backing backing; // Blocks requested as Mapped may fall back to Heap
             };
 
             // Appends a new block sized to fit at least 'size', continuing the geometric growth using the size of the last block allocated
             void allocate_block(std::size_t size);
 
-            float m_growth_factor;
+            // Returns the memory of 'block' to the system
+            static void release_block(Block& block);
+
+            Configuration m_configuration;
             std::vector<Block> m_blocks;
             std::size_t m_current_block_index;  // Index into m_blocks currently being allocated from
+
+            Statistics m_statistics; // Block counters are computed on demand from m_blocks
+            std::map<std::pair<std::string_view, std::uint_least32_t>, AllocationSite> m_allocation_sites; // Keyed by file name and line
+    };
+
+    // Arena for constructing objects of arbitrary types
+    // Destructors are recorded only for non-trivially destructible types, and are run in reverse order of construction on reset() / destruction
+    class ObjectArena {
+        public:
+            explicit ObjectArena(std::size_t size = kilobytes(4), float growth_factor = 2.0f);
+            explicit ObjectArena(const BumpAllocator::Configuration& configuration);
+            ~ObjectArena();
+
+            // Object arena should not be copied, only moved
+            ObjectArena(const ObjectArena&) = delete;
+            ObjectArena& operator=(const ObjectArena&) = delete;
+
+            ObjectArena(ObjectArena&& other) noexcept;
+            ObjectArena& operator=(ObjectArena&& other) noexcept;
+
+            // Returned pointer remains valid until the next call to reset()
+            // A location cannot be defaulted after the constructor arguments, allocations are therefore attributed to this function (use create_at())
+            template <typename T, typename ...Ts>
+            [[nodiscard]] T* create(Ts&&... args);
+
+            // Records 'source' as the site of the allocation (see BumpAllocator::allocate)
+            template <typename T, typename ...Ts>
+            [[nodiscard]] T* create_at(std::source_location source, Ts&&... args);
+
+            // Destroys all objects created since the last reset
+            void reset();
+
+            [[nodiscard]] BumpAllocator::Statistics statistics() const;
+
+        private:
+            // Stored in the arena alongside the object it destroys, forming an intrusive list from the most recently created object backwards
+            struct DestructorRecord {
+                Destructor destructor;
+                void* object;
+                DestructorRecord* previous;
+            };
+
+            void destroy();
+
+            BumpAllocator m_allocator;
+            DestructorRecord* m_destructors; // Most recently recorded destructor
     };
 
 }
 
+// Template definitions
+#include "utils/detail/allocator.tpp"
+
 #endif // UTILS_ALLOCATOR_HPP
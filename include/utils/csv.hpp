@@ -0,0 +1,143 @@
+
+#ifndef UTILS_CSV_HPP
+#define UTILS_CSV_HPP
+
+#include "utils/function.hpp"
+#include "utils/memory.hpp"
+#include "utils/string.hpp"
+#include <cstddef> // std::size_t
+#include <cstdint> // std::uint64_t
+#include <concepts> // std::invocable
+#include <istream> // std::istream
+#include <string> // std::string
+#include <string_view> // std::string_view
+#include <vector> // std::vector
+
+// Tokenizer for delimited text (CSV, TSV) that yields records as views into the input, without copying fields
+// Field and record boundaries are located 64 bytes at a time: the positions of delimiters, newlines, and quotes within a block are gathered into bitmasks,
+// and delimiters / newlines that fall between quotes are masked out, so that only the remaining (structural) positions are visited individually
+// Quoted fields may contain delimiters, newlines, and escaped (doubled) quotes, records are terminated by '\n' or "\r\n", and empty lines are skipped
+
+namespace utils {
+
+    struct CsvDialect {
+        char delimiter = ',';
+        char quote = '"'; // '\0' disables quoting, so that quote characters are ordinary field contents
+    };
+
+    // Tab-separated values, which have no quoting
+    inline constexpr CsvDialect TSV { '\t', '\0' };
+
+    class CsvRecord {
+        public:
+            CsvRecord();
+
+            // Number of fields
+            [[nodiscard]] std::size_t size() const;
+
+            // Field contents, with the enclosing quotes of quoted fields removed (escaped quotes inside are kept as-is)
+            [[nodiscard]] std::string_view operator[](std::size_t index) const;
+
+            // Field contents with escaped quotes collapsed, 'buffer' is only used (and the returned view only refers to it) if the field contains any
+            [[nodiscard]] std::string_view unescaped(std::size_t index, std::string& buffer) const;
+
+            // Converts the field to a number (as by try_from_string), fields with trailing characters that are not part of the number are invalid and leave 'out' unmodified
+            template <typename T>
+            FromStringResult parse(std::size_t index, T& out) const;
+
+            // Raw text of the record, excluding the line terminator
+            [[nodiscard]] std::string_view line() const;
+
+        private:
+            friend class CsvReader;
+
+            struct Field {
+                std::string_view value;
+                bool quoted;
+            };
+
+            std::string_view m_line;
+            std::vector<Field> m_fields; // Capacity is retained when the record is reused
+            char m_quote;
+    };
+
+    // Reads records from a buffer that is held in memory (or mapped) in its entirety
+    class CsvReader {
+        public:
+            // If 'final' is false, 'buffer' is the beginning of a larger input: a trailing record that is not terminated by a newline is not returned, as
+            // it may continue past the end of the buffer, and can be retrieved with remaining()
+            explicit CsvReader(std::string_view buffer, CsvDialect dialect = { }, bool final = true);
+
+            // Reads the next record into 'record' (reusing its storage), returns false once the input is exhausted
+            // Fields refer directly to the buffer
+            bool next(CsvRecord& record);
+
+            // Input following the last record returned
+            [[nodiscard]] std::string_view remaining() const;
+
+        private:
+            friend class CsvStream;
+
+            // Continues reading from 'buffer', which starts with remaining() and is followed by further input, without classifying the blocks of the
+            // partial record again
+            void resume(std::string_view buffer, bool final);
+
+            // Computes the structural positions of the next 64-byte block
+            void advance();
+
+            std::string_view m_buffer;
+            CsvDialect m_dialect;
+            bool m_final;
+
+            std::size_t m_record; // Start of the next record
+            std::vector<std::size_t> m_delimiters; // Delimiters of the record starting at 'm_record' visited so far
+            std::size_t m_block; // Start of the next block to classify ('m_structurals' refers to the block preceding it)
+            std::uint64_t m_structurals; // Delimiters and newlines outside of quotes in the current block, not yet visited
+            std::uint64_t m_quoted; // All bits set if the last classified block ends inside a quoted field
+    };
+
+    // Reads records from a stream in chunks, so that the input does not need to be held in memory in its entirety
+    // Records that span chunk boundaries are carried over into the next chunk
+    class CsvStream {
+        public:
+            explicit CsvStream(std::istream& stream, CsvDialect dialect = { }, std::size_t chunk_size = megabytes(1));
+
+            // Reads the next record into 'record' (reusing its storage), returns false once the stream is exhausted
+            // Fields refer to an internal buffer and remain valid until the next call
+            bool next(CsvRecord& record);
+
+        private:
+            // Appends the next chunk of the stream to the unconsumed tail of the buffer, returns false at the end of the stream
+            bool refill();
+
+            std::istream& m_stream;
+            CsvDialect m_dialect;
+            std::size_t m_chunk_size;
+
+            std::string m_buffer;
+            CsvReader m_reader;
+            bool m_exhausted;
+    };
+
+    // Parses 'buffer' on up to 'threads' threads (0 selects the number of hardware threads), invoking 'callback' for each record
+    // The buffer is split into chunks of similar size that are realigned to start at record boundaries, quotes are counted beforehand so that newlines
+    // within quoted fields are never mistaken for boundaries
+    // 'callback' is invoked concurrently, once per record, with the index of the chunk the record belongs to (less than 'threads'), records within a chunk are
+    // delivered in order by a single thread
+    // An exception thrown by 'callback' stops the chunk it was thrown from and is rethrown once all threads have finished
+    template <typename Fn> requires std::invocable<const Fn&, std::size_t, const CsvRecord&>
+    void parse_parallel(std::string_view buffer, const Fn& callback, CsvDialect dialect = { }, std::size_t threads = 0);
+
+    namespace detail {
+
+        // 'callback' refers to the callable passed to utils::parse_parallel, which may be of any size
+        void parse_parallel(std::string_view buffer, const utils::InplaceFunction<void(std::size_t chunk, const CsvRecord& record)>& callback, CsvDialect dialect, std::size_t threads);
+
+    }
+
+}
+
+// Template definitions
+#include "utils/detail/csv.tpp"
+
+#endif // UTILS_CSV_HPP
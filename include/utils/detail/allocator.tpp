@@ -0,0 +1,39 @@
+
+#ifndef UTILS_ALLOCATOR_TPP
+#define UTILS_ALLOCATOR_TPP
+
+#include <new> // placement new
+#include <source_location> // std::source_location
+#include <type_traits> // std::is_trivially_destructible
+#include <utility> // std::forward
+
+namespace utils {
+
+    template <typename T, typename ...Ts>
+    T* ObjectArena::create(Ts&&... args) {
+        return create_at<T>(std::source_location::current(), std::forward<Ts>(args)...);
+    }
+
+    template <typename T, typename ...Ts>
+    T* ObjectArena::create_at(std::source_location source, Ts&&... args) {
+        DestructorRecord* record = nullptr;
+        if constexpr (!std::is_trivially_destructible<T>::value) {
+            // Reserve the record before constructing the object so that a failed allocation never leaves a live object without its destructor
+            record = static_cast<DestructorRecord*>(m_allocator.allocate(sizeof(DestructorRecord), alignof(DestructorRecord), source));
+        }
+
+        T* object = new (m_allocator.allocate(sizeof(T), alignof(T), source)) T(std::forward<Ts>(args)...);
+
+        if constexpr (!std::is_trivially_destructible<T>::value) {
+            record->destructor = get_destructor<T>();
+            record->object = object;
+            record->previous = m_destructors;
+            m_destructors = record;
+        }
+
+        return object;
+    }
+
+}
+
+#endif // UTILS_ALLOCATOR_TPP
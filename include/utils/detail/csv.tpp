@@ -0,0 +1,22 @@
+
+#ifndef UTILS_CSV_TPP
+#define UTILS_CSV_TPP
+
+namespace utils {
+
+    template <typename T>
+    FromStringResult CsvRecord::parse(std::size_t index, T& out) const {
+        return detail::try_from_field(m_fields[index].value, out);
+    }
+
+    template <typename Fn> requires std::invocable<const Fn&, std::size_t, const CsvRecord&>
+    void parse_parallel(std::string_view buffer, const Fn& callback, CsvDialect dialect, std::size_t threads) {
+        // Only a reference to the callable is stored, so that captures of any size are supported
+        detail::parse_parallel(buffer, [&callback](std::size_t chunk, const CsvRecord& record) {
+            callback(chunk, record);
+        }, dialect, threads);
+    }
+
+}
+
+#endif // UTILS_CSV_TPP
@@ -4,14 +4,13 @@
 
 #include "utils/hash.hpp"
 #include "utils/assert.hpp"
-#include "utils/memory.hpp"
+#include "utils/allocator.hpp"
+#include "utils/function.hpp"
+#include "utils/flat_hash_map.hpp"
 
-#include <unordered_map> // std::unordered_map
-#include <unordered_set> // std::unordered_set
 #include <memory> // std::unique_ptr, std::weak_ptr
 #include <vector> // std::vector
 #include <typeindex> // std::type_index
-#include <functional> // std::function
 
 namespace utils {
     namespace detail {
@@ -24,7 +23,7 @@ namespace utils {
                 template <typename Fn>
                 explicit Callback(Fn fn);
                 
-                // Wrappers around public-facing events API to avoid incurring overhead with copying std::function objects
+                // Wrappers around public-facing events API to avoid incurring overhead with copying callable objects
                 template <typename T, typename U, typename E>
                 Callback(const std::shared_ptr<T>& object, bool (U::*function)(const E&));
                 
@@ -79,8 +78,8 @@ namespace utils {
                 void enable();
                 void disable();
                 
-                // Type-erased event handler callback
-                std::function<bool(const EventData&)> function;
+                // Type-erased event handler callback, stored inline (lambda captures larger than the capacity are rejected at compile time)
+                MoveOnlyInplaceFunction<bool(const EventData&), 8 * sizeof(void*)> function;
                 
                 std::size_t id;
                 std::type_index type;
@@ -129,62 +128,27 @@ namespace utils {
             std::type_index type;
         };
         
-        // EventQueue acts as a linear allocator for a given frame of events
+        // EventQueue stores the events of a given frame in an object arena
+        // Events are never relocated, and non-trivially destructible events are destroyed when the queue is reset
         class EventQueue {
             public:
-                class ForwardIterator {
-                    public:
-                        ForwardIterator(void* base);
-                        ~ForwardIterator() = default;
-                        
-                        EventData operator*() const;
-                        ForwardIterator& operator++();
-                        bool operator!=(const ForwardIterator& other) const;
-                        
-                    private:
-                        void* m_base;
-                };
-                
+                using ForwardIterator = std::vector<EventData>::const_iterator;
+
                 explicit EventQueue(std::size_t size = kilobytes(256));
                 ~EventQueue() = default;
                 
+                // 'source' is recorded as the site of the allocation of the event (see BumpAllocator::allocate)
                 template <typename E>
-                void push(E&& event);
-                
-                [[nodiscard]] ForwardIterator begin();
-                [[nodiscard]] ForwardIterator end();
+                void push(E&& event, std::source_location source = std::source_location::current());
                 
-                // Random element access would be an O(N) operation and is not supported
-                // const Event& operator[](std::size_t);
+                [[nodiscard]] ForwardIterator begin() const;
+                [[nodiscard]] ForwardIterator end() const;
                 
                 void reset();
                 
             private:
-                // Metadata about an event allocation
-                struct Allocation {
-                    union {
-                        CopyConstructor copy;
-                        MoveConstructor move;
-                    } copy_constructor;
-                    Destructor destructor;
-                    unsigned int size;
-                    enum class CopyConstructorType {
-                        None = 0,
-                        Copy,
-                        Move,
-                    } copy_op;
-                    
-                    std::type_index type;
-                    // Timestamp timestamp;
-                };
-                
-                void reallocate();
-                
-                void* m_data;
-                std::size_t m_offset;
-                
-                std::size_t m_capacity; // Capacity, in bytes
-                std::size_t m_allocation_count;
+                ObjectArena m_arena;
+                std::vector<EventData> m_events; // In order of dispatch, capacity is kept across frames
         };
         
         template <typename T>
@@ -246,10 +210,10 @@ namespace utils {
         
         extern IdGenerator id_generator;
         extern EventQueue event_queue;
-        extern std::unordered_map<std::type_index, std::vector<std::weak_ptr<Callback>>> dispatch_map;
+        extern FlatHashMap<std::type_index, std::vector<std::weak_ptr<Callback>>> dispatch_map;
 
         using CallbackRegistration = std::variant<std::monostate, CallbackHandle, std::vector<CallbackHandle>>;
-        extern std::unordered_map<std::uintptr_t, CallbackRegistration> callback_registrations;
+        extern FlatHashMap<std::uintptr_t, CallbackRegistration> callback_registrations;
         
         // Note for Callback constructors: object validity is checked before the callback is constructed
         
@@ -407,60 +371,10 @@ namespace utils {
         }
         
         template <typename E>
-        void EventQueue::push(E&& event) {
+        void EventQueue::push(E&& event, std::source_location source) {
             using EventType = std::decay_t<E>;
-
-            std::size_t block_size = sizeof(Allocation) + sizeof(EventType);
-            std::size_t available_size = m_capacity - m_offset;
-            if (available_size < block_size) {
-                // Allocator is out of memory, need to reallocate the internal data store
-                m_capacity *= 2;
-                reallocate();
-            }
-
-            std::byte* block = reinterpret_cast<std::byte*>(m_data) + m_offset;
-            m_offset += block_size;
-
-            // Initialize metadata block
-            Allocation& allocation = *reinterpret_cast<Allocation*>(block);
-            allocation.copy_op = Allocation::CopyConstructorType::None;
-            allocation.type = typeid(EventType);
-            allocation.size = sizeof(EventType);
-
-            if constexpr (!std::is_trivially_destructible<EventType>::value && std::is_destructible<EventType>::value) {
-                // Hybrid allocator automatically stores destructors for non-trivially destructible types
-                allocation.destructor = get_destructor<EventType>();
-            }
-            else {
-                allocation.destructor = nullptr; // Clear underlying memory since Allocation objects are reused per frame
-            }
-
-            // Prefer move constructor over copy constructor, if available
-            if constexpr (!std::is_trivially_copy_constructible<EventType>::value && std::is_copy_constructible<EventType>::value) {
-                allocation.copy_constructor.copy = get_copy_constructor<EventType>();
-                allocation.copy_op = Allocation::CopyConstructorType::Copy;
-            }
-            if constexpr (!std::is_trivially_move_constructible<EventType>::value && std::is_move_constructible<EventType>::value) {
-                allocation.copy_constructor.move = get_move_constructor<EventType>();
-                allocation.copy_op = Allocation::CopyConstructorType::Move;
-            }
-
-            void* data = block + sizeof(Allocation);
-            ++m_allocation_count;
-
-            // Migrate event data
-            switch (allocation.copy_op) {
-                case Allocation::CopyConstructorType::None:
-                    // Event type is trivially copyable
-                    std::memcpy(data, &event, sizeof(EventType));
-                    break;
-                case Allocation::CopyConstructorType::Copy:
-                    allocation.copy_constructor.copy(data, &event);
-                    break;
-                case Allocation::CopyConstructorType::Move:
-                    allocation.copy_constructor.move(data, &event);
-                    break;
-            }
+            EventType* data = m_arena.create_at<EventType>(source, std::forward<E>(event));
+            m_events.push_back({ .data = data, .type = typeid(EventType) });
         }
         
         template <typename T, typename Fn>
@@ -774,9 +688,9 @@ namespace utils {
     }
     
     template <typename E>
-    void dispatch_event(E&& event) {
+    void dispatch_event(E&& event, std::source_location source) {
         using namespace detail;
-        event_queue.push(std::forward<E>(event));
+        event_queue.push(std::forward<E>(event), source);
     }
 
     template <typename E, typename ...Ts>
@@ -784,6 +698,12 @@ namespace utils {
         using namespace detail;
         event_queue.push(E(args...));
     }
+
+    template <typename E, typename ...Ts>
+    void dispatch_event_at(std::source_location source, const Ts&... args) {
+        using namespace detail;
+        event_queue.push(E(args...), source);
+    }
     
     // To be called by the implementation
     // Processes all events from the last frame
@@ -0,0 +1,39 @@
+
+#ifndef UTILS_FILTERS_TPP
+#define UTILS_FILTERS_TPP
+
+namespace utils {
+
+    template <typename T>
+    void BloomFilter::insert(const T& value) {
+        insert_hash(static_cast<std::uint64_t>(Hash<T> { }(value)));
+    }
+
+    template <typename T>
+    bool BloomFilter::contains(const T& value) const {
+        return contains_hash(static_cast<std::uint64_t>(Hash<T> { }(value)));
+    }
+
+    template <typename T>
+    bool CuckooFilter::insert(const T& value) {
+        return insert_hash(static_cast<std::uint64_t>(Hash<T> { }(value)));
+    }
+
+    template <typename T>
+    bool CuckooFilter::contains(const T& value) const {
+        return contains_hash(static_cast<std::uint64_t>(Hash<T> { }(value)));
+    }
+
+    template <typename T>
+    bool CuckooFilter::erase(const T& value) {
+        return erase_hash(static_cast<std::uint64_t>(Hash<T> { }(value)));
+    }
+
+    template <typename T>
+    void HyperLogLog::insert(const T& value) {
+        insert_hash(static_cast<std::uint64_t>(Hash<T> { }(value)));
+    }
+
+}
+
+#endif // UTILS_FILTERS_TPP
@@ -0,0 +1,725 @@
+
+#ifndef UTILS_FLAT_HASH_MAP_TPP
+#define UTILS_FLAT_HASH_MAP_TPP
+
+#include "utils/memory.hpp"
+#include <algorithm> // std::max
+#include <bit> // std::countr_zero, std::countl_zero, std::bit_ceil
+#include <cstring> // std::memset, std::memcpy
+#include <new> // operator new, std::align_val_t
+#include <stdexcept> // std::out_of_range
+
+namespace utils {
+
+    namespace detail {
+
+        // Lookups are transparent only if both the hash and the equality functors opt in
+        template <typename H, typename E>
+        inline constexpr bool is_transparent_lookup = requires {
+            typename H::is_transparent;
+            typename E::is_transparent;
+        };
+
+        // GroupMask implementation
+
+        template <unsigned Shift>
+        GroupMask<Shift>::GroupMask(std::uint64_t mask) : m_mask(mask) {
+        }
+
+        template <unsigned Shift>
+        GroupMask<Shift>::operator bool() const {
+            return m_mask != 0;
+        }
+
+        template <unsigned Shift>
+        std::size_t GroupMask<Shift>::lowest() const {
+            return static_cast<std::size_t>(std::countr_zero(m_mask)) >> Shift;
+        }
+
+        template <unsigned Shift>
+        std::size_t GroupMask<Shift>::trailing_zeros() const {
+            return static_cast<std::size_t>(std::countr_zero(m_mask)) >> Shift;
+        }
+
+        template <unsigned Shift>
+        std::size_t GroupMask<Shift>::leading_zeros(std::size_t width) const {
+            // Mask bits occupy the low (width << Shift) bits
+            std::size_t unused = 64 - (width << Shift);
+            return (static_cast<std::size_t>(std::countl_zero(m_mask)) - unused) >> Shift;
+        }
+
+        template <unsigned Shift>
+        GroupMask<Shift>& GroupMask<Shift>::operator++() {
+            m_mask &= m_mask - 1;
+            return *this;
+        }
+
+        // Group implementation
+
+        #if defined(UTILS_FLAT_HASH_MAP_SSE2)
+
+            inline Group::Group(const ControlByte* control) : m_control(_mm_loadu_si128(reinterpret_cast<const __m128i*>(control))) {
+            }
+
+            inline Group::Mask Group::match(std::uint8_t h2) const {
+                __m128i pattern = _mm_set1_epi8(static_cast<char>(h2));
+                return Mask(static_cast<std::uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(pattern, m_control))));
+            }
+
+            inline Group::Mask Group::match_empty() const {
+                __m128i pattern = _mm_set1_epi8(CONTROL_EMPTY);
+                return Mask(static_cast<std::uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(pattern, m_control))));
+            }
+
+            inline Group::Mask Group::match_empty_or_deleted() const {
+                // Empty and deleted control bytes are the only ones with the sign bit set
+                return Mask(static_cast<std::uint32_t>(_mm_movemask_epi8(m_control)));
+            }
+
+        #else
+
+            inline Group::Group(const ControlByte* control) : m_control(0) {
+                std::memcpy(&m_control, control, sizeof(m_control));
+                if constexpr (std::endian::native == std::endian::big) {
+                    // Mask bit positions assume that the first control byte is the least significant byte
+                    std::uint64_t swapped = 0;
+                    for (std::size_t i = 0; i < sizeof(m_control); ++i) {
+                        swapped |= ((m_control >> (8 * i)) & 0xff) << (8 * (sizeof(m_control) - 1 - i));
+                    }
+                    m_control = swapped;
+                }
+            }
+
+            inline Group::Mask Group::match(std::uint8_t h2) const {
+                // Classic 'has zero byte' trick, may yield false positives for bytes following a true match
+                constexpr std::uint64_t lsbs = 0x0101010101010101ull;
+                constexpr std::uint64_t msbs = 0x8080808080808080ull;
+                std::uint64_t x = m_control ^ (lsbs * h2);
+                return Mask((x - lsbs) & ~x & msbs);
+            }
+
+            inline Group::Mask Group::match_empty() const {
+                // Empty (0b10000000) is the only control byte with the sign bit set and bit 1 clear
+                constexpr std::uint64_t msbs = 0x8080808080808080ull;
+                return Mask(m_control & ~(m_control << 6) & msbs);
+            }
+
+            inline Group::Mask Group::match_empty_or_deleted() const {
+                // Empty and deleted control bytes are the only ones with the sign bit set and bit 0 clear (full bytes have the sign bit clear)
+                constexpr std::uint64_t msbs = 0x8080808080808080ull;
+                return Mask(m_control & ~(m_control << 7) & msbs);
+            }
+
+        #endif
+
+        // Spreads entropy from all bits of the user-provided hash, as std::hash is the identity function for integers in most standard libraries
+        inline std::size_t mix_hash(std::size_t hash) {
+            return static_cast<std::size_t>(hash64_mix(static_cast<std::uint64_t>(hash), 0x9e3779b97f4a7c15ull));
+        }
+
+        // Low 7 bits of the hash, stored in the control byte
+        inline std::uint8_t h2(std::size_t hash) {
+            return static_cast<std::uint8_t>(hash & 0x7f);
+        }
+
+        // Remaining bits select the start of the probe sequence
+        inline std::size_t h1(std::size_t hash) {
+            return hash >> 7;
+        }
+
+        // FlatHashTable::Iterator implementation
+
+        template <typename Traits, typename H, typename E>
+        template <bool Const>
+        FlatHashTable<Traits, H, E>::Iterator<Const>::Iterator() : m_table(nullptr),
+                                                                   m_index(0) {
+        }
+
+        template <typename Traits, typename H, typename E>
+        template <bool Const>
+        FlatHashTable<Traits, H, E>::Iterator<Const>::Iterator(const FlatHashTable* table, std::size_t index) : m_table(table),
+                                                                                                                m_index(index) {
+        }
+
+        template <typename Traits, typename H, typename E>
+        template <bool Const>
+        template <bool C> requires (Const && !C)
+        FlatHashTable<Traits, H, E>::Iterator<Const>::Iterator(const Iterator<C>& other) : m_table(other.m_table),
+                                                                                           m_index(other.m_index) {
+        }
+
+        template <typename Traits, typename H, typename E>
+        template <bool Const>
+        typename FlatHashTable<Traits, H, E>::template Iterator<Const>::reference FlatHashTable<Traits, H, E>::Iterator<Const>::operator*() const {
+            return m_table->m_slots[m_index];
+        }
+
+        template <typename Traits, typename H, typename E>
+        template <bool Const>
+        typename FlatHashTable<Traits, H, E>::template Iterator<Const>::pointer FlatHashTable<Traits, H, E>::Iterator<Const>::operator->() const {
+            return m_table->m_slots + m_index;
+        }
+
+        template <typename Traits, typename H, typename E>
+        template <bool Const>
+        typename FlatHashTable<Traits, H, E>::template Iterator<Const>& FlatHashTable<Traits, H, E>::Iterator<Const>::operator++() {
+            ++m_index;
+            skip_empty();
+            return *this;
+        }
+
+        template <typename Traits, typename H, typename E>
+        template <bool Const>
+        typename FlatHashTable<Traits, H, E>::template Iterator<Const> FlatHashTable<Traits, H, E>::Iterator<Const>::operator++(int) {
+            Iterator copy = *this;
+            ++(*this);
+            return copy;
+        }
+
+        template <typename Traits, typename H, typename E>
+        template <bool Const>
+        bool FlatHashTable<Traits, H, E>::Iterator<Const>::operator==(const Iterator& other) const {
+            return m_index == other.m_index;
+        }
+
+        template <typename Traits, typename H, typename E>
+        template <bool Const>
+        bool FlatHashTable<Traits, H, E>::Iterator<Const>::operator!=(const Iterator& other) const {
+            return m_index != other.m_index;
+        }
+
+        template <typename Traits, typename H, typename E>
+        template <bool Const>
+        void FlatHashTable<Traits, H, E>::Iterator<Const>::skip_empty() {
+            // Control bytes are contiguous, so iteration walks memory linearly
+            while (m_index < m_table->m_capacity && m_table->m_control[m_index] < 0) {
+                ++m_index;
+            }
+        }
+
+        // FlatHashTable implementation
+
+        template <typename Traits, typename H, typename E>
+        FlatHashTable<Traits, H, E>::FlatHashTable() : m_slots(nullptr),
+                                                       m_control(nullptr),
+                                                       m_capacity(0),
+                                                       m_size(0),
+                                                       m_growth_left(0),
+                                                       m_hash(),
+                                                       m_equal() {
+        }
+
+        template <typename Traits, typename H, typename E>
+        FlatHashTable<Traits, H, E>::FlatHashTable(std::size_t capacity, const H& hash, const E& equal) : m_slots(nullptr),
+                                                                                                        m_control(nullptr),
+                                                                                                        m_capacity(0),
+                                                                                                        m_size(0),
+                                                                                                        m_growth_left(0),
+                                                                                                        m_hash(hash),
+                                                                                                        m_equal(equal) {
+            reserve(capacity);
+        }
+
+        template <typename Traits, typename H, typename E>
+        FlatHashTable<Traits, H, E>::~FlatHashTable() {
+            destroy();
+        }
+
+        template <typename Traits, typename H, typename E>
+        FlatHashTable<Traits, H, E>::FlatHashTable(const FlatHashTable& other) : FlatHashTable(other.m_size, other.m_hash, other.m_equal) {
+            for (const value_type& value : other) {
+                insert(value);
+            }
+        }
+
+        template <typename Traits, typename H, typename E>
+        FlatHashTable<Traits, H, E>& FlatHashTable<Traits, H, E>::operator=(const FlatHashTable& other) {
+            if (this == &other) {
+                return *this;
+            }
+
+            FlatHashTable copy(other);
+            *this = std::move(copy);
+
+            return *this;
+        }
+
+        template <typename Traits, typename H, typename E>
+        FlatHashTable<Traits, H, E>::FlatHashTable(FlatHashTable&& other) noexcept : m_slots(other.m_slots),
+                                                                                     m_control(other.m_control),
+                                                                                     m_capacity(other.m_capacity),
+                                                                                     m_size(other.m_size),
+                                                                                     m_growth_left(other.m_growth_left),
+                                                                                     m_hash(std::move(other.m_hash)),
+                                                                                     m_equal(std::move(other.m_equal)) {
+            other.m_slots = nullptr;
+            other.m_control = nullptr;
+            other.m_capacity = 0;
+            other.m_size = 0;
+            other.m_growth_left = 0;
+        }
+
+        template <typename Traits, typename H, typename E>
+        FlatHashTable<Traits, H, E>& FlatHashTable<Traits, H, E>::operator=(FlatHashTable&& other) noexcept {
+            if (this == &other) {
+                return *this;
+            }
+
+            destroy();
+
+            m_slots = other.m_slots;
+            m_control = other.m_control;
+            m_capacity = other.m_capacity;
+            m_size = other.m_size;
+            m_growth_left = other.m_growth_left;
+            m_hash = std::move(other.m_hash);
+            m_equal = std::move(other.m_equal);
+
+            other.m_slots = nullptr;
+            other.m_control = nullptr;
+            other.m_capacity = 0;
+            other.m_size = 0;
+            other.m_growth_left = 0;
+
+            return *this;
+        }
+
+        template <typename Traits, typename H, typename E>
+        typename FlatHashTable<Traits, H, E>::iterator FlatHashTable<Traits, H, E>::begin() {
+            iterator it(this, 0);
+            it.skip_empty();
+            return it;
+        }
+
+        template <typename Traits, typename H, typename E>
+        typename FlatHashTable<Traits, H, E>::iterator FlatHashTable<Traits, H, E>::end() {
+            return iterator(this, m_capacity);
+        }
+
+        template <typename Traits, typename H, typename E>
+        typename FlatHashTable<Traits, H, E>::const_iterator FlatHashTable<Traits, H, E>::begin() const {
+            const_iterator it(this, 0);
+            it.skip_empty();
+            return it;
+        }
+
+        template <typename Traits, typename H, typename E>
+        typename FlatHashTable<Traits, H, E>::const_iterator FlatHashTable<Traits, H, E>::end() const {
+            return const_iterator(this, m_capacity);
+        }
+
+        template <typename Traits, typename H, typename E>
+        std::size_t FlatHashTable<Traits, H, E>::size() const {
+            return m_size;
+        }
+
+        template <typename Traits, typename H, typename E>
+        bool FlatHashTable<Traits, H, E>::empty() const {
+            return m_size == 0;
+        }
+
+        template <typename Traits, typename H, typename E>
+        std::size_t FlatHashTable<Traits, H, E>::capacity() const {
+            return m_capacity;
+        }
+
+        template <typename Traits, typename H, typename E>
+        void FlatHashTable<Traits, H, E>::clear() {
+            if (!m_capacity) {
+                return;
+            }
+
+            if constexpr (!std::is_trivially_destructible<value_type>::value) {
+                for (std::size_t i = 0; i < m_capacity; ++i) {
+                    if (m_control[i] >= 0) {
+                        m_slots[i].~value_type();
+                    }
+                }
+            }
+
+            std::memset(m_control, CONTROL_EMPTY, m_capacity + Group::WIDTH);
+            m_size = 0;
+            m_growth_left = growth_limit(m_capacity);
+        }
+
+        template <typename Traits, typename H, typename E>
+        void FlatHashTable<Traits, H, E>::reserve(std::size_t count) {
+            if (count <= growth_limit(m_capacity)) {
+                return;
+            }
+
+            // Smallest power-of-two capacity whose growth limit accommodates 'count'
+            std::size_t capacity = std::max(MINIMUM_CAPACITY, std::bit_ceil(count + count / 7 + 1));
+            while (growth_limit(capacity) < count) {
+                capacity *= 2;
+            }
+
+            resize(capacity);
+        }
+
+        template <typename Traits, typename H, typename E>
+        std::pair<typename FlatHashTable<Traits, H, E>::iterator, bool> FlatHashTable<Traits, H, E>::insert(const value_type& value) {
+            const key_type& key = Traits::key(value);
+            std::size_t h = hash(key);
+
+            auto [index, found] = find_or_prepare_insert(key, h);
+            if (!found) {
+                new (m_slots + index) value_type(value);
+                commit_insert(index, h);
+            }
+
+            return { iterator(this, index), !found };
+        }
+
+        template <typename Traits, typename H, typename E>
+        std::pair<typename FlatHashTable<Traits, H, E>::iterator, bool> FlatHashTable<Traits, H, E>::insert(value_type&& value) {
+            const key_type& key = Traits::key(value);
+            std::size_t h = hash(key);
+
+            auto [index, found] = find_or_prepare_insert(key, h);
+            if (!found) {
+                new (m_slots + index) value_type(std::move(value));
+                commit_insert(index, h);
+            }
+
+            return { iterator(this, index), !found };
+        }
+
+        template <typename Traits, typename H, typename E>
+        template <typename ...Ts>
+        std::pair<typename FlatHashTable<Traits, H, E>::iterator, bool> FlatHashTable<Traits, H, E>::emplace(Ts&&... args) {
+            // The key is only known after the value is constructed
+            return insert(value_type(std::forward<Ts>(args)...));
+        }
+
+        template <typename Traits, typename H, typename E>
+        template <typename Q>
+        typename FlatHashTable<Traits, H, E>::iterator FlatHashTable<Traits, H, E>::find(const Q& key) {
+            if constexpr (is_transparent_lookup<H, E> || std::is_same<Q, key_type>::value) {
+                return iterator(this, find_index(key, hash(key)));
+            }
+            else {
+                return find(static_cast<const key_type&>(key_type(key)));
+            }
+        }
+
+        template <typename Traits, typename H, typename E>
+        template <typename Q>
+        typename FlatHashTable<Traits, H, E>::const_iterator FlatHashTable<Traits, H, E>::find(const Q& key) const {
+            if constexpr (is_transparent_lookup<H, E> || std::is_same<Q, key_type>::value) {
+                return const_iterator(this, find_index(key, hash(key)));
+            }
+            else {
+                return find(static_cast<const key_type&>(key_type(key)));
+            }
+        }
+
+        template <typename Traits, typename H, typename E>
+        template <typename Q>
+        bool FlatHashTable<Traits, H, E>::contains(const Q& key) const {
+            return find(key) != end();
+        }
+
+        template <typename Traits, typename H, typename E>
+        template <typename Q>
+        std::size_t FlatHashTable<Traits, H, E>::count(const Q& key) const {
+            return contains(key) ? 1 : 0;
+        }
+
+        template <typename Traits, typename H, typename E>
+        template <typename Q>
+        std::size_t FlatHashTable<Traits, H, E>::erase(const Q& key) {
+            iterator it = find(key);
+            if (it == end()) {
+                return 0;
+            }
+
+            erase_index(it.m_index);
+            return 1;
+        }
+
+        template <typename Traits, typename H, typename E>
+        typename FlatHashTable<Traits, H, E>::iterator FlatHashTable<Traits, H, E>::erase(const_iterator position) {
+            // Erasing never moves other elements, so the following element can be found after the slot is cleared
+            erase_index(position.m_index);
+
+            iterator it(this, position.m_index);
+            it.skip_empty();
+            return it;
+        }
+
+        template <typename Traits, typename H, typename E>
+        typename FlatHashTable<Traits, H, E>::iterator FlatHashTable<Traits, H, E>::erase(iterator position) {
+            return erase(const_iterator(position));
+        }
+
+        template <typename Traits, typename H, typename E>
+        template <typename Q>
+        std::size_t FlatHashTable<Traits, H, E>::hash(const Q& key) const {
+            return mix_hash(m_hash(key));
+        }
+
+        template <typename Traits, typename H, typename E>
+        template <typename Q>
+        std::size_t FlatHashTable<Traits, H, E>::find_index(const Q& key, std::size_t hash) const {
+            if (!m_capacity) {
+                return 0; // end()
+            }
+
+            std::size_t mask = m_capacity - 1;
+            std::size_t position = h1(hash) & mask;
+            std::uint8_t tag = h2(hash);
+
+            // Probe groups in triangular order, which visits every group exactly once for power-of-two capacities
+            for (std::size_t step = Group::WIDTH; ; step += Group::WIDTH) {
+                Group group(m_control + position);
+
+                for (auto match = group.match(tag); match; ++match) {
+                    std::size_t index = (position + match.lowest()) & mask;
+                    if (m_equal(Traits::key(m_slots[index]), key)) {
+                        return index;
+                    }
+                }
+
+                if (group.match_empty()) {
+                    // Probing stops at the first group with an empty slot, as the key would have been inserted there
+                    return m_capacity;
+                }
+
+                position = (position + step) & mask;
+            }
+        }
+
+        template <typename Traits, typename H, typename E>
+        template <typename Q>
+        std::pair<std::size_t, bool> FlatHashTable<Traits, H, E>::find_or_prepare_insert(const Q& key, std::size_t hash) {
+            std::size_t index = find_index(key, hash);
+            if (index != m_capacity) {
+                return { index, true };
+            }
+
+            if (!m_capacity) {
+                resize(MINIMUM_CAPACITY);
+            }
+
+            index = find_first_non_full(hash);
+
+            // Reusing a deleted slot does not consume growth
+            if (m_growth_left == 0 && m_control[index] != CONTROL_DELETED) {
+                rehash_and_grow();
+                index = find_first_non_full(hash);
+            }
+
+            return { index, false };
+        }
+
+        template <typename Traits, typename H, typename E>
+        void FlatHashTable<Traits, H, E>::commit_insert(std::size_t index, std::size_t hash) {
+            if (m_control[index] == CONTROL_EMPTY) {
+                --m_growth_left;
+            }
+
+            set_control(index, static_cast<ControlByte>(h2(hash)));
+            ++m_size;
+        }
+
+        template <typename Traits, typename H, typename E>
+        std::size_t FlatHashTable<Traits, H, E>::growth_limit(std::size_t capacity) {
+            return capacity - capacity / 8;
+        }
+
+        template <typename Traits, typename H, typename E>
+        std::size_t FlatHashTable<Traits, H, E>::find_first_non_full(std::size_t hash) const {
+            std::size_t mask = m_capacity - 1;
+            std::size_t position = h1(hash) & mask;
+
+            for (std::size_t step = Group::WIDTH; ; step += Group::WIDTH) {
+                Group group(m_control + position);
+
+                if (auto available = group.match_empty_or_deleted()) {
+                    return (position + available.lowest()) & mask;
+                }
+
+                position = (position + step) & mask;
+            }
+        }
+
+        template <typename Traits, typename H, typename E>
+        void FlatHashTable<Traits, H, E>::set_control(std::size_t index, ControlByte value) {
+            m_control[index] = value;
+
+            // Keep the mirrored copy of the first group in sync
+            if (index < Group::WIDTH) {
+                m_control[m_capacity + index] = value;
+            }
+        }
+
+        template <typename Traits, typename H, typename E>
+        void FlatHashTable<Traits, H, E>::erase_index(std::size_t index) {
+            m_slots[index].~value_type();
+            --m_size;
+
+            // If no probe sequence could have passed over this slot (there is an empty slot within one group width on either side), the slot can be marked
+            // as empty instead of leaving a tombstone that would lengthen future probes
+            std::size_t mask = m_capacity - 1;
+            auto empty_before = Group(m_control + ((index - Group::WIDTH) & mask)).match_empty();
+            auto empty_after = Group(m_control + index).match_empty();
+
+            if (empty_before && empty_after && empty_before.leading_zeros(Group::WIDTH) + empty_after.trailing_zeros() < Group::WIDTH) {
+                set_control(index, CONTROL_EMPTY);
+                ++m_growth_left;
+            }
+            else {
+                set_control(index, CONTROL_DELETED);
+            }
+        }
+
+        template <typename Traits, typename H, typename E>
+        void FlatHashTable<Traits, H, E>::resize(std::size_t capacity) {
+            // Control bytes and slots share one allocation
+            std::size_t alignment = std::max(alignof(value_type), alignof(std::max_align_t));
+            std::size_t control_size = (capacity + Group::WIDTH + alignment - 1) / alignment * alignment;
+            std::size_t allocation_size = control_size + capacity * sizeof(value_type);
+
+            std::byte* storage = static_cast<std::byte*>(::operator new(allocation_size, std::align_val_t(alignment)));
+            ControlByte* control = reinterpret_cast<ControlByte*>(storage);
+            value_type* slots = reinterpret_cast<value_type*>(storage + control_size);
+            std::memset(control, CONTROL_EMPTY, capacity + Group::WIDTH);
+
+            ControlByte* old_control = m_control;
+            value_type* old_slots = m_slots;
+            std::size_t old_capacity = m_capacity;
+
+            m_control = control;
+            m_slots = slots;
+            m_capacity = capacity;
+
+            for (std::size_t i = 0; i < old_capacity; ++i) {
+                if (old_control[i] < 0) {
+                    continue;
+                }
+
+                std::size_t h = hash(Traits::key(old_slots[i]));
+                std::size_t index = find_first_non_full(h);
+                set_control(index, static_cast<ControlByte>(h2(h)));
+
+                // Elements are moved with a single memcpy where possible
+                relocate(m_slots + index, old_slots + i);
+            }
+
+            m_growth_left = growth_limit(m_capacity) - m_size;
+
+            if (old_control) {
+                ::operator delete(old_control, std::align_val_t(alignment));
+            }
+        }
+
+        template <typename Traits, typename H, typename E>
+        void FlatHashTable<Traits, H, E>::rehash_and_grow() {
+            if (m_size <= growth_limit(m_capacity) / 2) {
+                // Most of the growth was consumed by tombstones, rehashing in place reclaims them without growing
+                resize(m_capacity);
+            }
+            else {
+                resize(m_capacity * 2);
+            }
+        }
+
+        template <typename Traits, typename H, typename E>
+        void FlatHashTable<Traits, H, E>::destroy() {
+            if (!m_control) {
+                return;
+            }
+
+            if constexpr (!std::is_trivially_destructible<value_type>::value) {
+                for (std::size_t i = 0; i < m_capacity; ++i) {
+                    if (m_control[i] >= 0) {
+                        m_slots[i].~value_type();
+                    }
+                }
+            }
+
+            ::operator delete(m_control, std::align_val_t(std::max(alignof(value_type), alignof(std::max_align_t))));
+
+            m_control = nullptr;
+            m_slots = nullptr;
+            m_capacity = 0;
+            m_size = 0;
+            m_growth_left = 0;
+        }
+
+        template <typename K, typename V>
+        const K& FlatHashMapTraits<K, V>::key(const value_type& value) {
+            return value.first;
+        }
+
+        template <typename K>
+        const K& FlatHashSetTraits<K>::key(const value_type& value) {
+            return value;
+        }
+
+    }
+
+    // FlatHashMap implementation
+
+    template <typename K, typename V, typename H, typename E>
+    V& FlatHashMap<K, V, H, E>::operator[](const K& key) {
+        return try_emplace(key).first->second;
+    }
+
+    template <typename K, typename V, typename H, typename E>
+    V& FlatHashMap<K, V, H, E>::operator[](K&& key) {
+        return try_emplace(std::move(key)).first->second;
+    }
+
+    template <typename K, typename V, typename H, typename E>
+    template <typename Q>
+    V& FlatHashMap<K, V, H, E>::at(const Q& key) {
+        iterator it = this->find(key);
+        if (it == this->end()) {
+            throw std::out_of_range("key not found in FlatHashMap");
+        }
+        return it->second;
+    }
+
+    template <typename K, typename V, typename H, typename E>
+    template <typename Q>
+    const V& FlatHashMap<K, V, H, E>::at(const Q& key) const {
+        const_iterator it = this->find(key);
+        if (it == this->end()) {
+            throw std::out_of_range("key not found in FlatHashMap");
+        }
+        return it->second;
+    }
+
+    template <typename K, typename V, typename H, typename E>
+    template <typename ...Ts>
+    std::pair<typename FlatHashMap<K, V, H, E>::iterator, bool> FlatHashMap<K, V, H, E>::try_emplace(const K& key, Ts&&... args) {
+        std::size_t h = this->hash(key);
+
+        auto [index, found] = this->find_or_prepare_insert(key, h);
+        if (!found) {
+            new (this->m_slots + index) typename Base::value_type(std::piecewise_construct, std::forward_as_tuple(key), std::forward_as_tuple(std::forward<Ts>(args)...));
+            this->commit_insert(index, h);
+        }
+
+        return { iterator(this, index), !found };
+    }
+
+    template <typename K, typename V, typename H, typename E>
+    template <typename ...Ts>
+    std::pair<typename FlatHashMap<K, V, H, E>::iterator, bool> FlatHashMap<K, V, H, E>::try_emplace(K&& key, Ts&&... args) {
+        std::size_t h = this->hash(key);
+
+        auto [index, found] = this->find_or_prepare_insert(key, h);
+        if (!found) {
+            new (this->m_slots + index) typename Base::value_type(std::piecewise_construct, std::forward_as_tuple(std::move(key)), std::forward_as_tuple(std::forward<Ts>(args)...));
+            this->commit_insert(index, h);
+        }
+
+        return { iterator(this, index), !found };
+    }
+
+}
+
+#endif // UTILS_FLAT_HASH_MAP_TPP
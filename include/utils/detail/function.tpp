@@ -0,0 +1,164 @@
+
+#ifndef UTILS_FUNCTION_TPP
+#define UTILS_FUNCTION_TPP
+
+#include <cstring> // std::memcpy
+#include <functional> // std::bad_function_call, std::invoke
+#include <utility> // std::forward
+
+namespace utils::detail {
+
+    template <typename R, typename ...Args, std::size_t Capacity, bool Copyable>
+    InplaceFunction<R(Args...), Capacity, Copyable>::InplaceFunction() : m_invoke(nullptr),
+                                                                         m_destructor(nullptr),
+                                                                         m_relocate(nullptr),
+                                                                         m_copy_constructor(nullptr) {
+    }
+
+    template <typename R, typename ...Args, std::size_t Capacity, bool Copyable>
+    InplaceFunction<R(Args...), Capacity, Copyable>::InplaceFunction(std::nullptr_t) : InplaceFunction() {
+    }
+
+    template <typename R, typename ...Args, std::size_t Capacity, bool Copyable>
+    template <typename Fn> requires (!std::is_same<std::decay_t<Fn>, InplaceFunction<R(Args...), Capacity, Copyable>>::value && std::is_invocable_r<R, std::decay_t<Fn>&, Args...>::value)
+    InplaceFunction<R(Args...), Capacity, Copyable>::InplaceFunction(Fn&& fn) : InplaceFunction() {
+        using T = std::decay_t<Fn>;
+
+        static_assert(sizeof(T) <= Capacity, "callable does not fit in the inline storage of InplaceFunction, increase its capacity");
+        static_assert(alignof(T) <= alignof(std::max_align_t), "callable is over-aligned for the inline storage of InplaceFunction");
+        static_assert(!Copyable || std::is_copy_constructible<T>::value, "callable is not copy constructible, use MoveOnlyInplaceFunction instead");
+
+        // Moving the function relocates the callable, and is noexcept
+        static_assert(std::is_nothrow_move_constructible<T>::value || is_trivially_relocatable<T>::value, "callable must be nothrow move constructible to be stored in InplaceFunction");
+
+        if constexpr (std::is_pointer<std::remove_reference_t<Fn>>::value || std::is_member_pointer<T>::value) {
+            if (!fn) {
+                // Empty function pointer results in an empty function (same as std::function)
+                return;
+            }
+        }
+
+        new (m_storage) T(std::forward<Fn>(fn));
+
+        m_invoke = +[](void* fn, Args&&... args) -> R {
+            return std::invoke(*static_cast<T*>(fn), std::forward<Args>(args)...);
+        };
+
+        if constexpr (!std::is_trivially_destructible<T>::value) {
+            m_destructor = get_destructor<T>();
+        }
+
+        // Callables that opt into is_trivially_relocatable are moved with memcpy even if they are not trivially copyable
+        m_relocate = get_relocator<T>();
+
+        if constexpr (Copyable && !std::is_trivially_copyable<T>::value) {
+            m_copy_constructor = get_copy_constructor<T>();
+        }
+    }
+
+    template <typename R, typename ...Args, std::size_t Capacity, bool Copyable>
+    InplaceFunction<R(Args...), Capacity, Copyable>::~InplaceFunction() {
+        clear();
+    }
+
+    template <typename R, typename ...Args, std::size_t Capacity, bool Copyable>
+    InplaceFunction<R(Args...), Capacity, Copyable>::InplaceFunction(const InplaceFunction& other) requires (Copyable) : m_invoke(other.m_invoke),
+                                                                                                                      m_destructor(other.m_destructor),
+                                                                                                                      m_relocate(other.m_relocate),
+                                                                                                                      m_copy_constructor(other.m_copy_constructor) {
+        if (!m_invoke) {
+            return;
+        }
+
+        if (m_copy_constructor) {
+            m_copy_constructor(m_storage, other.m_storage);
+        }
+        else {
+            std::memcpy(m_storage, other.m_storage, Capacity);
+        }
+    }
+
+    template <typename R, typename ...Args, std::size_t Capacity, bool Copyable>
+    InplaceFunction<R(Args...), Capacity, Copyable>& InplaceFunction<R(Args...), Capacity, Copyable>::operator=(const InplaceFunction& other) requires (Copyable) {
+        if (this == &other) {
+            return *this;
+        }
+
+        // Copy first so that a throwing copy constructor leaves this function untouched
+        InplaceFunction copy(other);
+        *this = std::move(copy);
+
+        return *this;
+    }
+
+    template <typename R, typename ...Args, std::size_t Capacity, bool Copyable>
+    InplaceFunction<R(Args...), Capacity, Copyable>::InplaceFunction(InplaceFunction&& other) noexcept : InplaceFunction() {
+        relocate_from(other);
+    }
+
+    template <typename R, typename ...Args, std::size_t Capacity, bool Copyable>
+    InplaceFunction<R(Args...), Capacity, Copyable>& InplaceFunction<R(Args...), Capacity, Copyable>::operator=(InplaceFunction&& other) noexcept {
+        if (this == &other) {
+            return *this;
+        }
+
+        clear();
+        relocate_from(other);
+
+        return *this;
+    }
+
+    template <typename R, typename ...Args, std::size_t Capacity, bool Copyable>
+    R InplaceFunction<R(Args...), Capacity, Copyable>::operator()(Args... args) const {
+        if (!m_invoke) {
+            throw std::bad_function_call();
+        }
+
+        return m_invoke(m_storage, std::forward<Args>(args)...);
+    }
+
+    template <typename R, typename ...Args, std::size_t Capacity, bool Copyable>
+    InplaceFunction<R(Args...), Capacity, Copyable>::operator bool() const {
+        return m_invoke != nullptr;
+    }
+
+    template <typename R, typename ...Args, std::size_t Capacity, bool Copyable>
+    void InplaceFunction<R(Args...), Capacity, Copyable>::clear() {
+        if (m_invoke && m_destructor) {
+            m_destructor(m_storage);
+        }
+
+        m_invoke = nullptr;
+        m_destructor = nullptr;
+        m_relocate = nullptr;
+        m_copy_constructor = nullptr;
+    }
+
+    template <typename R, typename ...Args, std::size_t Capacity, bool Copyable>
+    void InplaceFunction<R(Args...), Capacity, Copyable>::relocate_from(InplaceFunction& other) {
+        if (!other.m_invoke) {
+            return;
+        }
+
+        if (other.m_relocate) {
+            other.m_relocate(m_storage, other.m_storage);
+        }
+        else {
+            std::memcpy(m_storage, other.m_storage, Capacity);
+        }
+
+        m_invoke = other.m_invoke;
+        m_destructor = other.m_destructor;
+        m_relocate = other.m_relocate;
+        m_copy_constructor = other.m_copy_constructor;
+
+        // The callable in 'other' was relocated (and is considered destroyed), so only its bookkeeping is cleared
+        other.m_invoke = nullptr;
+        other.m_destructor = nullptr;
+        other.m_relocate = nullptr;
+        other.m_copy_constructor = nullptr;
+    }
+
+}
+
+#endif // UTILS_FUNCTION_TPP
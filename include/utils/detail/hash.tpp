@@ -3,6 +3,12 @@
 #define UTILS_HASH_TPP
 
 #include <string_view> // std::string_view
+#include <algorithm> // std::copy_n, std::min
+#include <bit> // std::endian
+#include <cstring> // std::memcpy, std::strlen
+#include <type_traits> // std::is_constant_evaluated, std::has_unique_object_representations
+#include <memory> // std::addressof
+#include <ranges> // std::ranges::contiguous_range
 
 namespace std {
 
@@ -11,12 +17,7 @@ namespace std {
     template <typename R, typename C>
     struct hash<R C::*> {
         std::size_t operator()(R C::* const& ptr) const noexcept {
-            std::size_t result = 0;
-            const unsigned char* bytes = reinterpret_cast<const unsigned char*>(&ptr);
-            for (std::size_t i = 0; i < sizeof(ptr); ++i) {
-                utils::hash_combine(result, bytes[i]);
-            }
-            return result;
+            return static_cast<std::size_t>(utils::hash_bytes(&ptr, sizeof(ptr)));
         }
     };
 
@@ -29,7 +30,7 @@ namespace utils {
         std::size_t hash;
         
         if constexpr (std::is_same<typename std::decay<T>::type, char*>::value) {
-            hash = std::hash<std::string_view>{}(value, strlen(value));
+            hash = static_cast<std::size_t>(hash64(std::string_view(value, std::strlen(value))));
         }
         else {
             hash = std::hash<T>{}(value);
@@ -39,6 +40,293 @@ namespace utils {
         seed ^= hash + 0x9e3779b9 + (seed << 6) + (seed >> 2);
     }
 
+    namespace detail {
+
+        inline constexpr std::uint64_t hash64_secret[4] = { 0xa0761d6478bd642full, 0xe7037ed1a0b428dbull, 0x8ebc6af09c88c6e3ull, 0x589965cc75374cc3ull };
+
+        // 64x64 -> 128-bit multiply, 'a' receives the low and 'b' the high half of the product
+        constexpr void hash64_multiply(std::uint64_t& a, std::uint64_t& b) {
+            #if defined(__SIZEOF_INT128__)
+                __uint128_t product = static_cast<__uint128_t>(a) * b;
+                a = static_cast<std::uint64_t>(product);
+                b = static_cast<std::uint64_t>(product >> 64);
+            #else
+                std::uint64_t ha = a >> 32, hb = b >> 32, la = static_cast<std::uint32_t>(a), lb = static_cast<std::uint32_t>(b);
+                std::uint64_t rh = ha * hb, rm0 = ha * lb, rm1 = hb * la, rl = la * lb;
+                std::uint64_t t = rl + (rm0 << 32);
+                std::uint64_t carry = t < rl;
+                std::uint64_t lo = t + (rm1 << 32);
+                carry += lo < t;
+                a = lo;
+                b = rh + (rm0 >> 32) + (rm1 >> 32) + carry;
+            #endif
+        }
+
+        constexpr std::uint64_t hash64_mix(std::uint64_t a, std::uint64_t b) {
+            hash64_multiply(a, b);
+            return a ^ b;
+        }
+
+        // Little-endian loads, byte-wise during constant evaluation so that compile-time and runtime results match
+        constexpr std::uint64_t hash64_read(const char* data, std::size_t size) {
+            if (std::is_constant_evaluated() || std::endian::native != std::endian::little) {
+                std::uint64_t value = 0;
+                for (std::size_t i = 0; i < size; ++i) {
+                    value |= static_cast<std::uint64_t>(static_cast<unsigned char>(data[i])) << (8 * i);
+                }
+                return value;
+            }
+
+            std::uint64_t value = 0;
+            std::memcpy(&value, data, size);
+            return value;
+        }
+
+        constexpr std::uint64_t hash64_read64(const char* data) {
+            return hash64_read(data, 8);
+        }
+
+        constexpr std::uint64_t hash64_read32(const char* data) {
+            return hash64_read(data, 4);
+        }
+
+        // Inputs of 1 to 3 bytes
+        constexpr std::uint64_t hash64_read3(const char* data, std::size_t length) {
+            return (static_cast<std::uint64_t>(static_cast<unsigned char>(data[0])) << 16) |
+                   (static_cast<std::uint64_t>(static_cast<unsigned char>(data[length >> 1])) << 8) |
+                   static_cast<std::uint64_t>(static_cast<unsigned char>(data[length - 1]));
+        }
+
+        constexpr std::uint64_t hash64_seed(std::uint64_t seed) {
+            return seed ^ hash64_mix(seed ^ hash64_secret[0], hash64_secret[1]);
+        }
+
+        // Consumes one 48-byte stripe across three independent multiply chains
+        constexpr void hash64_stripe(const char* data, std::uint64_t& seed, std::uint64_t& lane1, std::uint64_t& lane2) {
+            seed = hash64_mix(hash64_read64(data) ^ hash64_secret[1], hash64_read64(data + 8) ^ seed);
+            lane1 = hash64_mix(hash64_read64(data + 16) ^ hash64_secret[2], hash64_read64(data + 24) ^ lane1);
+            lane2 = hash64_mix(hash64_read64(data + 32) ^ hash64_secret[3], hash64_read64(data + 40) ^ lane2);
+        }
+
+        constexpr std::uint64_t hash64_finalize(std::uint64_t a, std::uint64_t b, std::uint64_t seed, std::uint64_t length) {
+            a ^= hash64_secret[1];
+            b ^= seed;
+            hash64_multiply(a, b);
+            return hash64_mix(a ^ hash64_secret[0] ^ length, b ^ hash64_secret[1]);
+        }
+
+        // Inputs of at most 16 bytes
+        constexpr std::uint64_t hash64_short(const char* data, std::size_t length, std::uint64_t seed) {
+            std::uint64_t a = 0;
+            std::uint64_t b = 0;
+
+            if (length >= 4) {
+                std::size_t offset = (length >> 3) << 2;
+                a = (hash64_read32(data) << 32) | hash64_read32(data + offset);
+                b = (hash64_read32(data + length - 4) << 32) | hash64_read32(data + length - 4 - offset);
+            }
+            else if (length > 0) {
+                a = hash64_read3(data, length);
+            }
+
+            return hash64_finalize(a, b, seed, length);
+        }
+
+        // Consumes the final 'remaining' (1 to 48) bytes of an input longer than 16 bytes
+        // The final reads may reach up to 16 bytes before 'data', which must still be valid
+        constexpr std::uint64_t hash64_tail(const char* data, std::size_t remaining, std::uint64_t seed, std::uint64_t length) {
+            while (remaining > 16) {
+                seed = hash64_mix(hash64_read64(data) ^ hash64_secret[1], hash64_read64(data + 8) ^ seed);
+                data += 16;
+                remaining -= 16;
+            }
+
+            return hash64_finalize(hash64_read64(data + remaining - 16), hash64_read64(data + remaining - 8), seed, length);
+        }
+
+        // Types that can be hashed through their object representation: equal values always have identical bytes, and there are no padding bits
+        // Restricted to scalars, as class types may define an equality that does not compare bytes (std::type_index compares names, for example)
+        template <typename T>
+        struct is_bitwise_hashable : std::bool_constant<std::is_scalar<T>::value && std::has_unique_object_representations<T>::value> { };
+
+        // Member pointers do not contain padding
+        template <typename R, typename C>
+        struct is_bitwise_hashable<R C::*> : std::true_type { };
+
+        // std::pair / std::tuple are never trivially copyable, but are bitwise hashable if all elements are and are packed without padding
+        template <typename T, typename U>
+        struct is_bitwise_hashable<std::pair<T, U>> : std::bool_constant<is_bitwise_hashable<T>::value && is_bitwise_hashable<U>::value && sizeof(std::pair<T, U>) == sizeof(T) + sizeof(U)> { };
+
+        template <typename ...Ts>
+        struct is_bitwise_hashable<std::tuple<Ts...>> : std::bool_constant<sizeof...(Ts) != 0 && (is_bitwise_hashable<Ts>::value && ...) && sizeof(std::tuple<Ts...>) == (sizeof(Ts) + ... + 0)> { };
+
+        // Contiguous ranges of bitwise hashable elements (std::vector<int>, std::array<std::uint64_t, N>, ...) can be hashed as a single block
+        template <typename T>
+        struct is_bitwise_hashable_range : std::false_type { };
+
+        template <std::ranges::contiguous_range T>
+        struct is_bitwise_hashable_range<T> : is_bitwise_hashable<std::ranges::range_value_t<T>> { };
+
+    }
+
+    inline std::uint64_t hash_bytes(const void* data, std::size_t length, std::uint64_t seed) {
+        return hash64(std::string_view(static_cast<const char*>(data), length), seed);
+    }
+
+    template <typename T>
+    std::size_t Hash<T>::operator()(const T& value) const {
+        if constexpr (std::is_convertible<const T&, std::string_view>::value) {
+            return static_cast<std::size_t>(hash64(std::string_view(value)));
+        }
+        else if constexpr (detail::is_bitwise_hashable<T>::value) {
+            return static_cast<std::size_t>(hash_bytes(std::addressof(value), sizeof(T)));
+        }
+        else if constexpr (detail::is_bitwise_hashable_range<const T>::value) {
+            return static_cast<std::size_t>(hash_bytes(std::ranges::data(value), std::ranges::size(value) * sizeof(std::ranges::range_value_t<const T>)));
+        }
+        else if constexpr (std::ranges::range<const T>) {
+            Hasher64 hasher { };
+            for (const auto& element : value) {
+                std::uint64_t hash = Hash<std::remove_cvref_t<decltype(element)>> { }(element);
+                hasher.update(std::string_view(reinterpret_cast<const char*>(&hash), sizeof(hash)));
+            }
+            return static_cast<std::size_t>(hasher.digest());
+        }
+        else {
+            return std::hash<T> { }(value);
+        }
+    }
+
+    inline std::size_t Hash<std::string>::operator()(std::string_view value) const {
+        return static_cast<std::size_t>(hash64(value));
+    }
+
+    inline std::size_t Hash<std::string_view>::operator()(std::string_view value) const {
+        return static_cast<std::size_t>(hash64(value));
+    }
+
+    template <typename T, typename U>
+    std::size_t Hash<std::pair<T, U>>::operator()(const std::pair<T, U>& value) const {
+        if constexpr (detail::is_bitwise_hashable<std::pair<T, U>>::value) {
+            return static_cast<std::size_t>(hash_bytes(std::addressof(value), sizeof(value)));
+        }
+        else {
+            return hash_values(value.first, value.second);
+        }
+    }
+
+    template <typename ...Ts>
+    std::size_t Hash<std::tuple<Ts...>>::operator()(const std::tuple<Ts...>& value) const {
+        if constexpr (detail::is_bitwise_hashable<std::tuple<Ts...>>::value) {
+            return static_cast<std::size_t>(hash_bytes(std::addressof(value), sizeof(value)));
+        }
+        else {
+            return std::apply([](const auto&... elements) -> std::size_t {
+                return hash_values(elements...);
+            }, value);
+        }
+    }
+
+    template <typename ...Ts>
+    std::size_t hash_values(const Ts&... values) {
+        if constexpr (sizeof...(Ts) == 0) {
+            return static_cast<std::size_t>(hash64({ }));
+        }
+        else if constexpr ((detail::is_bitwise_hashable<Ts>::value && ...)) {
+            // Pack the object representations back to back and hash them in one pass
+            char buffer[(sizeof(Ts) + ...)];
+            std::size_t offset = 0;
+            ((std::memcpy(buffer + offset, std::addressof(values), sizeof(Ts)), offset += sizeof(Ts)), ...);
+            return static_cast<std::size_t>(hash_bytes(buffer, sizeof(buffer)));
+        }
+        else {
+            // Hash each value individually, then hash the resulting block of hashes
+            std::uint64_t hashes[] = { static_cast<std::uint64_t>(Hash<Ts> { }(values))... };
+            return static_cast<std::size_t>(hash_bytes(hashes, sizeof(hashes)));
+        }
+    }
+
+    constexpr std::uint64_t hash64(std::string_view data, std::uint64_t seed) {
+        const char* p = data.data();
+        std::size_t length = data.length();
+
+        seed = detail::hash64_seed(seed);
+
+        if (length <= 16) {
+            return detail::hash64_short(p, length, seed);
+        }
+
+        std::size_t remaining = length;
+        if (remaining > 48) {
+            std::uint64_t lane1 = seed;
+            std::uint64_t lane2 = seed;
+
+            do {
+                detail::hash64_stripe(p, seed, lane1, lane2);
+                p += 48;
+                remaining -= 48;
+            }
+            while (remaining > 48);
+
+            seed ^= lane1 ^ lane2;
+        }
+
+        return detail::hash64_tail(p, remaining, seed, length);
+    }
+
+    constexpr Hasher64::Hasher64(std::uint64_t seed) : m_seed(detail::hash64_seed(seed)),
+                                                       m_lanes { m_seed, m_seed },
+                                                       m_length(0),
+                                                       m_buffer(),
+                                                       m_buffered(0) {
+    }
+
+    constexpr Hasher64& Hasher64::update(std::string_view data) {
+        m_length += data.length();
+
+        while (!data.empty()) {
+            if (m_buffered == STRIPE_SIZE) {
+                // A full stripe is only consumed once more input follows it, as the final (up to 48) bytes are always handled by digest()
+                detail::hash64_stripe(m_buffer + TAIL_SIZE, m_seed, m_lanes[0], m_lanes[1]);
+                std::copy_n(m_buffer + STRIPE_SIZE, TAIL_SIZE, m_buffer);
+                m_buffered = 0;
+            }
+
+            if (m_buffered == 0 && data.length() > STRIPE_SIZE) {
+                // Consume stripes directly from the input without copying
+                do {
+                    detail::hash64_stripe(data.data(), m_seed, m_lanes[0], m_lanes[1]);
+                    data.remove_prefix(STRIPE_SIZE);
+                }
+                while (data.length() > STRIPE_SIZE);
+
+                std::copy_n(data.data() - TAIL_SIZE, TAIL_SIZE, m_buffer);
+            }
+
+            std::size_t count = std::min(STRIPE_SIZE - m_buffered, data.length());
+            std::copy_n(data.data(), count, m_buffer + TAIL_SIZE + m_buffered);
+            m_buffered += count;
+            data.remove_prefix(count);
+        }
+
+        return *this;
+    }
+
+    constexpr std::uint64_t Hasher64::digest() const {
+        const char* pending = m_buffer + TAIL_SIZE;
+
+        if (m_length <= 16) {
+            return detail::hash64_short(pending, m_buffered, m_seed);
+        }
+
+        std::uint64_t seed = m_seed;
+        if (m_length > STRIPE_SIZE) {
+            seed ^= m_lanes[0] ^ m_lanes[1];
+        }
+
+        return detail::hash64_tail(pending, m_buffered, seed, m_length);
+    }
+
 }
 
 #endif  // UTILS_HASH_TPP
@@ -4,6 +4,18 @@
 #define UTILS_LOGGING_TPP
 
 #include <spdlog/spdlog.h>
+#include <spdlog/details/os.h>
+#include <algorithm> // std::max
+#include <array> // std::array
+#include <bit> // std::countr_zero
+#include <chrono> // std::chrono::steady_clock
+#include <cstdint> // std::int64_t, std::uint8_t, std::uint32_t, std::uint64_t
+#include <cstring> // std::memcpy
+#include <new> // std::launder
+#include <ranges> // std::ranges::range
+#include <source_location> // std::source_location
+#include <span> // std::span
+#include <tuple> // std::tuple, std::apply
 
 namespace utils::logging {
 
@@ -11,38 +23,518 @@ namespace utils::logging {
 
         spdlog::logger& logger();
 
+        extern std::atomic<int> runtime_level;
+
+        [[nodiscard]] inline bool enabled(Level level) {
+            return static_cast<int>(level) >= runtime_level.load(std::memory_order_relaxed);
+        }
+
+        struct Record;
+
+        // Types of encoded arguments, as recorded in binary logs so that they can be decoded without the program that wrote them
+        enum class ArgumentType : std::uint8_t {
+            Opaque = 0, // Can only be decoded by this program
+            Bool,
+            Char,
+            Int8,
+            Int16,
+            Int32,
+            Int64,
+            UInt8,
+            UInt16,
+            UInt32,
+            UInt64,
+            Float,
+            Double,
+            LongDouble,
+            String,
+            Pointer,
+            Named // Followed by the type of the value
+        };
+
+        // Describes the arguments of records logged with the same argument types
+        struct RecordSignature {
+            // Decodes the arguments and formats the message into 'buffer'
+            void (*format)(const Record& record, fmt::memory_buffer& buffer);
+            std::span<const ArgumentType> types;
+        };
+
+        // Message queued for the background thread, followed by its encoded arguments and (if it is not a literal) the characters of its format string
+        struct Record {
+            const RecordSignature* signature; // nullptr if 'message' holds the formatted message
+            spdlog::log_clock::time_point time;
+            std::size_t thread;
+            std::source_location source;
+            std::string_view message; // Format string
+            spdlog::level::level_enum level;
+            std::uint32_t arguments; // Size of the encoded arguments
+            bool literal; // Format string was validated at compile time (and refers to the literal, rather than to the storage following the record)
+        };
+
+        [[nodiscard]] bool async_enabled();
+
+        // Messages are written to a binary log, which only admits arguments of types other than ArgumentType::Opaque
+        [[nodiscard]] bool binary_enabled();
+
+        // Returns storage for a record of 'size' bytes in the buffer of the calling thread, which is published by commit_record()
+        // Returns nullptr if the record was dropped ('dropped' is set), or cannot be queued and must be written by the calling thread (asynchronous logging is
+        // disabled, or the record is larger than the buffer allows)
+        [[nodiscard]] std::byte* reserve_record(std::size_t size, bool& dropped);
+        void commit_record();
+
+        template <typename T>
+        struct is_string_argument {
+            static constexpr bool value = std::is_same<T, std::string>::value || std::is_same<T, std::string_view>::value ||
+                                          std::is_same<std::decay_t<T>, const char*>::value || std::is_same<std::decay_t<T>, char*>::value;
+        };
+
+        // Arguments that can be copied into a record and formatted later
+        // Pointers (which fmt formats as addresses) are only deferred if they do not point to characters, and ranges are never deferred, as views refer to
+        // elements that are not copied
+        template <typename T>
+        consteval bool is_deferred_argument() {
+            if constexpr (is_named_argument<T>::value) {
+                return is_deferred_argument<std::remove_cvref_t<typename T::type>>();
+            }
+            else if constexpr (is_string_argument<T>::value) {
+                return true;
+            }
+            else if constexpr (std::is_pointer<T>::value) {
+                return std::is_void<std::remove_pointer_t<T>>::value;
+            }
+            else {
+                return std::is_trivially_copyable<T>::value && !std::ranges::range<T>;
+            }
+        }
+
+        template <typename T>
+        consteval ArgumentType argument_type() {
+            if constexpr (is_named_argument<T>::value) {
+                return argument_type<std::remove_cvref_t<typename T::type>>() == ArgumentType::Opaque ? ArgumentType::Opaque : ArgumentType::Named;
+            }
+            else if constexpr (is_string_argument<T>::value) {
+                return ArgumentType::String;
+            }
+            else if constexpr (std::is_same<T, bool>::value) {
+                return ArgumentType::Bool;
+            }
+            else if constexpr (std::is_same<T, char>::value) {
+                return ArgumentType::Char;
+            }
+            else if constexpr (std::is_integral<T>::value && sizeof(T) <= 8u) {
+                // Other character types (including signed / unsigned char) are formatted as integers
+                constexpr ArgumentType types[2][4] = { { ArgumentType::UInt8, ArgumentType::UInt16, ArgumentType::UInt32, ArgumentType::UInt64 },
+                                                       { ArgumentType::Int8, ArgumentType::Int16, ArgumentType::Int32, ArgumentType::Int64 } };
+                return types[std::is_signed<T>::value][std::countr_zero(sizeof(T))];
+            }
+            else if constexpr (std::is_same<T, float>::value) {
+                return ArgumentType::Float;
+            }
+            else if constexpr (std::is_same<T, double>::value) {
+                return ArgumentType::Double;
+            }
+            else if constexpr (std::is_same<T, long double>::value) {
+                return ArgumentType::LongDouble;
+            }
+            else if constexpr (std::is_pointer<T>::value && std::is_void<std::remove_pointer_t<T>>::value) {
+                return ArgumentType::Pointer;
+            }
+            else {
+                return ArgumentType::Opaque;
+            }
+        }
+
+        // Argument types in order, named arguments are followed by the type of their value
+        template <typename ...Ts>
+        consteval auto argument_types() {
+            constexpr std::size_t count = ((is_named_argument<Ts>::value ? 2u : 1u) + ... + 0u);
+            std::array<ArgumentType, count> types { };
+
+            std::size_t i = 0u;
+            [[maybe_unused]] auto append = [&]<typename T>() {
+                types[i++] = argument_type<T>();
+                if constexpr (is_named_argument<T>::value) {
+                    types[i++] = argument_type<std::remove_cvref_t<typename T::type>>();
+                }
+            };
+            (append.template operator()<Ts>(), ...);
+
+            return types;
+        }
+
+        // Arguments are decoded as the type they were passed as, strings as views into the record
+        template <typename T>
+        struct DecodedArgument {
+            using type = T;
+        };
+
+        template <typename T> requires is_string_argument<T>::value
+        struct DecodedArgument<T> {
+            using type = std::string_view;
+        };
+
+        template <typename T>
+        struct DecodedNamedArgument {
+            std::string_view name;
+            T value;
+        };
+
+        template <typename T>
+        struct DecodedArgument<NamedArgument<T>> {
+            using type = DecodedNamedArgument<typename DecodedArgument<std::remove_cvref_t<T>>::type>;
+        };
+
+        template <typename T>
+        std::size_t encoded_size(const T& value) {
+            if constexpr (is_named_argument<T>::value) {
+                return sizeof(std::uint32_t) + value.name.length() + 1u + encoded_size(value.value);
+            }
+            else if constexpr (is_string_argument<T>::value) {
+                return sizeof(std::uint32_t) + std::string_view(value).length();
+            }
+            else {
+                return sizeof(T);
+            }
+        }
+
+        inline std::byte* encode_string(std::byte* out, std::string_view value) {
+            std::uint32_t length = static_cast<std::uint32_t>(value.length());
+            std::memcpy(out, &length, sizeof(length));
+            std::memcpy(out + sizeof(length), value.data(), length);
+            return out + sizeof(length) + length;
+        }
+
+        template <typename T>
+        std::byte* encode(std::byte* out, const T& value) {
+            if constexpr (is_named_argument<T>::value) {
+                // fmt looks up arguments by name as null-terminated strings
+                out = encode_string(out, value.name);
+                *out++ = std::byte { 0 };
+                return encode(out, value.value);
+            }
+            else if constexpr (is_string_argument<T>::value) {
+                return encode_string(out, std::string_view(value));
+            }
+            else {
+                std::memcpy(out, &value, sizeof(T));
+                return out + sizeof(T);
+            }
+        }
+
+        inline std::string_view decode_string(const std::byte*& in) {
+            std::uint32_t length;
+            std::memcpy(&length, in, sizeof(length));
+
+            std::string_view value(reinterpret_cast<const char*>(in + sizeof(length)), length);
+            in += sizeof(length) + length;
+            return value;
+        }
+
+        template <typename T>
+        typename DecodedArgument<T>::type decode(const std::byte*& in) {
+            if constexpr (is_named_argument<T>::value) {
+                std::string_view name = decode_string(in);
+                ++in; // Null terminator
+                return { name, decode<std::remove_cvref_t<typename T::type>>(in) };
+            }
+            else if constexpr (is_string_argument<T>::value) {
+                return decode_string(in);
+            }
+            else {
+                // Records are only aligned to 8 bytes, and arguments not at all
+                alignas(T) std::byte storage[sizeof(T)];
+                std::memcpy(storage, in, sizeof(T));
+                in += sizeof(T);
+                return *std::launder(reinterpret_cast<T*>(storage));
+            }
+        }
+
+        template <typename T>
+        const T& as_argument(const T& value) {
+            return value;
+        }
+
+        template <typename T>
+        NamedArgument<T> as_argument(const DecodedNamedArgument<T>& value) {
+            return NamedArgument<T>(value.name, value.value);
+        }
+
+        template <typename ...Ts>
+        void format_record(const Record& record, fmt::memory_buffer& buffer) {
+            [[maybe_unused]] const std::byte* in = reinterpret_cast<const std::byte*>(&record + 1);
+
+            // Braced initialization decodes the arguments in order
+            std::tuple<typename DecodedArgument<Ts>::type...> arguments { decode<Ts>(in)... };
+
+            FormatString str(record.message, record.source);
+            str.literal = record.literal;
+
+            std::apply([&](const auto&... decoded) {
+                utils::detail::format_to(fmt::appender(buffer), str, as_argument(decoded)...);
+            }, arguments);
+        }
+
+        template <typename ...Ts>
+        inline constexpr std::array<ArgumentType, argument_types<Ts...>().size()> record_argument_types = argument_types<Ts...>();
+
+        template <typename ...Ts>
+        inline constexpr RecordSignature record_signature { &format_record<Ts...>, record_argument_types<Ts...> };
+
+        // Queues a message for the background thread, returns false if it must be written by the calling thread instead
+        template <typename ...Args>
+        bool enqueue(spdlog::level::level_enum level, const FormatString& fmt, const Args&... args) {
+            constexpr bool deferred = (is_deferred_argument<Args>() && ...);
+            constexpr bool portable = ((argument_type<Args>() != ArgumentType::Opaque) && ...);
+
+            // Messages with arguments that cannot be deferred (or written to a binary log) are formatted here, and queued as text
+            bool defer = portable || (deferred && !binary_enabled());
+
+            FormatBuffer<> formatted;
+            std::string_view message = fmt.format;
+            bool literal = fmt.literal;
+
+            if (!defer) {
+                message = utils::format_to(formatted, fmt, args...);
+                literal = false;
+            }
+
+            std::size_t arguments = 0u;
+            if constexpr (deferred) {
+                if (defer) {
+                    arguments = (encoded_size(args) + ... + 0u);
+                }
+            }
+
+            bool dropped = false;
+            std::byte* storage = reserve_record(sizeof(Record) + arguments + (literal ? 0u : message.length()), dropped);
+            if (!storage) {
+                return dropped;
+            }
+
+            Record* record = new (storage) Record { nullptr, spdlog::log_clock::now(), spdlog::details::os::thread_id(), fmt.source, message, level, static_cast<std::uint32_t>(arguments), literal };
+            std::byte* out = storage + sizeof(Record);
+
+            if constexpr (deferred) {
+                if (defer) {
+                    record->signature = &record_signature<Args...>;
+                    ((out = encode(out, args)), ...);
+                }
+            }
+
+            if (!literal) {
+                std::memcpy(out, message.data(), message.length());
+                record->message = std::string_view(reinterpret_cast<const char*>(out), message.length());
+            }
+
+            commit_record();
+            return true;
+        }
+
+        // Levels are checked by the caller (the logger itself accepts every level)
+        template <typename ...Args>
+        void log(spdlog::level::level_enum level, const FormatString& fmt, const Args&... args) {
+            if (async_enabled() && enqueue(level, fmt, args...)) {
+                return;
+            }
+
+            // Formatting the message here (rather than in spdlog) uses the cached parsed form of the format string
+            FormatBuffer<> buffer;
+            utils::format_to(buffer, fmt, args...);
+
+            spdlog::logger& logger = detail::logger();
+            logger.log(spdlog::source_loc(fmt.source.file_name(), static_cast<int>(fmt.source.line()), fmt.source.function_name()), level, spdlog::string_view_t(buffer.data(), buffer.size()));
+        }
+
+        // Attributed to the call site of the suppressed messages
+        inline void log_suppressed(spdlog::level::level_enum level, std::source_location source, std::size_t count) {
+            FormatString notice("suppressed {} message(s)");
+            notice.source = source;
+            log(level, notice, count);
+        }
+
+        // Logs a message admitted by 'limiter', preceded by the number of messages it suppressed since the last one (if any)
+        template <typename Limiter, typename ...Args>
+        void log_limited(Limiter& limiter, spdlog::level::level_enum level, const FormatString& fmt, const Args&... args) {
+            if (std::size_t suppressed = limiter.suppressed()) {
+                log_suppressed(level, fmt.source, suppressed);
+            }
+
+            log(level, fmt, args...);
+        }
+
+        // Registers the limiter of a call site for the lifetime of the site, so that the messages it suppressed are reported by report_suppressed() even if
+        // it admits no further message
+        class LimiterSite {
+            public:
+                template <typename Limiter>
+                LimiterSite(Limiter& limiter, spdlog::level::level_enum level, std::source_location source = std::source_location::current());
+                ~LimiterSite();
+
+                LimiterSite(const LimiterSite&) = delete;
+                LimiterSite& operator=(const LimiterSite&) = delete;
+
+                void* limiter;
+                std::size_t (*suppressed)(void* limiter);
+                spdlog::level::level_enum level;
+                std::source_location source;
+        };
+
+        void register_limiter_site(LimiterSite& site);
+        void unregister_limiter_site(LimiterSite& site);
+
+        // Logs the number of messages suppressed by each registered call site since it was last reported
+        // Called by flush(), and about once per second by the background thread while asynchronous logging is enabled
+        void report_suppressed();
+
+        template <typename Limiter>
+        LimiterSite::LimiterSite(Limiter& limiter, spdlog::level::level_enum level, std::source_location source) : limiter(&limiter),
+                                                                                                                    suppressed([](void* limiter) -> std::size_t {
+                                                                                                                        return static_cast<Limiter*>(limiter)->suppressed();
+                                                                                                                    }),
+                                                                                                                    level(level),
+                                                                                                                    source(source) {
+            register_limiter_site(*this);
+        }
+
+    }
+
+    inline bool enabled(Level level) {
+        return detail::enabled(level);
+    }
+
+    inline bool Tag::enabled(Level level) const {
+        return static_cast<int>(level) >= m_level.load(std::memory_order_relaxed);
+    }
+
+    inline bool RateLimiter::admit() {
+        std::int64_t now = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+        std::int64_t next = m_next.load(std::memory_order_relaxed);
+
+        while (true) {
+            // Tokens that were not used while the bucket was full are not accumulated
+            std::int64_t available = std::max(next, now);
+            if (available - now > m_tolerance) {
+                m_suppressed.fetch_add(1u, std::memory_order_relaxed);
+                return false;
+            }
+
+            if (m_next.compare_exchange_weak(next, available + m_interval, std::memory_order_relaxed)) {
+                return true;
+            }
+        }
+    }
+
+    inline std::size_t RateLimiter::suppressed() {
+        return m_suppressed.exchange(0u, std::memory_order_relaxed);
+    }
+
+    inline bool Sampler::admit() {
+        return m_count.fetch_add(1u, std::memory_order_relaxed) % m_n == 0u;
+    }
+
+    inline std::size_t Sampler::suppressed() {
+        // Messages are numbered in the order they are counted, of which every n-th (starting with the first) is admitted
+        auto admitted = [this](std::uint64_t count) {
+            return (count + m_n - 1u) / m_n;
+        };
+
+        std::uint64_t count = m_count.load(std::memory_order_relaxed);
+        std::uint64_t reported = m_reported.load(std::memory_order_relaxed);
+        do {
+            if (count <= reported) {
+                // Already reported by another thread
+                return 0u;
+            }
+        } while (!m_reported.compare_exchange_weak(reported, count, std::memory_order_relaxed));
+
+        return static_cast<std::size_t>((count - reported) - (admitted(count) - admitted(reported)));
     }
 
     template <typename ...Args>
     void info(FormatString fmt, const Args&... args) {
-        spdlog::logger& logger = detail::logger();
-        logger.log(spdlog::source_loc(fmt.source.file_name(), static_cast<int>(fmt.source.line()), fmt.source.function_name()), spdlog::level::info, fmt::runtime(fmt.format), utils::detail::to_fmt_argument(args)...);
+        if constexpr (MINIMUM_LEVEL <= Level::Info) {
+            if (detail::enabled(Level::Info)) {
+                detail::log(spdlog::level::info, fmt, args...);
+            }
+        }
+    }
+
+    template <typename ...Args>
+    void info(const Tag& tag, FormatString fmt, const Args&... args) {
+        if constexpr (MINIMUM_LEVEL <= Level::Info) {
+            if (tag.enabled(Level::Info)) {
+                detail::log(spdlog::level::info, fmt, args...);
+            }
+        }
     }
 
     template <typename ...Args>
     void debug(FormatString fmt, const Args&... args) {
-        spdlog::logger& logger = detail::logger();
-        logger.log(spdlog::source_loc(fmt.source.file_name(), static_cast<int>(fmt.source.line()), fmt.source.function_name()), spdlog::level::debug, fmt::runtime(fmt.format), utils::detail::to_fmt_argument(args)...);
+        if constexpr (MINIMUM_LEVEL <= Level::Debug) {
+            if (detail::enabled(Level::Debug)) {
+                detail::log(spdlog::level::debug, fmt, args...);
+            }
+        }
+    }
+
+    template <typename ...Args>
+    void debug(const Tag& tag, FormatString fmt, const Args&... args) {
+        if constexpr (MINIMUM_LEVEL <= Level::Debug) {
+            if (tag.enabled(Level::Debug)) {
+                detail::log(spdlog::level::debug, fmt, args...);
+            }
+        }
     }
 
     template <typename ...Args>
     void warning(FormatString fmt, const Args&... args) {
-        spdlog::logger& logger = detail::logger();
-        logger.log(spdlog::source_loc(fmt.source.file_name(), static_cast<int>(fmt.source.line()), fmt.source.function_name()), spdlog::level::warn, fmt::runtime(fmt.format), utils::detail::to_fmt_argument(args)...);
+        if constexpr (MINIMUM_LEVEL <= Level::Warning) {
+            if (detail::enabled(Level::Warning)) {
+                detail::log(spdlog::level::warn, fmt, args...);
+            }
+        }
+    }
+
+    template <typename ...Args>
+    void warning(const Tag& tag, FormatString fmt, const Args&... args) {
+        if constexpr (MINIMUM_LEVEL <= Level::Warning) {
+            if (tag.enabled(Level::Warning)) {
+                detail::log(spdlog::level::warn, fmt, args...);
+            }
+        }
     }
 
     template <typename ...Args>
     void error(FormatString fmt, const Args&... args) {
-        spdlog::logger& logger = detail::logger();
-        logger.log(spdlog::source_loc(fmt.source.file_name(), static_cast<int>(fmt.source.line()), fmt.source.function_name()), spdlog::level::err, fmt::runtime(fmt.format), utils::detail::to_fmt_argument(args)...);
+        if constexpr (MINIMUM_LEVEL <= Level::Error) {
+            if (detail::enabled(Level::Error)) {
+                detail::log(spdlog::level::err, fmt, args...);
+            }
+        }
+    }
+
+    template <typename ...Args>
+    void error(const Tag& tag, FormatString fmt, const Args&... args) {
+        if constexpr (MINIMUM_LEVEL <= Level::Error) {
+            if (tag.enabled(Level::Error)) {
+                detail::log(spdlog::level::err, fmt, args...);
+            }
+        }
     }
 
     template <typename ...Args>
     [[noreturn]] void fatal(FormatString fmt, const Args&... args) {
-        std::string message = utils::format(fmt, utils::detail::to_fmt_argument(args)...);
+        FormatBuffer<> buffer;
+        utils::format_to(buffer, fmt, args...);
+
+        // Messages queued before this one are written first
+        logging::flush();
+
         spdlog::logger& logger = detail::logger();
-        logger.log(spdlog::source_loc(fmt.source.file_name(), static_cast<int>(fmt.source.line()), fmt.source.function_name()), spdlog::level::err, message);
-        throw std::runtime_error(message);
+        logger.log(spdlog::source_loc(fmt.source.file_name(), static_cast<int>(fmt.source.line()), fmt.source.function_name()), spdlog::level::err, spdlog::string_view_t(buffer.data(), buffer.size()));
+        logger.flush();
+
+        throw std::runtime_error(buffer.str());
     }
 
 }
@@ -1,6 +1,9 @@
 #ifndef UTILS_MEMORY_TPP
 #define UTILS_MEMORY_TPP
 
+#include <cstring> // std::memcpy
+#include <new> // placement new
+
 namespace utils {
     
     template <typename T>
@@ -24,6 +27,32 @@ namespace utils {
         };
     }
     
+    template <typename T>
+    void relocate(T* dst, T* src, std::size_t count) noexcept(is_trivially_relocatable<T>::value || std::is_nothrow_move_constructible<T>::value) {
+        if constexpr (is_trivially_relocatable<T>::value) {
+            std::memcpy(static_cast<void*>(dst), static_cast<const void*>(src), count * sizeof(T));
+        }
+        else {
+            for (std::size_t i = 0; i < count; ++i) {
+                new (dst + i) T(std::move(src[i]));
+                src[i].~T();
+            }
+        }
+    }
+    
+    template <typename T>
+    constexpr Relocator get_relocator() {
+        if constexpr (is_trivially_relocatable<T>::value) {
+            return nullptr;
+        }
+        else {
+            static_assert(std::is_nothrow_move_constructible<T>::value, "relocators may not throw");
+            return +[](void* dest, void* src) noexcept {
+                relocate(static_cast<T*>(dest), static_cast<T*>(src));
+            };
+        }
+    }
+    
 }
 
 #endif  // UTILS_MEMORY_TPP
\ No newline at end of file
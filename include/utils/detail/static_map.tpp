@@ -0,0 +1,245 @@
+
+#ifndef UTILS_STATIC_MAP_TPP
+#define UTILS_STATIC_MAP_TPP
+
+#include <stdexcept> // std::invalid_argument, std::logic_error, std::out_of_range
+
+namespace utils {
+
+    namespace detail {
+
+        constexpr char ascii_to_lower(char c) {
+            return (c >= 'A' && c <= 'Z') ? static_cast<char>(c - 'A' + 'a') : c;
+        }
+
+        template <bool CaseInsensitive>
+        constexpr std::uint64_t static_map_hash(std::string_view key, std::uint64_t seed) {
+            if constexpr (!CaseInsensitive) {
+                return hash64(key, seed);
+            }
+            else {
+                // ASCII letters differ from their other case only in bit 5, setting that bit in every byte makes the hash insensitive to case
+                // (a few punctuation characters are folded together as well, which only affects hash quality as keys are always compared exactly)
+                constexpr std::uint64_t fold = 0x2020202020202020ull;
+
+                const char* data = key.data();
+                std::size_t remaining = key.length();
+                seed = hash64_seed(seed);
+
+                while (remaining > 16) {
+                    seed = hash64_mix((hash64_read64(data) | fold) ^ hash64_secret[1], (hash64_read64(data + 8) | fold) ^ seed);
+                    data += 16;
+                    remaining -= 16;
+                }
+
+                // Fixed-size (overlapping) reads for the final 1 to 16 bytes
+                std::uint64_t a = 0;
+                std::uint64_t b = 0;
+
+                if (remaining >= 8) {
+                    a = hash64_read64(data);
+                    b = hash64_read64(data + remaining - 8);
+                }
+                else if (remaining >= 4) {
+                    a = hash64_read32(data);
+                    b = hash64_read32(data + remaining - 4);
+                }
+                else if (remaining > 0) {
+                    a = hash64_read3(data, remaining);
+                }
+
+                return hash64_finalize(a | fold, b | fold, seed, key.length());
+            }
+        }
+
+        template <bool CaseInsensitive>
+        constexpr bool static_map_equal(std::string_view first, std::string_view second) {
+            if constexpr (!CaseInsensitive) {
+                return first == second;
+            }
+            else {
+                if (first.length() != second.length()) {
+                    return false;
+                }
+
+                for (std::size_t i = 0u; i < first.length(); ++i) {
+                    if (ascii_to_lower(first[i]) != ascii_to_lower(second[i])) {
+                        return false;
+                    }
+                }
+
+                return true;
+            }
+        }
+
+    }
+
+    template <typename V, std::size_t N, bool CaseInsensitive>
+    constexpr StaticMap<V, N, CaseInsensitive>::StaticMap(const value_type (&entries)[N]) : m_entries(std::to_array(entries)),
+                                                                                          m_displacements(),
+                                                                                          m_slots(),
+                                                                                          m_seed(0) {
+        for (std::size_t i = 0u; i < N; ++i) {
+            for (std::size_t j = i + 1u; j < N; ++j) {
+                if (detail::static_map_equal<CaseInsensitive>(m_entries[i].first, m_entries[j].first)) {
+                    throw std::invalid_argument("duplicate key in StaticMap");
+                }
+            }
+        }
+
+        // Displacement almost always succeeds with the first seed, retrying covers unlucky bucket distributions
+        for (std::uint64_t seed = 0u; seed < 64u; ++seed) {
+            if (build(seed)) {
+                m_seed = seed;
+                return;
+            }
+        }
+
+        throw std::logic_error("failed to construct perfect hash for StaticMap");
+    }
+
+    template <typename V, std::size_t N, bool CaseInsensitive>
+    constexpr typename StaticMap<V, N, CaseInsensitive>::const_iterator StaticMap<V, N, CaseInsensitive>::find(std::string_view key) const {
+        std::uint64_t hash = detail::static_map_hash<CaseInsensitive>(key, m_seed);
+        std::uint32_t index = m_slots[slot(hash, m_displacements[bucket(hash)])];
+
+        // The perfect hash only guarantees that keys in the set map to distinct slots, any other key still needs to be rejected by comparison
+        if (index != UNUSED && detail::static_map_equal<CaseInsensitive>(m_entries[index].first, key)) {
+            return m_entries.data() + index;
+        }
+
+        return end();
+    }
+
+    template <typename V, std::size_t N, bool CaseInsensitive>
+    constexpr bool StaticMap<V, N, CaseInsensitive>::contains(std::string_view key) const {
+        return find(key) != end();
+    }
+
+    template <typename V, std::size_t N, bool CaseInsensitive>
+    constexpr const V& StaticMap<V, N, CaseInsensitive>::at(std::string_view key) const {
+        const_iterator it = find(key);
+        if (it == end()) {
+            throw std::out_of_range("key not found in StaticMap");
+        }
+        return it->second;
+    }
+
+    template <typename V, std::size_t N, bool CaseInsensitive>
+    constexpr typename StaticMap<V, N, CaseInsensitive>::const_iterator StaticMap<V, N, CaseInsensitive>::begin() const {
+        return m_entries.data();
+    }
+
+    template <typename V, std::size_t N, bool CaseInsensitive>
+    constexpr typename StaticMap<V, N, CaseInsensitive>::const_iterator StaticMap<V, N, CaseInsensitive>::end() const {
+        return m_entries.data() + N;
+    }
+
+    template <typename V, std::size_t N, bool CaseInsensitive>
+    constexpr std::size_t StaticMap<V, N, CaseInsensitive>::size() const {
+        return N;
+    }
+
+    template <typename V, std::size_t N, bool CaseInsensitive>
+    constexpr std::size_t StaticMap<V, N, CaseInsensitive>::bucket(std::uint64_t hash) {
+        return static_cast<std::size_t>(hash) & (BUCKET_COUNT - 1u);
+    }
+
+    template <typename V, std::size_t N, bool CaseInsensitive>
+    constexpr std::size_t StaticMap<V, N, CaseInsensitive>::slot(std::uint64_t hash, Displacement displacement) {
+        // Bucket selection consumes the low bits of the hash, remix to derive two independent values for displacement
+        std::uint64_t mixed = detail::hash64_mix(hash, detail::hash64_secret[2]);
+        std::uint32_t f1 = static_cast<std::uint32_t>(mixed);
+        std::uint32_t f2 = static_cast<std::uint32_t>(mixed >> 32);
+        return static_cast<std::size_t>(displacement.d2 + f1 * displacement.d1 + f2) & (CAPACITY - 1u);
+    }
+
+    template <typename V, std::size_t N, bool CaseInsensitive>
+    constexpr bool StaticMap<V, N, CaseInsensitive>::build(std::uint64_t seed) {
+        std::array<std::uint64_t, N> hashes { };
+        std::array<std::size_t, BUCKET_COUNT + 1> offsets { };
+
+        for (std::size_t i = 0u; i < N; ++i) {
+            hashes[i] = detail::static_map_hash<CaseInsensitive>(m_entries[i].first, seed);
+            ++offsets[bucket(hashes[i]) + 1u];
+        }
+
+        std::size_t largest = 0u;
+        for (std::size_t b = 0u; b < BUCKET_COUNT; ++b) {
+            largest = offsets[b + 1u] > largest ? offsets[b + 1u] : largest;
+            offsets[b + 1u] += offsets[b];
+        }
+
+        // Group key indices by bucket, members of bucket 'b' occupy [offsets[b], offsets[b + 1])
+        std::array<std::uint32_t, N> members { };
+        std::array<std::size_t, BUCKET_COUNT> filled { };
+        for (std::size_t i = 0u; i < N; ++i) {
+            std::size_t b = bucket(hashes[i]);
+            members[offsets[b] + filled[b]++] = static_cast<std::uint32_t>(i);
+        }
+
+        m_slots.fill(UNUSED);
+        m_displacements.fill({ 0u, 0u });
+
+        // Marks slots claimed by the current displacement attempt, so that keys within the same bucket do not collide with each other
+        std::array<std::uint32_t, CAPACITY> claimed { };
+        std::uint32_t attempt = 0u;
+
+        // Largest buckets are placed first, while the table is still mostly empty
+        for (std::size_t size = largest; size > 0u; --size) {
+            for (std::size_t b = 0u; b < BUCKET_COUNT; ++b) {
+                if (offsets[b + 1u] - offsets[b] != size) {
+                    continue;
+                }
+
+                bool placed = false;
+
+                for (std::uint32_t d1 = 0u; d1 < CAPACITY && !placed; ++d1) {
+                    for (std::uint32_t d2 = 0u; d2 < CAPACITY && !placed; ++d2) {
+                        Displacement displacement { d1, d2 };
+                        ++attempt;
+
+                        bool valid = true;
+                        for (std::size_t m = offsets[b]; m < offsets[b + 1u]; ++m) {
+                            std::size_t s = slot(hashes[members[m]], displacement);
+                            if (m_slots[s] != UNUSED || claimed[s] == attempt) {
+                                valid = false;
+                                break;
+                            }
+                            claimed[s] = attempt;
+                        }
+
+                        if (!valid) {
+                            continue;
+                        }
+
+                        for (std::size_t m = offsets[b]; m < offsets[b + 1u]; ++m) {
+                            m_slots[slot(hashes[members[m]], displacement)] = members[m];
+                        }
+                        m_displacements[b] = displacement;
+                        placed = true;
+                    }
+                }
+
+                if (!placed) {
+                    return false;
+                }
+            }
+        }
+
+        return true;
+    }
+
+    template <typename V, std::size_t N>
+    constexpr StaticMap<V, N> make_static_map(const std::pair<std::string_view, V> (&entries)[N]) {
+        return StaticMap<V, N>(entries);
+    }
+
+    template <typename V, std::size_t N>
+    constexpr StaticMap<V, N, true> make_static_icase_map(const std::pair<std::string_view, V> (&entries)[N]) {
+        return StaticMap<V, N, true>(entries);
+    }
+
+}
+
+#endif // UTILS_STATIC_MAP_TPP
@@ -2,42 +2,26 @@
 #ifndef UTILS_STRING_TPP
 #define UTILS_STRING_TPP
 
+#include <algorithm> // std::copy, std::min
+#include <bit> // std::endian, std::countr_zero
+#include <cstdint> // std::uint64_t
+#include <cstring> // std::memcpy
+#include <limits> // std::numeric_limits
+
 namespace utils {
 
     template <String T, String U>
     [[nodiscard]] bool icasecmp(const T& first, const U& second) {
         std::string_view a = first;
         std::string_view b = second;
-
-        if (a.length() != b.length()) {
-            return false;
-        }
-
-        for (std::size_t i = 0u; i < a.length(); ++i) {
-            if (std::tolower(a[i]) != std::tolower(b[i])) {
-                return false;
-            }
-        }
-
-        return true;
+        return a.length() == b.length() && detail::icase_equal(a.data(), b.data(), a.length());
     }
 
     template <String T, String U>
     [[nodiscard]] bool operator==(const T& first, const U& second) {
         std::string_view a = first;
         std::string_view b = second;
-
-        if (a.length() != b.length()) {
-            return false;
-        }
-
-        for (std::size_t i = 0u; i < a.length(); ++i) {
-            if (a[i] != b[i]) {
-                return false;
-            }
-        }
-
-        return true;
+        return a.length() == b.length() && a.compare(b) == 0;
     }
 
     template <typename T>
@@ -63,7 +47,7 @@ namespace utils {
         }
 
         // Returns the Nth delimited section of a raw format spec (the text between ':' and the closing '}')
-        // Used by container formatters (pair / tuple / vector / unordered_map / unordered_set) to give each element or slot its own formatting
+        // Used by the pair / tuple / map formatters to give each slot its own formatting
         [[nodiscard]] constexpr std::string_view parse_format_spec_section(std::string_view spec, std::size_t index) {
             std::size_t start = 0u;
             std::size_t current = 0u;
@@ -84,18 +68,522 @@ namespace utils {
             return spec.substr(start);
         }
 
+        constexpr std::string_view parse_element_limit(std::string_view spec, std::size_t& limit) {
+            if (!spec.starts_with("n=")) {
+                return spec;
+            }
+
+            std::size_t i = 2u;
+            std::size_t value = 0u;
+            for (; i < spec.length() && spec[i] >= '0' && spec[i] <= '9'; ++i) {
+                std::size_t digit = static_cast<std::size_t>(spec[i] - '0');
+                if (value > (std::numeric_limits<std::size_t>::max() - digit) / 10u) {
+                    throw fmt::format_error("element limit out of range");
+                }
+                value = value * 10u + digit;
+            }
+
+            if (i == 2u || (i < spec.length() && spec[i] != ':')) {
+                throw fmt::format_error("invalid element limit");
+            }
+
+            limit = value;
+            return i < spec.length() ? spec.substr(i + 1u) : std::string_view();
+        }
+
+        // Returns the closing '}' of the format specification at the start of 'ctx', skipping over nested replacement fields (dynamic width / precision)
+        inline fmt::format_parse_context::iterator find_format_spec_end(const fmt::format_parse_context& ctx) {
+            std::size_t depth = 0u;
+
+            fmt::format_parse_context::iterator it = ctx.begin();
+            for (; it != ctx.end(); ++it) {
+                if (*it == '{') {
+                    ++depth;
+                }
+                else if (*it == '}') {
+                    if (depth == 0u) {
+                        break;
+                    }
+                    --depth;
+                }
+            }
+
+            return it;
+        }
+
+        // Parses 'section' (part of the specification at the start of 'ctx') with 'formatter', in a context of its own so that the formatter does not
+        // see the other sections
+        // Nested replacement fields with automatic indexing are numbered following the arguments already referenced in 'ctx', which are advanced past them
+        template <typename Formatter>
+        void parse_element_spec(Formatter& formatter, std::string_view section, fmt::format_parse_context& ctx) {
+            fmt::format_parse_context section_context(fmt::string_view(section.data(), section.length()));
+
+            int automatic = 0;
+            for (std::size_t i = 0u; i + 1u < section.length(); ++i) {
+                if (section[i] == '{' && section[i + 1u] == '}') {
+                    ++automatic;
+                }
+            }
+
+            if (automatic) {
+                int first = ctx.next_arg_id();
+                for (int i = 1; i < automatic; ++i) {
+                    ctx.next_arg_id();
+                }
+
+                for (int i = 0; i < first; ++i) {
+                    section_context.next_arg_id();
+                }
+            }
+
+            formatter.parse(section_context);
+        }
+
+        // Formats the elements of 'container' with 'format_element', enclosed in 'open' and 'close'
+        // Iteration stops after 'limit' elements (container_format_limit() if 'limit' is the maximum value, no limit if 0) and the number of remaining
+        // elements is taken from the size of the container, so that they are never visited
+        template <typename C, typename Fn>
+        fmt::format_context::iterator format_elements(const C& container, std::size_t limit, std::string_view open, std::string_view close, fmt::format_context& ctx, const Fn& format_element) {
+            fmt::format_context::iterator out = ctx.out();
+
+            if (std::ranges::empty(container)) {
+                return fmt::format_to(out, "{} {}", open, close);
+            }
+
+            if (limit == std::numeric_limits<std::size_t>::max()) {
+                limit = container_format_limit();
+            }
+
+            std::size_t size = std::ranges::size(container);
+            std::size_t count = (limit && limit < size) ? limit : size;
+
+            out = fmt::format_to(out, "{} ", open);
+
+            auto it = std::ranges::begin(container);
+            for (std::size_t i = 0u; i < count; ++i, ++it) {
+                if (i) {
+                    out = fmt::format_to(out, ", ");
+                }
+
+                out = format_element(*it);
+            }
+
+            if (count < size) {
+                out = fmt::format_to(out, ", ... ({} more)", size - count);
+            }
+
+            return fmt::format_to(out, " {}", close);
+        }
+
+        // Returns the number of leading bytes of 'chunk' (loaded little-endian) that are ASCII digits
+        [[nodiscard]] inline unsigned count_leading_digits(std::uint64_t chunk) {
+            // A byte is a digit if its upper nibble is 3 and its lower nibble does not exceed 9, carries only propagate past the first non-digit byte
+            chunk ^= 0x3030303030303030ull;
+            std::uint64_t non_digits = (chunk | (chunk + 0x0606060606060606ull)) & 0xf0f0f0f0f0f0f0f0ull;
+            return static_cast<unsigned>(std::countr_zero(non_digits)) / 8;
+        }
+
+        // Converts 8 ASCII digits (loaded little-endian) with three multiplications, combining pairs of digits, then pairs of pairs, and so on
+        // Bytes with a value of 0 are treated as leading zeros
+        [[nodiscard]] inline std::uint64_t parse_eight_digits(std::uint64_t chunk) {
+            chunk = (chunk & 0x0f0f0f0f0f0f0f0full) * 2561 >> 8;
+            chunk = (chunk & 0x00ff00ff00ff00ffull) * 6553601 >> 16;
+            return (chunk & 0x0000ffff0000ffffull) * 42949672960001ull >> 32;
+        }
+
+        // Fast path for values consisting only of an optional '-' and up to 19 decimal digits, parsing stops at the first non-digit character
+        // Returns the number of characters consumed, or 0 if 'in' does not start with a value of that form or the value does not fit in T (the caller then falls
+        // back to the general conversion, which reports the precise error)
+        template <typename T>
+        [[nodiscard]] std::size_t parse_decimal(std::string_view in, T& out) {
+            if constexpr (std::endian::native != std::endian::little) {
+                // Chunks are assumed to hold the first character in the least significant byte
+                return 0;
+            }
+
+            constexpr std::uint64_t powers[] = { 1, 10, 100, 1000, 10000, 100000, 1000000, 10000000, 100000000 };
+
+            const char* begin = in.data();
+            const char* current = begin;
+            const char* end = begin + in.length();
+
+            bool negative = false;
+            if constexpr (std::is_signed<T>::value) {
+                if (current != end && *current == '-') {
+                    negative = true;
+                    ++current;
+                }
+            }
+
+            const char* digits = current;
+            std::uint64_t value = 0;
+
+            // Digits are processed 8 at a time, the length of the value is found from the position of the first non-digit byte rather than byte by byte
+            while (true) {
+                std::uint64_t chunk = 0; // Bytes past the end of the input are 0, which is not a digit
+                if (end - current >= 8) {
+                    std::memcpy(&chunk, current, sizeof(chunk));
+                }
+                else {
+                    std::memcpy(&chunk, current, static_cast<std::size_t>(end - current));
+                }
+
+                unsigned count = count_leading_digits(chunk);
+                if (count == 0) {
+                    break;
+                }
+
+                // Shift out the bytes that follow the digits (which become leading zeros)
+                value = value * powers[count] + parse_eight_digits(chunk << (64 - 8 * count));
+                current += count;
+
+                // At most 19 digits, so that the value cannot overflow the 64-bit accumulator
+                if (current - digits > 19) {
+                    return 0;
+                }
+
+                if (count < 8) {
+                    break;
+                }
+            }
+
+            if (current == digits) {
+                return 0;
+            }
+
+            constexpr std::uint64_t max = static_cast<std::uint64_t>(std::numeric_limits<T>::max());
+            if (negative) {
+                // The magnitude of the minimum value is one greater than the maximum
+                if (value > max + 1u) {
+                    return 0;
+                }
+                out = static_cast<T>(std::uint64_t(0) - value);
+            }
+            else {
+                if (value > max) {
+                    return 0;
+                }
+                out = static_cast<T>(value);
+            }
+
+            return static_cast<std::size_t>(current - begin);
+        }
+
+        // Parses a complete field (surrounding whitespace allowed), rejecting trailing characters that are not part of the value
+        // 'out' is only assigned once the entire field has been validated
+        template <typename T>
+        FromStringResult try_from_field(std::string_view field, T& out) {
+            T value { };
+            FromStringResult result = try_from_string(field, value);
+            if (result && !trim(field.substr(result.count)).empty()) {
+                // Field contains trailing characters that are not part of the number
+                result.error = std::errc::invalid_argument;
+            }
+
+            if (result) {
+                out = value;
+            }
+            return result;
+        }
+
+    }
+
+    template <std::size_t N>
+    consteval FormatString::FormatString(const char (&format)[N], std::source_location source) : format(format, detail::literal_length(format, N)),
+                                                                                                 source(source),
+                                                                                                 literal(true) {
+        struct Validator {
+            constexpr void on_text(std::string_view) {
+            }
+
+            constexpr void on_field(int, std::string_view, std::string_view) {
+            }
+        } validator;
+
+        if (const char* error = detail::parse_format_string(this->format, validator)) {
+            detail::invalid_format_string(error);
+        }
+    }
+
+    template <std::size_t N>
+    FormatString::FormatString(char (&format)[N], std::source_location source) : format(format),
+                                                                                 source(source),
+                                                                                 literal(false) {
+    }
+
+    template <typename T> requires (std::is_same<T, const char*>::value || std::is_same<T, char*>::value)
+    FormatString::FormatString(T format, std::source_location source) : format(format),
+                                                                        source(source),
+                                                                        literal(false) {
+    }
+
+    namespace detail {
+
+        constexpr std::size_t literal_length(const char* format, std::size_t size) {
+            // Bounded by the size of the array, which may not contain a null character
+            const char* end = std::char_traits<char>::find(format, size, '\0');
+            return end ? static_cast<std::size_t>(end - format) : size;
+        }
+
+        template <typename Handler>
+        constexpr const char* parse_format_string(std::string_view format, Handler& handler) {
+            // Fields either all specify an index or all rely on automatic indexing (named fields may be combined with either)
+            enum class Indexing {
+                UNKNOWN,
+                AUTOMATIC,
+                MANUAL
+            } indexing = Indexing::UNKNOWN;
+
+            int next = 0;
+            std::size_t text = 0; // Start of the pending literal text
+            std::size_t length = format.length();
+
+            for (std::size_t i = 0u; i < length; ++i) {
+                char c = format[i];
+
+                if (c == '}') {
+                    if (i + 1 < length && format[i + 1] == '}') {
+                        // Emit the pending text including the first brace of the escape sequence
+                        handler.on_text(format.substr(text, i + 1 - text));
+                        text = ++i + 1;
+                        continue;
+                    }
+                    return "unmatched '}' in format string";
+                }
+
+                if (c != '{') {
+                    continue;
+                }
+
+                if (i + 1 < length && format[i + 1] == '{') {
+                    handler.on_text(format.substr(text, i + 1 - text));
+                    text = ++i + 1;
+                    continue;
+                }
+
+                if (i > text) {
+                    handler.on_text(format.substr(text, i - text));
+                }
+                ++i;
+
+                int index = -1;
+                std::string_view name;
+
+                if (i < length && format[i] >= '0' && format[i] <= '9') {
+                    index = 0;
+                    for (; i < length && format[i] >= '0' && format[i] <= '9'; ++i) {
+                        if (index > (std::numeric_limits<int>::max() - 9) / 10) {
+                            return "argument index out of range";
+                        }
+                        index = index * 10 + (format[i] - '0');
+                    }
+
+                    if (indexing == Indexing::AUTOMATIC) {
+                        return "cannot switch from automatic to manual argument indexing";
+                    }
+                    indexing = Indexing::MANUAL;
+                }
+                else if (i < length && ((format[i] >= 'a' && format[i] <= 'z') || (format[i] >= 'A' && format[i] <= 'Z') || format[i] == '_')) {
+                    std::size_t start = i;
+                    for (; i < length && ((format[i] >= 'a' && format[i] <= 'z') || (format[i] >= 'A' && format[i] <= 'Z') || (format[i] >= '0' && format[i] <= '9') || format[i] == '_'); ++i) {
+                    }
+                    name = format.substr(start, i - start);
+                }
+                else {
+                    if (indexing == Indexing::MANUAL) {
+                        return "cannot switch from manual to automatic argument indexing";
+                    }
+                    indexing = Indexing::AUTOMATIC;
+                    index = next++;
+                }
+
+                std::string_view specification;
+                if (i < length && format[i] == ':') {
+                    std::size_t start = ++i;
+
+                    // Specifications may contain nested replacement fields (dynamic width / precision)
+                    for (int depth = 0; i < length; ++i) {
+                        if (format[i] == '{') {
+                            ++depth;
+                        }
+                        else if (format[i] == '}') {
+                            if (depth == 0) {
+                                break;
+                            }
+                            --depth;
+                        }
+                    }
+
+                    specification = format.substr(start, i - start);
+                }
+
+                if (i >= length) {
+                    return "missing '}' in format string";
+                }
+                if (format[i] != '}') {
+                    return "invalid format string";
+                }
+
+                handler.on_field(index, name, specification);
+                text = i + 1;
+            }
+
+            if (text < length) {
+                handler.on_text(format.substr(text));
+            }
+
+            return nullptr;
+        }
+
+        template <typename ...Ts>
+        fmt::appender format_to(fmt::appender out, const FormatString& str, const Ts&... args) {
+            // NamedArgument instances are converted to their fmt equivalent, which must outlive the argument store referring to it
+            std::tuple<decltype(to_fmt_argument(args))...> arguments(to_fmt_argument(args)...);
+
+            return std::apply([&](const auto&... converted) {
+                return vformat_to(out, str, fmt::make_format_args(converted...));
+            }, arguments);
+        }
+
+    }
+
+    template <std::size_t N>
+    FormatBuffer<N>::FormatBuffer() {
+    }
+
+    template <std::size_t N>
+    FormatBuffer<N>::~FormatBuffer() = default;
+
+    template <std::size_t N>
+    const char* FormatBuffer<N>::data() const {
+        return m_buffer.data();
+    }
+
+    template <std::size_t N>
+    std::size_t FormatBuffer<N>::size() const {
+        return m_buffer.size();
+    }
+
+    template <std::size_t N>
+    bool FormatBuffer<N>::empty() const {
+        return m_buffer.size() == 0u;
+    }
+
+    template <std::size_t N>
+    std::string_view FormatBuffer<N>::view() const {
+        return { m_buffer.data(), m_buffer.size() };
+    }
+
+    template <std::size_t N>
+    std::string FormatBuffer<N>::str() const {
+        return { m_buffer.data(), m_buffer.size() };
+    }
+
+    template <std::size_t N>
+    void FormatBuffer<N>::clear() {
+        m_buffer.clear();
+    }
+
+    template <std::size_t N>
+    fmt::appender FormatBuffer<N>::out() {
+        return fmt::appender(m_buffer);
     }
 
     template <typename ...Ts>
     std::string format(const FormatString& str, const Ts&... args) {
-        try {
-            return fmt::vformat(str.format, fmt::make_format_args(args...));
+        fmt::memory_buffer buffer;
+        detail::format_to(fmt::appender(buffer), str, args...);
+        return fmt::to_string(buffer);
+    }
+
+    template <std::output_iterator<char> OutputIt, typename ...Ts>
+    OutputIt format_to(OutputIt out, const FormatString& str, const Ts&... args) {
+        if constexpr (std::is_same<OutputIt, fmt::appender>::value) {
+            return detail::format_to(out, str, args...);
         }
-        catch (const fmt::format_error& error) {
-            throw std::runtime_error(fmt::format("{} ({}:{})", error.what(), str.source.file_name(), str.source.line()));
+        else {
+            fmt::memory_buffer buffer;
+            detail::format_to(fmt::appender(buffer), str, args...);
+            return std::copy(buffer.begin(), buffer.end(), out);
         }
     }
 
+    template <std::size_t N, typename ...Ts>
+    std::string_view format_to(FormatBuffer<N>& buffer, const FormatString& str, const Ts&... args) {
+        detail::format_to(buffer.out(), str, args...);
+        return buffer.view();
+    }
+
+    template <std::output_iterator<char> OutputIt, typename ...Ts>
+    FormatToResult<OutputIt> format_to_n(OutputIt out, std::size_t n, const FormatString& str, const Ts&... args) {
+        // The complete output is formatted, characters past the limit are counted and discarded
+        fmt::memory_buffer buffer;
+        detail::format_to(fmt::appender(buffer), str, args...);
+
+        std::size_t size = std::min(n, buffer.size());
+        return { std::copy(buffer.begin(), buffer.begin() + size, out), buffer.size(), buffer.size() > n };
+    }
+
+    template <typename ...Ts>
+    std::size_t formatted_size(const FormatString& str, const Ts&... args) {
+        fmt::memory_buffer buffer;
+        detail::format_to(fmt::appender(buffer), str, args...);
+        return buffer.size();
+    }
+
+    template <typename T>
+    FromStringResult from_string_many(std::string_view in, std::string_view delimiter, std::span<T> out) {
+        std::size_t count = 0;
+
+        while (count < out.size()) {
+            std::size_t position = std::string_view::npos;
+            bool parsed = false;
+
+            if constexpr (is_integer_type<T>::value) {
+                // Plain decimal values are parsed directly from the input, which also locates the end of the field without a separate delimiter search
+                T value { };
+                std::size_t length = detail::parse_decimal(in, value);
+                if (length) {
+                    if (length == in.length()) {
+                        parsed = true;
+                    }
+                    else if (delimiter.length() == 1 ? in[length] == delimiter[0] : (!delimiter.empty() && in.substr(length).starts_with(delimiter))) {
+                        parsed = true;
+                        position = length;
+                    }
+                }
+
+                if (parsed) {
+                    out[count] = value;
+                }
+            }
+
+            if (!parsed) {
+                position = delimiter.empty() ? std::string_view::npos : detail::find_delimiter(in, delimiter);
+                std::string_view field = in.substr(0, position);
+
+                if (position == std::string_view::npos && field.empty() && count > 0) {
+                    // Input ends with a delimiter
+                    break;
+                }
+
+                FromStringResult result = detail::try_from_field(field, out[count]);
+                if (!result) {
+                    return { count, result.error };
+                }
+            }
+
+            ++count;
+
+            if (position == std::string_view::npos) {
+                break;
+            }
+            in.remove_prefix(position + delimiter.length());
+        }
+
+        return { count, std::errc { } };
+    }
+
 }
 
 // std::pair
@@ -182,147 +670,71 @@ fmt::format_context::iterator fmt::formatter<std::tuple<Ts...>>::format(const st
     return out;
 }
 
-// std::vector
-
-template <typename T>
-fmt::format_parse_context::iterator fmt::formatter<std::vector<T>>::parse(fmt::format_parse_context& ctx) {
-    return m_formatter.parse(ctx);
-}
-
-template <typename T>
-fmt::format_context::iterator fmt::formatter<std::vector<T>>::format(const std::vector<T>& value, fmt::format_context& ctx) const {
-    fmt::format_context::iterator out = ctx.out();
-
-    if (value.empty()) {
-        out = fmt::format_to(out, "[ ]");
-    }
-    else {
-        out = fmt::format_to(out, "[ ");
-
-        for (std::size_t i = 0u; i < value.size(); ++i) {
-            if (i) {
-                out = fmt::format_to(out, ", ");
-            }
-
-            out = m_formatter.format(value[i], ctx);
-        }
-
-        out = fmt::format_to(out, " ]");
-    }
-
-    return out;
-}
+// Standard containers
 
-// std::span
+template <typename C, bool Associative>
+fmt::format_parse_context::iterator utils::detail::ContainerFormatter<C, Associative>::parse(fmt::format_parse_context& ctx) {
+    std::string_view spec(ctx.begin(), static_cast<std::size_t>(find_format_spec_end(ctx) - ctx.begin()));
+    std::size_t length = parse_element_limit(spec, m_limit).length();
 
-template <typename T>
-fmt::format_parse_context::iterator fmt::formatter<std::span<T>>::parse(fmt::format_parse_context& ctx) {
+    // The element specification is parsed from the enclosing context, so that nested replacement fields refer to the arguments of the format string
+    ctx.advance_to(ctx.begin() + (spec.length() - length));
     return m_formatter.parse(ctx);
 }
 
-template <typename T>
-fmt::format_context::iterator fmt::formatter<std::span<T>>::format(const std::span<T>& value, fmt::format_context& ctx) const {
-    fmt::format_context::iterator out = ctx.out();
-
-    if (value.empty()) {
-        out = fmt::format_to(out, "[ ]");
-    }
-    else {
-        out = fmt::format_to(out, "[ ");
-
-        for (std::size_t i = 0u; i < value.size(); ++i) {
-            if (i) {
-                out = fmt::format_to(out, ", ");
-            }
-
-            out = m_formatter.format(value[i], ctx);
-        }
-
-        out = fmt::format_to(out, " ]");
-    }
+template <typename C, bool Associative>
+fmt::format_context::iterator utils::detail::ContainerFormatter<C, Associative>::format(const C& value, fmt::format_context& ctx) const {
+    constexpr bool set = is_set<C>::value || is_unordered_set<C>::value;
 
-    return out;
+    return format_elements(value, m_limit, set ? "{" : "[", set ? "}" : "]", ctx, [this, &ctx](const auto& element) {
+        return m_formatter.format(element, ctx);
+    });
 }
 
-// std::unordered_map
-
-template <typename K, typename V, typename H, typename P, typename A>
-fmt::format_parse_context::iterator fmt::formatter<std::unordered_map<K, V, H, P, A>>::parse(fmt::format_parse_context& ctx) {
-    fmt::format_parse_context::iterator it = ctx.begin();
-    while (it != ctx.end() && *it != '}') {
-        ++it;
-    }
-
-    std::string_view spec(ctx.begin(), static_cast<std::size_t>(it - ctx.begin()));
-
-    fmt::format_parse_context key_context(utils::detail::parse_format_spec_section(spec, 0u));
-    m_key_formatter.parse(key_context);
+template <typename C>
+fmt::format_parse_context::iterator utils::detail::ContainerFormatter<C, true>::parse(fmt::format_parse_context& ctx) {
+    fmt::format_parse_context::iterator it = find_format_spec_end(ctx);
+    std::string_view spec = parse_element_limit(std::string_view(ctx.begin(), static_cast<std::size_t>(it - ctx.begin())), m_limit);
 
-    fmt::format_parse_context value_context(utils::detail::parse_format_spec_section(spec, 1u));
-    m_value_formatter.parse(value_context);
+    parse_element_spec(m_key_formatter, parse_format_spec_section(spec, 0u), ctx);
+    parse_element_spec(m_value_formatter, parse_format_spec_section(spec, 1u), ctx);
 
     return it;
 }
 
-template <typename K, typename V, typename H, typename P, typename A>
-fmt::format_context::iterator fmt::formatter<std::unordered_map<K, V, H, P, A>>::format(const std::unordered_map<K, V, H, P, A>& value, fmt::format_context& ctx) const {
-    fmt::format_context::iterator out = ctx.out();
-
-    if (value.empty()) {
-        out = fmt::format_to(out, "{{ }}");
-    }
-    else {
-        out = fmt::format_to(out, "{{ ");
-
-        bool first_element = true;
-        for (const auto& [key, mapped] : value) {
-            if (!first_element) {
-                out = fmt::format_to(out, ", ");
-            }
-            first_element = false;
-
-            out = m_key_formatter.format(key, ctx);
-            out = fmt::format_to(out, ": ");
-            out = m_value_formatter.format(mapped, ctx);
-        }
-
-        out = fmt::format_to(out, " }}");
-    }
-
-    return out;
+template <typename C>
+fmt::format_context::iterator utils::detail::ContainerFormatter<C, true>::format(const C& value, fmt::format_context& ctx) const {
+    return format_elements(value, m_limit, "{", "}", ctx, [this, &ctx](const auto& element) {
+        fmt::format_context::iterator out = m_key_formatter.format(element.first, ctx);
+        out = fmt::format_to(out, ": ");
+        return m_value_formatter.format(element.second, ctx);
+    });
 }
 
-// std::unordered_set
+#if FMT_VERSION < 100000
+
+// std::optional
 
-template <typename K, typename H, typename E, typename A>
-fmt::format_parse_context::iterator fmt::formatter<std::unordered_set<K, H, E, A>>::parse(fmt::format_parse_context& ctx) {
+template <typename T>
+fmt::format_parse_context::iterator fmt::formatter<std::optional<T>>::parse(fmt::format_parse_context& ctx) {
     return m_formatter.parse(ctx);
 }
 
-template <typename K, typename H, typename E, typename A>
-fmt::format_context::iterator fmt::formatter<std::unordered_set<K, H, E, A>>::format(const std::unordered_set<K, H, E, A>& value, fmt::format_context& ctx) const {
+template <typename T>
+fmt::format_context::iterator fmt::formatter<std::optional<T>>::format(const std::optional<T>& value, fmt::format_context& ctx) const {
     fmt::format_context::iterator out = ctx.out();
 
-    if (value.empty()) {
-        out = fmt::format_to(out, "{{ }}");
+    if (!value) {
+        return fmt::format_to(out, "none");
     }
-    else {
-        out = fmt::format_to(out, "{{ ");
-
-        bool first_element = true;
-        for (const K& element : value) {
-            if (!first_element) {
-                out = fmt::format_to(out, ", ");
-            }
-            first_element = false;
 
-            out = m_formatter.format(element, ctx);
-        }
-
-        out = fmt::format_to(out, " }}");
-    }
+    out = fmt::format_to(out, "optional(");
+    out = m_formatter.format(*value, ctx);
+    out = fmt::format_to(out, ")");
 
     return out;
 }
 
+#endif
+
 #endif // UTILS_STRING_TPP
@@ -3,6 +3,7 @@
 #define UTILS_EVENTS_HPP
 
 #include <memory> // std::shared_ptr
+#include <source_location> // std::source_location
 
 namespace utils {
     
@@ -101,11 +102,17 @@ namespace utils {
     void deregister_event_handler(bool (*function)(E));
     
     
+    // Allocation of the event is attributed to 'source' in debug builds (see BumpAllocator::allocation_sites)
     template <typename E>
-    void dispatch_event(E&& event);
+    void dispatch_event(E&& event, std::source_location source = std::source_location::current());
 
+    // A location cannot be defaulted after the arguments, allocation of the event is therefore attributed to this function (use dispatch_event_at())
     template <typename E, typename ...Ts>
     void dispatch_event(const Ts&... args);
+
+    // Constructs the event from 'args', its allocation is attributed to 'source' in debug builds
+    template <typename E, typename ...Ts>
+    void dispatch_event_at(std::source_location source, const Ts&... args);
     
 }
 
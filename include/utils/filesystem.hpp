@@ -2,16 +2,208 @@
 #ifndef UTILS_FILESYSTEM_HPP
 #define UTILS_FILESYSTEM_HPP
 
+#include "utils/function.hpp"
+#include "utils/memory.hpp"
+#include "utils/result.hpp"
+#include <cstddef> // std::size_t, std::byte
+#include <cstdint> // std::uint64_t
+#include <initializer_list> // std::initializer_list
+#include <iterator> // std::default_sentinel_t, std::input_iterator_tag
+#include <limits> // std::numeric_limits
+#include <memory> // std::unique_ptr
+#include <span> // std::span
 #include <string> // std::string
 #include <filesystem> // std::filesystem
 #include <string_view> // std::string_view
 
 namespace utils {
-    
+
+    // Hints passed on to the kernel about how (part of) a mapped file will be accessed
+    enum class MapAdvice {
+        Normal,
+        Sequential, // Pages are read ahead aggressively, and may be dropped soon after they are accessed
+        Random, // Read-ahead is disabled
+        WillNeed, // Pages are read in the background
+        DontNeed, // Pages are dropped, and read again if they are accessed
+        HugePages // Mapping is backed by transparent huge pages, where the filesystem supports it
+    };
+
+    struct MapOptions {
+        MapAdvice access = MapAdvice::Normal; // One of Normal, Sequential, or Random
+        bool will_need = false;
+        bool huge_pages = false;
+        bool populate = false; // All pages are read and mapped before returning, so that accessing the file never faults
+    };
+
+    // Read-only view of the contents of a file mapped into memory, which is unmapped on destruction
+    // Pages are read on first access (unless populated), so that only the parts of the file that are accessed are ever read
+    // Accessing a page past the end of a file that was truncated (by another process) after it was mapped raises SIGBUS, only map files that are not
+    // modified while mapped
+    class MappedFile {
+        public:
+            [[nodiscard]] static Result<MappedFile> open(const std::filesystem::path& path, const MapOptions& options = { });
+
+            // Empty mapping
+            MappedFile();
+            ~MappedFile();
+
+            MappedFile(MappedFile&& other) noexcept;
+            MappedFile& operator=(MappedFile&& other) noexcept;
+
+            MappedFile(const MappedFile&) = delete;
+            MappedFile& operator=(const MappedFile&) = delete;
+
+            [[nodiscard]] const std::byte* data() const;
+            [[nodiscard]] std::size_t size() const;
+            [[nodiscard]] bool empty() const;
+
+            [[nodiscard]] std::span<const std::byte> bytes() const;
+            [[nodiscard]] std::string_view view() const;
+
+            // Applies 'advice' to the pages overlapping [offset, offset + length), clamped to the size of the file
+            [[nodiscard]] Result<void> advise(MapAdvice advice, std::size_t offset = 0u, std::size_t length = std::numeric_limits<std::size_t>::max()) const;
+
+        private:
+            void unmap();
+
+            std::byte* m_data;
+            std::size_t m_size;
+    };
+
+    namespace detail {
+        class NativeFile;
+        class ChunkReader;
+    }
+
+    struct ReadOptions {
+        std::size_t chunk_size = megabytes(1);
+        bool direct = false; // Bypasses the page cache (O_DIRECT) where the filesystem supports it, the chunk size is rounded up to a multiple of 4 KiB
+        bool read_ahead = true; // The next chunk is read on a background thread while the current one is being processed
+    };
+
+    // Reads a file sequentially in chunks of a fixed size into buffers that are reused, so that memory use does not depend on the size of the file
+    class FileReader {
+        public:
+            class LineIterator {
+                public:
+                    using value_type = std::string_view;
+                    using difference_type = std::ptrdiff_t;
+                    using iterator_category = std::input_iterator_tag;
+
+                    LineIterator();
+                    explicit LineIterator(FileReader* reader);
+
+                    [[nodiscard]] std::string_view operator*() const;
+                    LineIterator& operator++();
+                    void operator++(int);
+
+                    [[nodiscard]] bool operator==(std::default_sentinel_t) const;
+
+                private:
+                    FileReader* m_reader; // nullptr once all lines have been read
+                    std::string_view m_line;
+            };
+
+            struct LineRange {
+                [[nodiscard]] LineIterator begin() const;
+                [[nodiscard]] std::default_sentinel_t end() const;
+
+                FileReader* reader;
+            };
+
+            [[nodiscard]] static Result<FileReader> open(const std::filesystem::path& path, const ReadOptions& options = { });
+
+            FileReader();
+            ~FileReader();
+
+            FileReader(FileReader&& other) noexcept;
+            FileReader& operator=(FileReader&& other) noexcept;
+
+            // Returns the next chunk of the file (empty once the end of the file is reached), which remains valid until the next call
+            [[nodiscard]] Result<std::span<const std::byte>> next();
+
+            // Lazily reads the rest of the file as lines (without their terminators, '\n' or "\r\n"), which remain valid until the next line is read
+            // Lines are views into the chunk they were read from, unless they span chunks, in which case they are copied into a buffer that is reused
+            // Throws std::runtime_error if the file cannot be read, and should not be combined with calls to next()
+            [[nodiscard]] LineRange lines();
+
+        private:
+            // Returns false once all lines have been read
+            bool next_line(std::string_view& line);
+
+            std::unique_ptr<detail::ChunkReader> m_reader; // Shared with the read-ahead thread, so that the reader can be moved
+            std::string_view m_chunk; // Remainder of the current chunk that has not been split into lines
+            std::string m_line; // Line that spans chunks
+            bool m_exhausted;
+    };
+
+    struct WriteOptions {
+        std::size_t buffer_size = megabytes(1);
+        bool append = false; // Writes are appended to the file instead of replacing its contents
+    };
+
+    // Writes a file sequentially through a buffer of a fixed size, so that many small writes result in few system calls
+    // Writes that do not fit in the remainder of the buffer are written along with its contents in a single call (writev), without being copied
+    class FileWriter {
+        public:
+            [[nodiscard]] static Result<FileWriter> open(const std::filesystem::path& path, const WriteOptions& options = { });
+
+            FileWriter();
+
+            // Buffered contents are written before the file is closed, close() should be called to observe whether this succeeded
+            ~FileWriter();
+
+            FileWriter(FileWriter&& other) noexcept;
+            FileWriter& operator=(FileWriter&& other) noexcept;
+
+            [[nodiscard]] Result<void> write(std::string_view data);
+
+            // Writes 'pieces' in order, as if they were concatenated
+            [[nodiscard]] Result<void> write(std::span<const std::string_view> pieces);
+            [[nodiscard]] Result<void> write(std::initializer_list<std::string_view> pieces);
+
+            // Writes the contents of the buffer to the file
+            [[nodiscard]] Result<void> flush();
+
+            [[nodiscard]] Result<void> close();
+
+        private:
+            std::unique_ptr<detail::NativeFile> m_file;
+            std::unique_ptr<char[]> m_buffer;
+            std::size_t m_capacity;
+            std::size_t m_size;
+    };
+
+    // Reads the file in its entirety, throws std::runtime_error if it cannot be read
+    // MappedFile::open() provides a view of the contents of large files without copying them, for files that are not truncated while mapped
     [[nodiscard]] std::string read(const std::filesystem::path& path);
 
     void write(const std::filesystem::path& path, std::string_view content);
 
+    struct BatchReadOptions {
+        std::size_t queue_depth = 256; // Maximum number of files being read at once
+        std::size_t threads = 16; // Number of threads reading files where io_uring is not available
+        bool io_uring = true; // Reads are submitted through io_uring where the kernel supports it (Linux 5.6 or later)
+    };
+
+    // Reads many (small) files at once, so that the latency of opening and reading each file overlaps with others
+    // Reads are submitted through io_uring where available (from the calling thread), and otherwise distributed across a pool of threads
+    // 'callback' is invoked on the calling thread for each file, in the order the reads complete, with the index of the file in 'paths' and its contents
+    // Returns once all files have been read
+    void read_many(std::span<const std::filesystem::path> paths, const InplaceFunction<void(std::size_t index, Result<std::string>& contents)>& callback, const BatchReadOptions& options = { });
+
+    // Published by dispatch_read_events() for each file
+    struct FileReadEvent {
+        std::size_t index; // Into the list of paths
+        std::filesystem::path path;
+        std::string contents;
+        std::string error; // Empty if the file was read successfully
+    };
+
+    // Reads many files as by read_many(), publishing a FileReadEvent for each through dispatch_event() as its read completes
+    // Events are dispatched from the calling thread (as the event queue is not thread-safe), and are delivered by the next call to process_events()
+    void dispatch_read_events(std::span<const std::filesystem::path> paths, const BatchReadOptions& options = { });
+
 }
 
 #endif // UTILS_FILESYSTEM_HPP
@@ -0,0 +1,165 @@
+
+#ifndef UTILS_FILTERS_HPP
+#define UTILS_FILTERS_HPP
+
+#include "utils/hash.hpp"
+#include "utils/result.hpp"
+#include <cstddef> // std::size_t, std::byte
+#include <cstdint> // std::uint8_t, std::uint64_t
+#include <span> // std::span
+#include <vector> // std::vector
+
+// Probabilistic data structures with a fixed memory footprint
+// All structures operate on 64-bit hashes: typed overloads hash values with utils::Hash, the *_hash overloads accept precomputed hashes (which are remixed
+// internally, so weak hashes such as std::hash for integers are acceptable)
+// Serialized forms consist of a fixed header followed by the raw table in host byte order, and can be persisted to disk (or mapped) and restored with deserialize
+
+namespace utils {
+
+    // Set membership test with false positives but no false negatives
+    // Blocked layout: each element sets 8 bits within a single cache-line-sized block, so queries touch exactly one cache line
+    class BloomFilter {
+        public:
+            // Sizes the filter for 'expected_elements' at the requested false positive rate
+            explicit BloomFilter(std::size_t expected_elements, double false_positive_rate = 0.01);
+
+            template <typename T>
+            void insert(const T& value);
+
+            template <typename T>
+            [[nodiscard]] bool contains(const T& value) const;
+
+            void insert_hash(std::uint64_t hash);
+            [[nodiscard]] bool contains_hash(std::uint64_t hash) const;
+
+            // Batch variants prefetch the blocks of upcoming elements to overlap cache misses
+            void insert_hashes(std::span<const std::uint64_t> hashes);
+
+            // Writes the result for each hash into 'results' (which must be at least as large as 'hashes'), returns the number of hashes that may be present
+            std::size_t contains_hashes(std::span<const std::uint64_t> hashes, std::span<bool> results) const;
+
+            void clear();
+
+            // Size of the filter, in bytes
+            [[nodiscard]] std::size_t size_bytes() const;
+
+            [[nodiscard]] std::vector<std::byte> serialize() const;
+            [[nodiscard]] static Result<BloomFilter> deserialize(std::span<const std::byte> data);
+
+        private:
+            struct alignas(64) Block {
+                std::uint64_t words[8];
+            };
+
+            BloomFilter() = default;
+
+            [[nodiscard]] std::size_t block_index(std::uint64_t hash) const;
+
+            std::vector<Block> m_blocks;
+    };
+
+    // Set membership test with false positives but no false negatives, that (unlike BloomFilter) supports removing elements
+    // Stores 16-bit fingerprints in buckets of 4 (one 64-bit word per bucket), each element has two candidate buckets
+    class CuckooFilter {
+        public:
+            // Sizes the filter to hold 'capacity' elements
+            explicit CuckooFilter(std::size_t capacity);
+
+            // Returns false if the filter is too full to accommodate the element
+            template <typename T>
+            bool insert(const T& value);
+
+            template <typename T>
+            [[nodiscard]] bool contains(const T& value) const;
+
+            // Removes one occurrence of 'value', which must have been inserted before (removing an element that was never inserted may remove another element
+            // with the same fingerprint), returns false if no matching fingerprint was found
+            template <typename T>
+            bool erase(const T& value);
+
+            bool insert_hash(std::uint64_t hash);
+            [[nodiscard]] bool contains_hash(std::uint64_t hash) const;
+            bool erase_hash(std::uint64_t hash);
+
+            // Returns the number of hashes that were inserted, insertion stops at the first element that does not fit
+            std::size_t insert_hashes(std::span<const std::uint64_t> hashes);
+
+            // Writes the result for each hash into 'results' (which must be at least as large as 'hashes'), returns the number of hashes that may be present
+            std::size_t contains_hashes(std::span<const std::uint64_t> hashes, std::span<bool> results) const;
+
+            void clear();
+
+            // Number of elements in the filter
+            [[nodiscard]] std::size_t size() const;
+
+            // Size of the filter, in bytes
+            [[nodiscard]] std::size_t size_bytes() const;
+
+            [[nodiscard]] std::vector<std::byte> serialize() const;
+            [[nodiscard]] static Result<CuckooFilter> deserialize(std::span<const std::byte> data);
+
+        private:
+            static constexpr std::size_t SLOTS_PER_BUCKET = 4;
+            static constexpr std::size_t MAX_KICKS = 500;
+
+            // An element is identified by its fingerprint and primary bucket, the alternate bucket is derived from both
+            struct Location {
+                std::uint16_t fingerprint; // Never 0, which marks an empty slot
+                std::size_t primary;
+                std::size_t alternate;
+            };
+
+            CuckooFilter() = default;
+
+            [[nodiscard]] Location locate(std::uint64_t hash) const;
+            [[nodiscard]] std::size_t alternate(std::size_t bucket, std::uint16_t fingerprint) const;
+
+            [[nodiscard]] static bool bucket_contains(std::uint64_t bucket, std::uint16_t fingerprint);
+
+            // Returns false if the bucket has no empty slots
+            static bool bucket_insert(std::uint64_t& bucket, std::uint16_t fingerprint);
+            static bool bucket_erase(std::uint64_t& bucket, std::uint16_t fingerprint);
+
+            std::vector<std::uint64_t> m_buckets;
+            std::size_t m_size = 0;
+
+            // Fingerprint that was evicted by the last failed insertion, kept so that the filter never reports false negatives (0 if unused)
+            std::uint16_t m_victim_fingerprint = 0;
+            std::size_t m_victim_bucket = 0;
+    };
+
+    // Approximate count of distinct elements, with a relative standard error of about 1.04 / sqrt(2^precision)
+    class HyperLogLog {
+        public:
+            // 'precision' (4 to 18) is the number of hash bits used to select a register, the sketch uses 2^precision bytes
+            explicit HyperLogLog(unsigned precision = 14);
+
+            template <typename T>
+            void insert(const T& value);
+
+            void insert_hash(std::uint64_t hash);
+            void insert_hashes(std::span<const std::uint64_t> hashes);
+
+            [[nodiscard]] double estimate() const;
+
+            // Combines the elements of 'other' (which must have the same precision) into this sketch
+            void merge(const HyperLogLog& other);
+
+            void clear();
+
+            [[nodiscard]] unsigned precision() const;
+
+            [[nodiscard]] std::vector<std::byte> serialize() const;
+            [[nodiscard]] static Result<HyperLogLog> deserialize(std::span<const std::byte> data);
+
+        private:
+            unsigned m_precision;
+            std::vector<std::uint8_t> m_registers;
+    };
+
+}
+
+// Template definitions
+#include "utils/detail/filters.tpp"
+
+#endif // UTILS_FILTERS_HPP
@@ -0,0 +1,285 @@
+
+#ifndef UTILS_FLAT_HASH_MAP_HPP
+#define UTILS_FLAT_HASH_MAP_HPP
+
+#include "utils/hash.hpp"
+#include <cstddef> // std::size_t
+#include <cstdint> // std::int8_t
+#include <functional> // std::equal_to
+#include <iterator> // std::forward_iterator_tag
+#include <utility> // std::pair
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+    #define UTILS_FLAT_HASH_MAP_SSE2 1
+    #include <emmintrin.h>
+#endif
+
+namespace utils {
+
+    namespace detail {
+
+        // Control bytes hold the state of each slot: full slots store the low 7 bits of the key hash (H2), empty / deleted slots are negative
+        using ControlByte = std::int8_t;
+        inline constexpr ControlByte CONTROL_EMPTY = -128; // 0b10000000
+        inline constexpr ControlByte CONTROL_DELETED = -2; // 0b11111110
+
+        // Set of slots within a group, 'Shift' is log2 of the number of mask bits per slot
+        template <unsigned Shift>
+        class GroupMask {
+            public:
+                explicit GroupMask(std::uint64_t mask);
+
+                [[nodiscard]] explicit operator bool() const;
+
+                // Index of the first slot in the set
+                [[nodiscard]] std::size_t lowest() const;
+
+                // Number of consecutive slots not in the set at the start / end of the group
+                [[nodiscard]] std::size_t trailing_zeros() const;
+                [[nodiscard]] std::size_t leading_zeros(std::size_t width) const;
+
+                // Removes the lowest slot from the set
+                GroupMask& operator++();
+
+            private:
+                std::uint64_t m_mask;
+        };
+
+        // Window of control bytes that is matched against in parallel
+        // Uses SSE2 (16 slots at a time) where available, and a portable 64-bit SWAR implementation (8 slots at a time) otherwise
+        class Group {
+            public:
+                #if defined(UTILS_FLAT_HASH_MAP_SSE2)
+                    static constexpr std::size_t WIDTH = 16;
+                    using Mask = GroupMask<0>;
+                #else
+                    static constexpr std::size_t WIDTH = 8;
+                    using Mask = GroupMask<3>;
+                #endif
+
+                explicit Group(const ControlByte* control);
+
+                // May report false positives in the portable implementation, candidates are always verified against the key
+                [[nodiscard]] Mask match(std::uint8_t h2) const;
+                [[nodiscard]] Mask match_empty() const;
+                [[nodiscard]] Mask match_empty_or_deleted() const;
+
+            private:
+                #if defined(UTILS_FLAT_HASH_MAP_SSE2)
+                    __m128i m_control;
+                #else
+                    std::uint64_t m_control;
+                #endif
+        };
+
+        // Open-addressing hash table (Swiss table layout): a control byte array probed one group at a time, followed by a parallel array of slots
+        // 'Traits' provides key_type, value_type and a key(value) accessor
+        // Unlike the node-based std::unordered_map, inserting may move existing elements (invalidating references and iterators)
+        template <typename Traits, typename H, typename E>
+        class FlatHashTable {
+            public:
+                using key_type = typename Traits::key_type;
+                using value_type = typename Traits::value_type;
+                using size_type = std::size_t;
+                using hasher = H;
+                using key_equal = E;
+
+                template <bool Const>
+                class Iterator {
+                    public:
+                        using iterator_category = std::forward_iterator_tag;
+                        using value_type = typename Traits::value_type;
+                        using difference_type = std::ptrdiff_t;
+                        using pointer = std::conditional_t<Const, const value_type*, value_type*>;
+                        using reference = std::conditional_t<Const, const value_type&, value_type&>;
+
+                        Iterator();
+                        Iterator(const FlatHashTable* table, std::size_t index);
+
+                        // Conversion from iterator to const_iterator
+                        template <bool C> requires (Const && !C)
+                        Iterator(const Iterator<C>& other);
+
+                        reference operator*() const;
+                        pointer operator->() const;
+
+                        Iterator& operator++();
+                        Iterator operator++(int);
+
+                        bool operator==(const Iterator& other) const;
+                        bool operator!=(const Iterator& other) const;
+
+                    private:
+                        friend class FlatHashTable;
+
+                        template <bool C>
+                        friend class Iterator;
+
+                        // Advances to the next full slot, starting from the current index
+                        void skip_empty();
+
+                        const FlatHashTable* m_table;
+                        std::size_t m_index;
+                };
+
+                using iterator = Iterator<false>;
+                using const_iterator = Iterator<true>;
+
+                FlatHashTable();
+                explicit FlatHashTable(std::size_t capacity, const H& hash = H(), const E& equal = E());
+                ~FlatHashTable();
+
+                FlatHashTable(const FlatHashTable& other);
+                FlatHashTable& operator=(const FlatHashTable& other);
+
+                FlatHashTable(FlatHashTable&& other) noexcept;
+                FlatHashTable& operator=(FlatHashTable&& other) noexcept;
+
+                [[nodiscard]] iterator begin();
+                [[nodiscard]] iterator end();
+                [[nodiscard]] const_iterator begin() const;
+                [[nodiscard]] const_iterator end() const;
+
+                [[nodiscard]] std::size_t size() const;
+                [[nodiscard]] bool empty() const;
+                [[nodiscard]] std::size_t capacity() const;
+
+                // Destroys all elements, keeping the allocated capacity
+                void clear();
+
+                // Ensures that 'count' elements can be held without rehashing
+                void reserve(std::size_t count);
+
+                std::pair<iterator, bool> insert(const value_type& value);
+                std::pair<iterator, bool> insert(value_type&& value);
+
+                // Constructs a value_type from 'args' and inserts it if an element with an equivalent key does not already exist
+                template <typename ...Ts>
+                std::pair<iterator, bool> emplace(Ts&&... args);
+
+                // Lookups accept any key type if both H and E are transparent (define 'is_transparent'), otherwise only key_type
+                template <typename Q = key_type>
+                [[nodiscard]] iterator find(const Q& key);
+
+                template <typename Q = key_type>
+                [[nodiscard]] const_iterator find(const Q& key) const;
+
+                template <typename Q = key_type>
+                [[nodiscard]] bool contains(const Q& key) const;
+
+                template <typename Q = key_type>
+                [[nodiscard]] std::size_t count(const Q& key) const;
+
+                // Returns the number of elements removed (0 or 1)
+                template <typename Q = key_type>
+                std::size_t erase(const Q& key);
+
+                // Returns an iterator to the element following the erased element
+                iterator erase(const_iterator position);
+                iterator erase(iterator position);
+
+            protected:
+                // Returns the (mixed) hash of 'key'
+                template <typename Q>
+                [[nodiscard]] std::size_t hash(const Q& key) const;
+
+                // Returns the slot index of 'key', or m_capacity if the key is not present
+                template <typename Q>
+                [[nodiscard]] std::size_t find_index(const Q& key, std::size_t hash) const;
+
+                // Returns the index of the slot 'key' is stored in (true), or the index of an unoccupied slot that a value with this key should be constructed into (false)
+                // The slot must then be claimed with commit_insert after the value is constructed
+                template <typename Q>
+                [[nodiscard]] std::pair<std::size_t, bool> find_or_prepare_insert(const Q& key, std::size_t hash);
+
+                void commit_insert(std::size_t index, std::size_t hash);
+
+                value_type* m_slots;
+
+            private:
+                static constexpr std::size_t MINIMUM_CAPACITY = Group::WIDTH;
+
+                // Maximum number of elements a table of the given capacity holds before growing (7/8 load factor)
+                [[nodiscard]] static std::size_t growth_limit(std::size_t capacity);
+
+                [[nodiscard]] std::size_t find_first_non_full(std::size_t hash) const;
+                void set_control(std::size_t index, ControlByte value);
+
+                void erase_index(std::size_t index);
+
+                // Reallocates storage to hold 'capacity' slots, moving all existing elements
+                void resize(std::size_t capacity);
+                void rehash_and_grow();
+
+                void destroy();
+
+                ControlByte* m_control; // m_capacity + Group::WIDTH bytes, the first group is mirrored past the end so that group loads never wrap around
+                std::size_t m_capacity; // Always 0 or a power of two
+
+                std::size_t m_size;
+                std::size_t m_growth_left; // Number of empty slots that can still be filled before the table must grow, deleted slots are not reclaimed until the next rehash
+
+                [[no_unique_address]] H m_hash;
+                [[no_unique_address]] E m_equal;
+        };
+
+        template <typename K, typename V>
+        struct FlatHashMapTraits {
+            using key_type = K;
+            using value_type = std::pair<const K, V>;
+
+            static const K& key(const value_type& value);
+        };
+
+        template <typename K>
+        struct FlatHashSetTraits {
+            using key_type = K;
+            using value_type = K;
+
+            static const K& key(const value_type& value);
+        };
+
+    }
+
+    template <typename K, typename V, typename H = Hash<K>, typename E = std::equal_to<>>
+    class FlatHashMap : public detail::FlatHashTable<detail::FlatHashMapTraits<K, V>, H, E> {
+        public:
+            using Base = detail::FlatHashTable<detail::FlatHashMapTraits<K, V>, H, E>;
+            using mapped_type = V;
+            using typename Base::iterator;
+            using typename Base::const_iterator;
+
+            using Base::Base;
+
+            // Default-constructs the mapped value if 'key' is not present
+            V& operator[](const K& key);
+            V& operator[](K&& key);
+
+            // Throws std::out_of_range if 'key' is not present
+            template <typename Q = K>
+            [[nodiscard]] V& at(const Q& key);
+
+            template <typename Q = K>
+            [[nodiscard]] const V& at(const Q& key) const;
+
+            // Constructs the mapped value from 'args' only if 'key' is not already present
+            template <typename ...Ts>
+            std::pair<iterator, bool> try_emplace(const K& key, Ts&&... args);
+
+            template <typename ...Ts>
+            std::pair<iterator, bool> try_emplace(K&& key, Ts&&... args);
+    };
+
+    template <typename K, typename H = Hash<K>, typename E = std::equal_to<>>
+    class FlatHashSet : public detail::FlatHashTable<detail::FlatHashSetTraits<K>, H, E> {
+        public:
+            using Base = detail::FlatHashTable<detail::FlatHashSetTraits<K>, H, E>;
+            using Base::Base;
+    };
+
+}
+
+// Template definitions
+#include "utils/detail/flat_hash_map.tpp"
+
+#endif // UTILS_FLAT_HASH_MAP_HPP
@@ -0,0 +1,71 @@
+
+#ifndef UTILS_FUNCTION_HPP
+#define UTILS_FUNCTION_HPP
+
+#include "utils/memory.hpp"
+#include <cstddef> // std::size_t, std::max_align_t
+#include <type_traits> // std::is_invocable_r
+
+namespace utils {
+
+    namespace detail {
+
+        // Type-erased callable stored entirely within an inline buffer of 'Capacity' bytes (never allocates)
+        // Callables that do not fit the buffer are rejected at compile time
+        template <typename Signature, std::size_t Capacity, bool Copyable>
+        class InplaceFunction;
+
+        template <typename R, typename ...Args, std::size_t Capacity, bool Copyable>
+        class InplaceFunction<R(Args...), Capacity, Copyable> {
+            public:
+                InplaceFunction();
+                InplaceFunction(std::nullptr_t);
+
+                template <typename Fn> requires (!std::is_same<std::decay_t<Fn>, InplaceFunction>::value && std::is_invocable_r<R, std::decay_t<Fn>&, Args...>::value)
+                InplaceFunction(Fn&& fn);
+
+                ~InplaceFunction();
+
+                InplaceFunction(const InplaceFunction& other) requires (Copyable);
+                InplaceFunction& operator=(const InplaceFunction& other) requires (Copyable);
+
+                InplaceFunction(InplaceFunction&& other) noexcept;
+                InplaceFunction& operator=(InplaceFunction&& other) noexcept;
+
+                R operator()(Args... args) const;
+
+                [[nodiscard]] explicit operator bool() const;
+
+            private:
+                using Invoker = R (*)(void* fn, Args&&... args);
+
+                // Destroys the stored callable (if any) and leaves this function empty
+                void clear();
+
+                // Moves the callable stored in 'other' into this (empty) function, leaving 'other' empty
+                void relocate_from(InplaceFunction& other);
+
+                alignas(std::max_align_t) mutable std::byte m_storage[Capacity];
+
+                Invoker m_invoke;
+                Destructor m_destructor; // nullptr for trivially destructible callables
+                Relocator m_relocate; // nullptr for trivially relocatable callables, which are moved with memcpy
+                CopyConstructor m_copy_constructor; // nullptr for trivially copyable callables, unused for move-only functions
+        };
+
+    }
+
+    // Copyable small-buffer replacement for std::function
+    template <typename Signature, std::size_t Capacity = 4 * sizeof(void*)>
+    using InplaceFunction = detail::InplaceFunction<Signature, Capacity, true>;
+
+    // Move-only variant, accepts callables that capture move-only state (such as std::unique_ptr)
+    template <typename Signature, std::size_t Capacity = 4 * sizeof(void*)>
+    using MoveOnlyInplaceFunction = detail::InplaceFunction<Signature, Capacity, false>;
+
+}
+
+// Template definitions
+#include "utils/detail/function.tpp"
+
+#endif // UTILS_FUNCTION_HPP
@@ -3,7 +3,11 @@
 #define UTILS_HASH_HPP
 
 #include <cstddef>
+#include <cstdint> // std::uint64_t
+#include <string> // std::string
 #include <string_view>
+#include <tuple> // std::tuple
+#include <utility> // std::pair
 
 namespace utils {
     
@@ -22,6 +26,67 @@ namespace utils {
         }
         return hash;
     }
+
+    // 64-bit non-cryptographic hash based on wyhash (final version 4), consumes 16 bytes per step and 48 bytes per step (across three independent lanes) for larger inputs
+    // Produces identical results at compile time and at runtime
+    constexpr std::uint64_t hash64(std::string_view data, std::uint64_t seed = 0);
+
+    // Hashes the raw bytes of [data, data + length) in a single pass
+    [[nodiscard]] std::uint64_t hash_bytes(const void* data, std::size_t length, std::uint64_t seed = 0);
+
+    // Hash functor that hashes the object representation of a value in one pass wherever that is valid (types without padding or multiple representations of equal values)
+    // Supports std::pair, std::tuple, string types (transparently), and ranges of hashable elements, other types fall back to std::hash
+    template <typename T>
+    struct Hash {
+        [[nodiscard]] std::size_t operator()(const T& value) const;
+    };
+
+    // String hashes are transparent: containers keyed on std::string can be queried with std::string_view / const char* without constructing a temporary string
+    template <>
+    struct Hash<std::string> {
+        using is_transparent = void;
+        [[nodiscard]] std::size_t operator()(std::string_view value) const;
+    };
+
+    template <>
+    struct Hash<std::string_view> {
+        using is_transparent = void;
+        [[nodiscard]] std::size_t operator()(std::string_view value) const;
+    };
+
+    template <typename T, typename U>
+    struct Hash<std::pair<T, U>> {
+        [[nodiscard]] std::size_t operator()(const std::pair<T, U>& value) const;
+    };
+
+    template <typename ...Ts>
+    struct Hash<std::tuple<Ts...>> {
+        [[nodiscard]] std::size_t operator()(const std::tuple<Ts...>& value) const;
+    };
+
+    // Combined hash of multiple values, computed with a single call to hash64 (instead of a chain of hash_combine calls)
+    template <typename ...Ts>
+    [[nodiscard]] std::size_t hash_values(const Ts&... values);
+
+    // Incremental interface to hash64, produces the same result as hashing the concatenation of all updates in one call
+    class Hasher64 {
+        public:
+            constexpr explicit Hasher64(std::uint64_t seed = 0);
+
+            constexpr Hasher64& update(std::string_view data);
+            [[nodiscard]] constexpr std::uint64_t digest() const;
+
+        private:
+            static constexpr std::size_t STRIPE_SIZE = 48;
+            static constexpr std::size_t TAIL_SIZE = 16; // Final reads may reach up to 16 bytes back into an already-consumed stripe
+
+            std::uint64_t m_seed;
+            std::uint64_t m_lanes[2];
+            std::uint64_t m_length; // Total number of bytes consumed
+
+            char m_buffer[TAIL_SIZE + STRIPE_SIZE]; // [ tail of the last stripe | pending bytes ]
+            std::size_t m_buffered; // Number of pending bytes
+    };
     
 }
 
@@ -0,0 +1,85 @@
+
+#ifndef UTILS_INTERNER_HPP
+#define UTILS_INTERNER_HPP
+
+#include "utils/allocator.hpp"
+#include <array> // std::array
+#include <atomic> // std::atomic
+#include <cstddef> // std::size_t
+#include <cstdint> // std::uint32_t, std::uint64_t
+#include <memory> // std::unique_ptr
+#include <mutex> // std::mutex
+#include <optional> // std::optional
+#include <string_view> // std::string_view
+#include <vector> // std::vector
+
+namespace utils {
+
+    // Maps strings to dense 32-bit atoms (0, 1, 2, ... in order of first insertion), so that repeated strings are stored once and can be compared / hashed as integers
+    // Thread-safe: lookups never lock, insertions lock one of several shards (selected by hash) so that unrelated insertions rarely contend
+    // Interned strings remain valid (and null-terminated) for the lifetime of the interner
+    class StringInterner {
+        public:
+            using Atom = std::uint32_t;
+
+            StringInterner();
+            ~StringInterner();
+
+            StringInterner(const StringInterner&) = delete;
+            StringInterner& operator=(const StringInterner&) = delete;
+
+            // Returns the atom for 'value', inserting it if it has not been interned before
+            Atom intern(std::string_view value);
+
+            // Returns std::nullopt if 'value' has not been interned
+            [[nodiscard]] std::optional<Atom> find(std::string_view value) const;
+
+            // 'atom' must have been returned by this interner
+            [[nodiscard]] std::string_view lookup(Atom atom) const;
+
+            // Number of unique strings interned
+            [[nodiscard]] std::size_t size() const;
+
+        private:
+            static constexpr std::size_t SHARD_COUNT = 16;
+
+            // Atom -> string storage is split into segments of doubling size so that existing entries are never moved as more strings are interned
+            static constexpr std::size_t FIRST_SEGMENT_SIZE = 1024;
+            static constexpr std::size_t SEGMENT_COUNT = 23; // FIRST_SEGMENT_SIZE * (2^23 - 1) covers the entire 32-bit atom range
+
+            // Open-addressing table of (hash tag, atom + 1) pairs packed into a single word, 0 marks an empty slot
+            struct Table {
+                explicit Table(std::size_t capacity);
+
+                std::size_t capacity; // Power of two
+                std::unique_ptr<std::atomic<std::uint64_t>[]> slots;
+            };
+
+            struct alignas(64) Shard {
+                Shard();
+
+                std::mutex mutex; // Held by writers only
+                std::atomic<Table*> table;
+
+                std::vector<std::unique_ptr<Table>> tables; // Tables replaced by growth are kept alive for readers that may still be probing them
+                std::size_t size;
+
+                BumpAllocator strings;
+            };
+
+            [[nodiscard]] std::optional<Atom> find(std::string_view value, std::uint64_t hash, const Shard& shard) const;
+
+            // Inserts an existing entry into 'table', which must have a free slot (caller holds the shard lock)
+            static void insert(Table& table, std::uint64_t hash, Atom atom);
+
+            [[nodiscard]] std::string_view& entry(Atom atom) const;
+
+            std::array<Shard, SHARD_COUNT> m_shards;
+
+            mutable std::array<std::atomic<std::string_view*>, SEGMENT_COUNT> m_segments;
+            std::atomic<std::uint32_t> m_size;
+    };
+
+}
+
+#endif // UTILS_INTERNER_HPP
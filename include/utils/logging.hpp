@@ -2,33 +2,213 @@
 #ifndef UTILS_LOGGING_HPP
 #define UTILS_LOGGING_HPP
 
+#include "utils/function.hpp"
+#include "utils/memory.hpp"
+#include "utils/result.hpp"
 #include "utils/string.hpp"
 #include <spdlog/fwd.h>
+#include <spdlog/common.h>
+#include <atomic> // std::atomic
+#include <chrono> // std::chrono::milliseconds, std::chrono::system_clock
+#include <cstdint> // std::int64_t, std::uint32_t, std::uint64_t
+#include <filesystem> // std::filesystem::path
+#include <istream> // std::istream
 #include <memory>
 
+#define UTILS_LOGGING_LEVEL_DEBUG 0
+#define UTILS_LOGGING_LEVEL_INFO 1
+#define UTILS_LOGGING_LEVEL_WARNING 2
+#define UTILS_LOGGING_LEVEL_ERROR 3
+#define UTILS_LOGGING_LEVEL_OFF 4
+
+// Messages below this level are removed at compile time, including the evaluation of their arguments when logged through the LOG_* macros
+#if !defined UTILS_LOGGING_LEVEL
+    #define UTILS_LOGGING_LEVEL UTILS_LOGGING_LEVEL_DEBUG
+#endif
+
 namespace utils {
 
     namespace logging {
 
+        enum class Level : int {
+            Debug = UTILS_LOGGING_LEVEL_DEBUG,
+            Info = UTILS_LOGGING_LEVEL_INFO,
+            Warning = UTILS_LOGGING_LEVEL_WARNING,
+            Error = UTILS_LOGGING_LEVEL_ERROR,
+            Off = UTILS_LOGGING_LEVEL_OFF
+        };
+
+        inline constexpr Level MINIMUM_LEVEL = static_cast<Level>(UTILS_LOGGING_LEVEL);
+
+        class Tag;
+
+        namespace detail {
+            class TagRegistry;
+        }
+
+        // Messages below the runtime level are discarded before any work is done on their arguments (a single relaxed atomic load)
+        // Applies to all messages, except those logged with a tag that has its own level
+        void set_level(Level level);
+        [[nodiscard]] Level get_level();
+
+        // Sets the level of all tags named 'tag', including tags that are created later
+        void set_level(std::string_view tag, Level level);
+
+        // Returns the tag to the runtime level
+        void reset_level(std::string_view tag);
+
+        [[nodiscard]] bool enabled(Level level);
+
+        // Identifies the module a message is logged from, so that its messages can be filtered separately, e.g.:
+        //   inline utils::logging::Tag network("network");
+        //   utils::logging::debug(network, "received {} bytes", size);
+        // Tags cache the level that applies to them, so that checking it costs no more than checking the runtime level
+        class Tag {
+            public:
+                explicit Tag(std::string_view name);
+                ~Tag();
+
+                Tag(const Tag&) = delete;
+                Tag& operator=(const Tag&) = delete;
+
+                [[nodiscard]] std::string_view name() const;
+                [[nodiscard]] bool enabled(Level level) const;
+
+            private:
+                friend class detail::TagRegistry;
+
+                std::string m_name;
+                std::atomic<int> m_level;
+                bool m_override; // Level was set for this tag, rather than following the runtime level (guarded by the registry)
+        };
+
+        // Admits messages at a sustained rate of 'rate' messages per second, with bursts of up to 'burst' messages (token bucket)
+        // Held by a call site (see the LOG_*_RATE_LIMITED macros), checking it is a single compare-and-swap and never locks or allocates
+        class RateLimiter {
+            public:
+                explicit RateLimiter(double rate, std::uint32_t burst = 1u);
+
+                RateLimiter(const RateLimiter&) = delete;
+                RateLimiter& operator=(const RateLimiter&) = delete;
+
+                [[nodiscard]] bool admit();
+
+                // Returns the number of messages that were not admitted since the last call
+                [[nodiscard]] std::size_t suppressed();
+
+            private:
+                std::int64_t m_interval; // Nanoseconds between tokens
+                std::int64_t m_tolerance; // How far ahead of the current time 'm_next' may be while a token is available
+                std::atomic<std::int64_t> m_next; // Time at which the next token becomes available, if none are used before then
+                std::atomic<std::size_t> m_suppressed;
+        };
+
+        // Admits one in every 'n' messages, starting with the first
+        // Held by a call site (see the LOG_*_SAMPLED macros), checking it is a single atomic increment
+        class Sampler {
+            public:
+                explicit Sampler(std::uint32_t n);
+
+                Sampler(const Sampler&) = delete;
+                Sampler& operator=(const Sampler&) = delete;
+
+                [[nodiscard]] bool admit();
+
+                // Returns the number of messages that were not admitted since the last call
+                [[nodiscard]] std::size_t suppressed();
+
+            private:
+                std::uint64_t m_n;
+                std::atomic<std::uint64_t> m_count;
+                std::atomic<std::uint64_t> m_reported; // Value of 'm_count' at the last call to suppressed()
+        };
+
         // Sets the pattern used to format every subsequent log message
         void set_pattern(std::string_view pattern);
 
         void add_sink(std::shared_ptr<spdlog::sinks::sink> sink);
         void remove_sink(std::shared_ptr<spdlog::sinks::sink> sink);
 
+        // Behavior of a thread whose buffer has no space left for a message
+        enum class OverflowPolicy {
+            Block, // Wait for the background thread to write queued messages
+            Drop // Discard the message (dropped messages are counted, and periodically reported as a warning)
+        };
+
+        struct AsyncOptions {
+            std::size_t buffer_size = kilobytes(256); // Capacity of the buffer of each logging thread, rounded up to a power of two
+            OverflowPolicy overflow = OverflowPolicy::Block;
+            std::chrono::milliseconds interval { 5 }; // Longest delay between a message being logged and written, while buffers are less than half full
+        };
+
+        // Moves formatting and writing of messages to a background thread
+        // The logging thread copies the arguments of a message into a buffer that is private to it (without locking): strings are copied, and other
+        // trivially copyable values are stored by value and formatted later, so they must not refer to memory that may be released after the call
+        // Messages with any other arguments are formatted by the logging thread, and only written by the background thread
+        // Messages logged by the same thread are written in the order they were logged, messages from different threads may be interleaved in a different
+        // order (each is written with the time and thread it was logged from)
+        // Messages logged on the background thread itself (by user-defined formatters) are written synchronously
+        // Failures of sinks, and of the binary log, are reported as errors to the sinks that are still working
+        void enable_async(const AsyncOptions& options = { });
+
+        // Writes all queued messages and returns to formatting and writing messages on the logging thread
+        void disable_async();
+
+        // Blocks until every message logged (by any thread) before the call has been written, and flushes all sinks
+        void flush();
+
+        // Number of messages discarded under OverflowPolicy::Drop
+        [[nodiscard]] std::size_t dropped_messages();
+
+        // Enables asynchronous logging, with messages written to 'path' in a compact binary form instead of to the sinks (until disable_async() is called)
+        // Each call site is recorded once, with its format string, location, and argument types, after which its messages are recorded as the raw bytes of
+        // their arguments (with the time and thread they were logged from), and are formatted offline by decode_binary_log()
+        // Only arguments of fundamental types, strings, and void pointers (and named arguments of these) are recorded as-is, messages with any other argument
+        // are formatted by the logging thread and recorded as text, as are messages with format strings that are not literals
+        [[nodiscard]] Result<void> enable_binary(const std::filesystem::path& path, const AsyncOptions& options = { });
+
+        struct DecodedMessage {
+            std::chrono::system_clock::time_point time;
+            std::size_t thread;
+            spdlog::level::level_enum level;
+            std::string_view file;
+            std::uint32_t line;
+            std::string_view function;
+            std::string_view message;
+        };
+
+        // Reconstructs the messages of a binary log in the order they were written, invoking 'callback' with each
+        // Messages that fail to format are passed with a description of the error
+        // Arguments are recorded in the byte order of the writer, logs written with a different byte order are rejected
+        [[nodiscard]] Result<void> decode_binary_log(std::istream& stream, const InplaceFunction<void(const DecodedMessage&)>& callback);
+
+        // Arguments are still evaluated by the caller if the message is discarded, prefer the LOG_* macros for messages that are often disabled
         template <typename ...Args>
         void info(FormatString fmt, const Args&... args);
 
+        template <typename ...Args>
+        void info(const Tag& tag, FormatString fmt, const Args&... args);
+
         template <typename ...Args>
         void debug(FormatString fmt, const Args&... args);
 
+        template <typename ...Args>
+        void debug(const Tag& tag, FormatString fmt, const Args&... args);
+
         template <typename ...Args>
         void warning(FormatString fmt, const Args&... args);
 
+        template <typename ...Args>
+        void warning(const Tag& tag, FormatString fmt, const Args&... args);
+
         template <typename ...Args>
         void error(FormatString fmt, const Args&... args);
 
-        // Logs an error message and raises a std::runtime_error
+        template <typename ...Args>
+        void error(const Tag& tag, FormatString fmt, const Args&... args);
+
+        // Logs an error message and raises a std::runtime_error, regardless of the level
+        // Queued messages, and the message itself, are written and flushed before returning
         template <typename ...Args>
         [[noreturn]] void fatal(FormatString fmt, const Args&... args);
 
@@ -36,6 +216,110 @@ namespace utils {
 
 }
 
+// Messages are only constructed (and their arguments evaluated) if they pass the compile-time and runtime level checks
+#if UTILS_LOGGING_LEVEL <= UTILS_LOGGING_LEVEL_DEBUG
+    #define LOG_DEBUG(FMT, ...) do { if (utils::logging::detail::enabled(utils::logging::Level::Debug)) { utils::logging::detail::log(spdlog::level::debug, FMT, ##__VA_ARGS__); } } while (false)
+    #define LOG_DEBUG_TAG(TAG, FMT, ...) do { if ((TAG).enabled(utils::logging::Level::Debug)) { utils::logging::detail::log(spdlog::level::debug, FMT, ##__VA_ARGS__); } } while (false)
+#else
+    #define LOG_DEBUG(FMT, ...) do { } while (false)
+    #define LOG_DEBUG_TAG(TAG, FMT, ...) do { } while (false)
+#endif
+
+#if UTILS_LOGGING_LEVEL <= UTILS_LOGGING_LEVEL_INFO
+    #define LOG_INFO(FMT, ...) do { if (utils::logging::detail::enabled(utils::logging::Level::Info)) { utils::logging::detail::log(spdlog::level::info, FMT, ##__VA_ARGS__); } } while (false)
+    #define LOG_INFO_TAG(TAG, FMT, ...) do { if ((TAG).enabled(utils::logging::Level::Info)) { utils::logging::detail::log(spdlog::level::info, FMT, ##__VA_ARGS__); } } while (false)
+#else
+    #define LOG_INFO(FMT, ...) do { } while (false)
+    #define LOG_INFO_TAG(TAG, FMT, ...) do { } while (false)
+#endif
+
+#if UTILS_LOGGING_LEVEL <= UTILS_LOGGING_LEVEL_WARNING
+    #define LOG_WARNING(FMT, ...) do { if (utils::logging::detail::enabled(utils::logging::Level::Warning)) { utils::logging::detail::log(spdlog::level::warn, FMT, ##__VA_ARGS__); } } while (false)
+    #define LOG_WARNING_TAG(TAG, FMT, ...) do { if ((TAG).enabled(utils::logging::Level::Warning)) { utils::logging::detail::log(spdlog::level::warn, FMT, ##__VA_ARGS__); } } while (false)
+#else
+    #define LOG_WARNING(FMT, ...) do { } while (false)
+    #define LOG_WARNING_TAG(TAG, FMT, ...) do { } while (false)
+#endif
+
+#if UTILS_LOGGING_LEVEL <= UTILS_LOGGING_LEVEL_ERROR
+    #define LOG_ERROR(FMT, ...) do { if (utils::logging::detail::enabled(utils::logging::Level::Error)) { utils::logging::detail::log(spdlog::level::err, FMT, ##__VA_ARGS__); } } while (false)
+    #define LOG_ERROR_TAG(TAG, FMT, ...) do { if ((TAG).enabled(utils::logging::Level::Error)) { utils::logging::detail::log(spdlog::level::err, FMT, ##__VA_ARGS__); } } while (false)
+#else
+    #define LOG_ERROR(FMT, ...) do { } while (false)
+    #define LOG_ERROR_TAG(TAG, FMT, ...) do { } while (false)
+#endif
+
+// Per-call-site rate limiting, for messages that may be logged from hot loops
+// The limiter is a static variable of the call site, and is only checked once the message has passed the level checks
+// The number of messages suppressed by the limiter is reported along with the next message it admits, or by utils::logging::flush() (and periodically
+// while asynchronous logging is enabled) if there is none
+// LIMITER is parenthesized by the callers, as it may contain commas
+#define UTILS_LOGGING_LIMITED(ENABLED, SPDLOG_LEVEL, LIMITER, FMT, ...) do { if (ENABLED) { static auto utils_logging_limiter = LIMITER; static utils::logging::detail::LimiterSite utils_logging_site(utils_logging_limiter, spdlog::level::SPDLOG_LEVEL); if (utils_logging_limiter.admit()) { utils::logging::detail::log_limited(utils_logging_limiter, spdlog::level::SPDLOG_LEVEL, FMT, ##__VA_ARGS__); } } } while (false)
+
+#if UTILS_LOGGING_LEVEL <= UTILS_LOGGING_LEVEL_DEBUG
+    #define LOG_DEBUG_RATE_LIMITED(RATE, FMT, ...) UTILS_LOGGING_LIMITED(utils::logging::detail::enabled(utils::logging::Level::Debug), debug, (utils::logging::RateLimiter(RATE)), FMT, ##__VA_ARGS__)
+    #define LOG_DEBUG_RATE_LIMITED_BURST(RATE, BURST, FMT, ...) UTILS_LOGGING_LIMITED(utils::logging::detail::enabled(utils::logging::Level::Debug), debug, (utils::logging::RateLimiter(RATE, BURST)), FMT, ##__VA_ARGS__)
+    #define LOG_DEBUG_SAMPLED(N, FMT, ...) UTILS_LOGGING_LIMITED(utils::logging::detail::enabled(utils::logging::Level::Debug), debug, (utils::logging::Sampler(N)), FMT, ##__VA_ARGS__)
+    #define LOG_DEBUG_RATE_LIMITED_TAG(TAG, RATE, FMT, ...) UTILS_LOGGING_LIMITED((TAG).enabled(utils::logging::Level::Debug), debug, (utils::logging::RateLimiter(RATE)), FMT, ##__VA_ARGS__)
+    #define LOG_DEBUG_RATE_LIMITED_BURST_TAG(TAG, RATE, BURST, FMT, ...) UTILS_LOGGING_LIMITED((TAG).enabled(utils::logging::Level::Debug), debug, (utils::logging::RateLimiter(RATE, BURST)), FMT, ##__VA_ARGS__)
+    #define LOG_DEBUG_SAMPLED_TAG(TAG, N, FMT, ...) UTILS_LOGGING_LIMITED((TAG).enabled(utils::logging::Level::Debug), debug, (utils::logging::Sampler(N)), FMT, ##__VA_ARGS__)
+#else
+    #define LOG_DEBUG_RATE_LIMITED(RATE, FMT, ...) do { } while (false)
+    #define LOG_DEBUG_RATE_LIMITED_BURST(RATE, BURST, FMT, ...) do { } while (false)
+    #define LOG_DEBUG_SAMPLED(N, FMT, ...) do { } while (false)
+    #define LOG_DEBUG_RATE_LIMITED_TAG(TAG, RATE, FMT, ...) do { } while (false)
+    #define LOG_DEBUG_RATE_LIMITED_BURST_TAG(TAG, RATE, BURST, FMT, ...) do { } while (false)
+    #define LOG_DEBUG_SAMPLED_TAG(TAG, N, FMT, ...) do { } while (false)
+#endif
+
+#if UTILS_LOGGING_LEVEL <= UTILS_LOGGING_LEVEL_INFO
+    #define LOG_INFO_RATE_LIMITED(RATE, FMT, ...) UTILS_LOGGING_LIMITED(utils::logging::detail::enabled(utils::logging::Level::Info), info, (utils::logging::RateLimiter(RATE)), FMT, ##__VA_ARGS__)
+    #define LOG_INFO_RATE_LIMITED_BURST(RATE, BURST, FMT, ...) UTILS_LOGGING_LIMITED(utils::logging::detail::enabled(utils::logging::Level::Info), info, (utils::logging::RateLimiter(RATE, BURST)), FMT, ##__VA_ARGS__)
+    #define LOG_INFO_SAMPLED(N, FMT, ...) UTILS_LOGGING_LIMITED(utils::logging::detail::enabled(utils::logging::Level::Info), info, (utils::logging::Sampler(N)), FMT, ##__VA_ARGS__)
+    #define LOG_INFO_RATE_LIMITED_TAG(TAG, RATE, FMT, ...) UTILS_LOGGING_LIMITED((TAG).enabled(utils::logging::Level::Info), info, (utils::logging::RateLimiter(RATE)), FMT, ##__VA_ARGS__)
+    #define LOG_INFO_RATE_LIMITED_BURST_TAG(TAG, RATE, BURST, FMT, ...) UTILS_LOGGING_LIMITED((TAG).enabled(utils::logging::Level::Info), info, (utils::logging::RateLimiter(RATE, BURST)), FMT, ##__VA_ARGS__)
+    #define LOG_INFO_SAMPLED_TAG(TAG, N, FMT, ...) UTILS_LOGGING_LIMITED((TAG).enabled(utils::logging::Level::Info), info, (utils::logging::Sampler(N)), FMT, ##__VA_ARGS__)
+#else
+    #define LOG_INFO_RATE_LIMITED(RATE, FMT, ...) do { } while (false)
+    #define LOG_INFO_RATE_LIMITED_BURST(RATE, BURST, FMT, ...) do { } while (false)
+    #define LOG_INFO_SAMPLED(N, FMT, ...) do { } while (false)
+    #define LOG_INFO_RATE_LIMITED_TAG(TAG, RATE, FMT, ...) do { } while (false)
+    #define LOG_INFO_RATE_LIMITED_BURST_TAG(TAG, RATE, BURST, FMT, ...) do { } while (false)
+    #define LOG_INFO_SAMPLED_TAG(TAG, N, FMT, ...) do { } while (false)
+#endif
+
+#if UTILS_LOGGING_LEVEL <= UTILS_LOGGING_LEVEL_WARNING
+    #define LOG_WARNING_RATE_LIMITED(RATE, FMT, ...) UTILS_LOGGING_LIMITED(utils::logging::detail::enabled(utils::logging::Level::Warning), warn, (utils::logging::RateLimiter(RATE)), FMT, ##__VA_ARGS__)
+    #define LOG_WARNING_RATE_LIMITED_BURST(RATE, BURST, FMT, ...) UTILS_LOGGING_LIMITED(utils::logging::detail::enabled(utils::logging::Level::Warning), warn, (utils::logging::RateLimiter(RATE, BURST)), FMT, ##__VA_ARGS__)
+    #define LOG_WARNING_SAMPLED(N, FMT, ...) UTILS_LOGGING_LIMITED(utils::logging::detail::enabled(utils::logging::Level::Warning), warn, (utils::logging::Sampler(N)), FMT, ##__VA_ARGS__)
+    #define LOG_WARNING_RATE_LIMITED_TAG(TAG, RATE, FMT, ...) UTILS_LOGGING_LIMITED((TAG).enabled(utils::logging::Level::Warning), warn, (utils::logging::RateLimiter(RATE)), FMT, ##__VA_ARGS__)
+    #define LOG_WARNING_RATE_LIMITED_BURST_TAG(TAG, RATE, BURST, FMT, ...) UTILS_LOGGING_LIMITED((TAG).enabled(utils::logging::Level::Warning), warn, (utils::logging::RateLimiter(RATE, BURST)), FMT, ##__VA_ARGS__)
+    #define LOG_WARNING_SAMPLED_TAG(TAG, N, FMT, ...) UTILS_LOGGING_LIMITED((TAG).enabled(utils::logging::Level::Warning), warn, (utils::logging::Sampler(N)), FMT, ##__VA_ARGS__)
+#else
+    #define LOG_WARNING_RATE_LIMITED(RATE, FMT, ...) do { } while (false)
+    #define LOG_WARNING_RATE_LIMITED_BURST(RATE, BURST, FMT, ...) do { } while (false)
+    #define LOG_WARNING_SAMPLED(N, FMT, ...) do { } while (false)
+    #define LOG_WARNING_RATE_LIMITED_TAG(TAG, RATE, FMT, ...) do { } while (false)
+    #define LOG_WARNING_RATE_LIMITED_BURST_TAG(TAG, RATE, BURST, FMT, ...) do { } while (false)
+    #define LOG_WARNING_SAMPLED_TAG(TAG, N, FMT, ...) do { } while (false)
+#endif
+
+#if UTILS_LOGGING_LEVEL <= UTILS_LOGGING_LEVEL_ERROR
+    #define LOG_ERROR_RATE_LIMITED(RATE, FMT, ...) UTILS_LOGGING_LIMITED(utils::logging::detail::enabled(utils::logging::Level::Error), err, (utils::logging::RateLimiter(RATE)), FMT, ##__VA_ARGS__)
+    #define LOG_ERROR_RATE_LIMITED_BURST(RATE, BURST, FMT, ...) UTILS_LOGGING_LIMITED(utils::logging::detail::enabled(utils::logging::Level::Error), err, (utils::logging::RateLimiter(RATE, BURST)), FMT, ##__VA_ARGS__)
+    #define LOG_ERROR_SAMPLED(N, FMT, ...) UTILS_LOGGING_LIMITED(utils::logging::detail::enabled(utils::logging::Level::Error), err, (utils::logging::Sampler(N)), FMT, ##__VA_ARGS__)
+    #define LOG_ERROR_RATE_LIMITED_TAG(TAG, RATE, FMT, ...) UTILS_LOGGING_LIMITED((TAG).enabled(utils::logging::Level::Error), err, (utils::logging::RateLimiter(RATE)), FMT, ##__VA_ARGS__)
+    #define LOG_ERROR_RATE_LIMITED_BURST_TAG(TAG, RATE, BURST, FMT, ...) UTILS_LOGGING_LIMITED((TAG).enabled(utils::logging::Level::Error), err, (utils::logging::RateLimiter(RATE, BURST)), FMT, ##__VA_ARGS__)
+    #define LOG_ERROR_SAMPLED_TAG(TAG, N, FMT, ...) UTILS_LOGGING_LIMITED((TAG).enabled(utils::logging::Level::Error), err, (utils::logging::Sampler(N)), FMT, ##__VA_ARGS__)
+#else
+    #define LOG_ERROR_RATE_LIMITED(RATE, FMT, ...) do { } while (false)
+    #define LOG_ERROR_RATE_LIMITED_BURST(RATE, BURST, FMT, ...) do { } while (false)
+    #define LOG_ERROR_SAMPLED(N, FMT, ...) do { } while (false)
+    #define LOG_ERROR_RATE_LIMITED_TAG(TAG, RATE, FMT, ...) do { } while (false)
+    #define LOG_ERROR_RATE_LIMITED_BURST_TAG(TAG, RATE, BURST, FMT, ...) do { } while (false)
+    #define LOG_ERROR_SAMPLED_TAG(TAG, N, FMT, ...) do { } while (false)
+#endif
+
 // Template definitions
 #include "utils/detail/logging.tpp"
 
@@ -3,13 +3,18 @@
 #define UTILS_MEMORY_HPP
 
 #include <cstddef> // std::size_t
-#include <utility> // std::move
+#include <utility> // std::move, std::pair
+#include <type_traits> // std::is_trivially_copyable
+#include <memory> // std::unique_ptr, std::shared_ptr, std::weak_ptr
+#include <vector> // std::vector
+#include <string> // std::basic_string
 
 namespace utils {
     
     using Destructor = void (*)(void* obj);
     using CopyConstructor = void (*)(void* dst, const void* src);
     using MoveConstructor = void (*)(void* dst, void* src);
+    using Relocator = void (*)(void* dst, void* src) noexcept; // Moves 'src' into 'dst' and destroys 'src'
     
     template <typename T>
     constexpr Destructor get_destructor();
@@ -20,6 +25,45 @@ namespace utils {
     template <typename T>
     constexpr MoveConstructor get_move_constructor();
     
+    // Types whose objects can be moved to a new address by copying their bytes, after which the source is considered destroyed (its destructor is not run)
+    // All trivially copyable types qualify, other types opt in by specializing this trait
+    template <typename T>
+    struct is_trivially_relocatable : std::is_trivially_copyable<T> { };
+    
+    template <typename T>
+    inline constexpr bool is_trivially_relocatable_v = is_trivially_relocatable<T>::value;
+    
+    template <typename T>
+    struct is_trivially_relocatable<std::unique_ptr<T>> : std::true_type { };
+    
+    template <typename T>
+    struct is_trivially_relocatable<std::shared_ptr<T>> : std::true_type { };
+    
+    template <typename T>
+    struct is_trivially_relocatable<std::weak_ptr<T>> : std::true_type { };
+    
+    template <typename T>
+    struct is_trivially_relocatable<std::vector<T>> : std::true_type { };
+    
+#if defined(_LIBCPP_VERSION)
+    // libstdc++ and MSVC point the small-string buffer back into the string object itself, only libc++ strings can be relocated with memcpy
+    template <typename C, typename T>
+    struct is_trivially_relocatable<std::basic_string<C, T>> : std::true_type { };
+#endif
+    
+    template <typename T, typename U>
+    struct is_trivially_relocatable<std::pair<T, U>> : std::bool_constant<is_trivially_relocatable<T>::value && is_trivially_relocatable<U>::value> { };
+    
+    // Relocates 'count' objects from 'src' into uninitialized, non-overlapping storage at 'dst'
+    // Trivially relocatable types are copied in bulk, other types are moved and destroyed one by one
+    template <typename T>
+    void relocate(T* dst, T* src, std::size_t count = 1) noexcept(is_trivially_relocatable<T>::value || std::is_nothrow_move_constructible<T>::value);
+    
+    // Returns nullptr for trivially relocatable types, which should be relocated with memcpy instead
+    // Relocators are invoked from noexcept moves, and are therefore only available for types that are nothrow move constructible
+    template <typename T>
+    constexpr Relocator get_relocator();
+    
     constexpr std::size_t bytes(std::size_t b) {
         return b;
     }
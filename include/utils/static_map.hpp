@@ -0,0 +1,91 @@
+
+#ifndef UTILS_STATIC_MAP_HPP
+#define UTILS_STATIC_MAP_HPP
+
+#include "utils/hash.hpp"
+#include <array> // std::array
+#include <bit> // std::bit_ceil
+#include <cstddef> // std::size_t
+#include <cstdint> // std::uint32_t, std::uint64_t
+#include <string_view> // std::string_view
+#include <utility> // std::pair
+
+namespace utils {
+
+    namespace detail {
+
+        // Hash used to place keys in a StaticMap, the case-insensitive variant produces the same value for keys that differ only in ASCII letter case
+        template <bool CaseInsensitive>
+        [[nodiscard]] constexpr std::uint64_t static_map_hash(std::string_view key, std::uint64_t seed);
+
+        template <bool CaseInsensitive>
+        [[nodiscard]] constexpr bool static_map_equal(std::string_view first, std::string_view second);
+
+    }
+
+    // Immutable map from a fixed set of string keys to values, backed by a perfect hash (hash-and-displace) that is computed when the map is constructed
+    // Intended to be built at compile time (constexpr), lookups then cost one hash, two table reads, and one key comparison, regardless of the number of keys
+    // Construction fails (a compile error during constant evaluation) if the set contains duplicate keys
+    template <typename V, std::size_t N, bool CaseInsensitive = false>
+    class StaticMap {
+        static_assert(N > 0, "StaticMap requires at least one key");
+
+        public:
+            using key_type = std::string_view;
+            using mapped_type = V;
+            using value_type = std::pair<std::string_view, V>;
+            using const_iterator = const value_type*;
+
+            // Keys are stored as views and must outlive the map (string literals, in the common case)
+            constexpr explicit StaticMap(const value_type (&entries)[N]);
+
+            // Returns end() if 'key' is not present
+            [[nodiscard]] constexpr const_iterator find(std::string_view key) const;
+            [[nodiscard]] constexpr bool contains(std::string_view key) const;
+
+            // Throws std::out_of_range if 'key' is not present
+            [[nodiscard]] constexpr const V& at(std::string_view key) const;
+
+            // Entries are iterated in the order they were provided
+            [[nodiscard]] constexpr const_iterator begin() const;
+            [[nodiscard]] constexpr const_iterator end() const;
+
+            [[nodiscard]] constexpr std::size_t size() const;
+
+        private:
+            static constexpr std::size_t CAPACITY = std::bit_ceil(N);
+            static constexpr std::size_t BUCKET_COUNT = std::bit_ceil((N + 3) / 4); // ~4 keys per bucket
+            static constexpr std::uint32_t UNUSED = static_cast<std::uint32_t>(N);
+
+            // Per-bucket parameters that map every key of the bucket to a distinct slot
+            struct Displacement {
+                std::uint32_t d1;
+                std::uint32_t d2;
+            };
+
+            [[nodiscard]] static constexpr std::size_t bucket(std::uint64_t hash);
+            [[nodiscard]] static constexpr std::size_t slot(std::uint64_t hash, Displacement displacement);
+
+            // Attempts to place all keys using the given seed, returns false if some bucket could not be displaced into free slots
+            constexpr bool build(std::uint64_t seed);
+
+            std::array<value_type, N> m_entries;
+            std::array<Displacement, BUCKET_COUNT> m_displacements;
+            std::array<std::uint32_t, CAPACITY> m_slots; // Index into m_entries, or UNUSED
+            std::uint64_t m_seed;
+    };
+
+    // Deduces the number of entries, e.g. constexpr auto methods = utils::make_static_map<int>({ { "GET", 1 }, { "POST", 2 } });
+    template <typename V, std::size_t N>
+    [[nodiscard]] constexpr StaticMap<V, N> make_static_map(const std::pair<std::string_view, V> (&entries)[N]);
+
+    // Keys are matched regardless of ASCII letter case (same semantics as icasecmp)
+    template <typename V, std::size_t N>
+    [[nodiscard]] constexpr StaticMap<V, N, true> make_static_icase_map(const std::pair<std::string_view, V> (&entries)[N]);
+
+}
+
+// Template definitions
+#include "utils/detail/static_map.tpp"
+
+#endif // UTILS_STATIC_MAP_HPP
@@ -9,19 +9,85 @@
 #include <thread> // std::thread
 #include <vector> // std::vector
 #include <span> // std::span
+#include <system_error> // std::errc
+#include <ranges> // std::ranges::view_interface
+#include <iterator> // std::default_sentinel_t, std::forward_iterator_tag
 #include <unordered_map> // std::unordered_map
 #include <unordered_set> // std::unordered_set
 #include <utility> // std::pair
 #include <tuple> // std::tuple
+#include <array> // std::array
+#include <deque> // std::deque
+#include <map> // std::map
+#include <set> // std::set
+#include <optional> // std::optional
+#include <limits> // std::numeric_limits
 
 namespace utils {
 
     // Returns a vector containing the result of splitting 'in' by 'delimiter'.
     [[nodiscard]] std::vector<std::string_view> split(std::string_view in, std::string_view delimiter);
 
+    // Lazy, allocation-free equivalent of split: pieces are found one delimiter at a time as the range is iterated
+    // Adjacent delimiters produce empty pieces, and an empty delimiter yields 'in' as a single piece
+    class SplitView : public std::ranges::view_interface<SplitView> {
+        public:
+            class Iterator {
+                public:
+                    using iterator_category = std::forward_iterator_tag;
+                    using value_type = std::string_view;
+                    using difference_type = std::ptrdiff_t;
+                    using pointer = const std::string_view*;
+                    using reference = std::string_view;
+
+                    Iterator();
+                    Iterator(std::string_view remaining, std::string_view delimiter);
+
+                    std::string_view operator*() const;
+
+                    Iterator& operator++();
+                    Iterator operator++(int);
+
+                    bool operator==(const Iterator& other) const;
+                    bool operator==(std::default_sentinel_t) const;
+
+                private:
+                    std::string_view m_remaining; // Input from the start of the current piece
+                    std::string_view m_delimiter;
+                    std::size_t m_length; // Length of the current piece, std::string_view::npos if it is the last piece
+                    bool m_done;
+            };
+
+            SplitView() = default;
+            SplitView(std::string_view in, std::string_view delimiter);
+
+            [[nodiscard]] Iterator begin() const;
+            [[nodiscard]] std::default_sentinel_t end() const;
+
+        private:
+            std::string_view m_in;
+            std::string_view m_delimiter;
+    };
+
+    [[nodiscard]] SplitView split_view(std::string_view in, std::string_view delimiter);
+
+    // Writes the pieces of 'in' into 'out' and returns the number of pieces written
+    // If 'in' contains more pieces than 'out' can hold, the last element of 'out' receives the remainder of the input (unsplit)
+    std::size_t split_into(std::string_view in, std::string_view delimiter, std::span<std::string_view> out);
+
+    namespace detail {
+
+        // Returns the offset of the first occurrence of 'delimiter' in 'in', or std::string_view::npos
+        // Scans 16 bytes at a time with SSE2 (32 with AVX2) where available
+        [[nodiscard]] std::size_t find_delimiter(std::string_view in, char delimiter);
+        [[nodiscard]] std::size_t find_delimiter(std::string_view in, std::string_view delimiter);
+
+    }
+
     // Trim off all whitespace characters on either side of 'in'.
     [[nodiscard]] std::string_view trim(std::string_view in);
 
+    // Case-insensitive functions below consider ASCII letters only (all other bytes must match exactly), independent of the current locale
     // std::strcasecmp requires null-terminated strings (does not work for std::string_view)
     template <String T, String U>
     [[nodiscard]] bool icasecmp(const T& first, const U& second);
@@ -29,6 +95,32 @@ namespace utils {
     template <String T, String U>
     [[nodiscard]] bool operator==(const T& first, const U& second);
 
+    [[nodiscard]] bool icase_starts_with(std::string_view in, std::string_view prefix);
+    [[nodiscard]] bool icase_ends_with(std::string_view in, std::string_view suffix);
+
+    // Returns the offset of the first case-insensitive occurrence of 'needle' in 'in', or std::string_view::npos
+    [[nodiscard]] std::size_t icase_find(std::string_view in, std::string_view needle);
+
+    // Transparent functors for hash containers with case-insensitive string keys, e.g. FlatHashMap<std::string, T, ICaseHash, ICaseEqual>
+    // ICaseHash produces the same hash as utils::Hash for the lowercase form of the string
+    struct ICaseHash {
+        using is_transparent = void;
+        [[nodiscard]] std::size_t operator()(std::string_view value) const;
+    };
+
+    struct ICaseEqual {
+        using is_transparent = void;
+        [[nodiscard]] bool operator()(std::string_view first, std::string_view second) const;
+    };
+
+    namespace detail {
+
+        // Compares / converts 'length' bytes 16 at a time with SSE2 (32 with AVX2) where available
+        [[nodiscard]] bool icase_equal(const char* first, const char* second, std::size_t length);
+        void to_lowercase(const char* in, std::size_t length, char* out);
+
+    }
+
     std::size_t from_string(std::string_view in, unsigned char& out, int base = 0);
     std::size_t from_string(std::string_view in, short& out, int base = 0);
     std::size_t from_string(std::string_view in, unsigned short& out, int base = 0);
@@ -44,6 +136,35 @@ namespace utils {
     std::size_t from_string(std::string_view in, double& out);
     std::size_t from_string(std::string_view in, long double& out);
 
+    // Outcome of a non-throwing conversion
+    struct FromStringResult {
+        std::size_t count; // Number of characters of the input consumed, including leading whitespace (try_from_string), or number of values parsed (from_string_many)
+        std::errc error; // std::errc::invalid_argument or std::errc::result_out_of_range on failure
+
+        [[nodiscard]] explicit operator bool() const; // True on success
+    };
+
+    // Non-throwing, non-allocating counterparts of from_string, accepting the same input
+    // 'out' is left unmodified on failure (including for values that are out of range for the type, which from_string clamps)
+    FromStringResult try_from_string(std::string_view in, unsigned char& out, int base = 0);
+    FromStringResult try_from_string(std::string_view in, short& out, int base = 0);
+    FromStringResult try_from_string(std::string_view in, unsigned short& out, int base = 0);
+    FromStringResult try_from_string(std::string_view in, int& out, int base = 0);
+    FromStringResult try_from_string(std::string_view in, unsigned& out, int base = 0);
+    FromStringResult try_from_string(std::string_view in, long& out, int base = 0);
+    FromStringResult try_from_string(std::string_view in, unsigned long& out, int base = 0);
+    FromStringResult try_from_string(std::string_view in, long long& out, int base = 0);
+    FromStringResult try_from_string(std::string_view in, unsigned long long& out, int base = 0);
+    FromStringResult try_from_string(std::string_view in, float& out);
+    FromStringResult try_from_string(std::string_view in, double& out);
+    FromStringResult try_from_string(std::string_view in, long double& out);
+
+    // Parses 'delimiter'-separated values from 'in' into 'out', stopping at the first invalid value or once 'out' is full (a trailing delimiter is ignored)
+    // On failure, 'count' values were parsed successfully and 'error' describes the value that follows them, elements of 'out' past the first 'count' are left unmodified
+    // Plain decimal integers take a fast path that converts 8 digits at a time, anything else is parsed as by try_from_string
+    template <typename T>
+    FromStringResult from_string_many(std::string_view in, std::string_view delimiter, std::span<T> out);
+
     // Allows a format placeholder to be referenced by name instead of by position, e.g. utils::format("{x}", NamedArgument("x", 1))
     template <typename T>
     struct NamedArgument {
@@ -64,21 +185,144 @@ namespace utils {
     struct is_named_argument<NamedArgument<T>> : std::true_type {
     };
 
-    // Captures a runtime format string together with its call site
+    // Captures a format string together with its call site
+    // String literals are validated at compile time (a malformed format string is a compile error) and parsed at most once per thread: the parsed form is
+    // cached under the address of the literal, so that subsequent calls from the same call site skip parsing entirely
     struct FormatString {
+        // Constant arrays must be usable in constant expressions (string literals, or arrays declared constexpr), and end at their first null character
+        // Other constant arrays are a compile error, and should be passed as a std::string_view (or const char*) to be parsed at runtime instead
+        template <std::size_t N>
+        consteval FormatString(const char (&format)[N], std::source_location source = std::source_location::current());
+
+        // Format strings that are not literals are parsed on every call
+        template <std::size_t N>
+        FormatString(char (&format)[N], std::source_location source = std::source_location::current());
+
+        template <typename T> requires (std::is_same<T, const char*>::value || std::is_same<T, char*>::value)
+        FormatString(T format, std::source_location source = std::source_location::current());
+
         FormatString(const std::string& format, std::source_location source = std::source_location::current());
         FormatString(std::string_view format, std::source_location source = std::source_location::current());
-        FormatString(const char* format, std::source_location source = std::source_location::current());
         ~FormatString();
 
         std::string_view format;
         std::source_location source;
+        bool literal; // Format string has static storage duration and was validated at compile time
+    };
+
+    namespace detail {
+
+        // Walks the replacement fields of 'format' ('{}', '{0}', or '{name}', each optionally followed by ':' and a format specification), invoking
+        // handler.on_text(text) for literal text (escaped braces '{{' / '}}' are passed as a single brace) and handler.on_field(index, name, specification)
+        // for each field (index is -1 for named fields)
+        // Returns nullptr on success, or a description of the first error
+        template <typename Handler>
+        constexpr const char* parse_format_string(std::string_view format, Handler& handler);
+
+        // Deliberately not constexpr: reaching a call during constant evaluation turns a malformed format string literal into a compile error
+        void invalid_format_string(const char* error);
+
+        // Length of the string stored in an array of 'size' characters, up to its first null character (arrays may be larger than their contents)
+        constexpr std::size_t literal_length(const char* format, std::size_t size);
+
+        // Appends the output to the buffer behind 'out', using the cached parsed form of literal format strings, returns the iterator past the output
+        // Throws std::runtime_error (annotated with the call site of the format string) if the format string is invalid or an argument is missing
+        fmt::appender vformat_to(fmt::appender out, const FormatString& str, fmt::format_args args);
+
+        template <typename ...Ts>
+        fmt::appender format_to(fmt::appender out, const FormatString& str, const Ts&... args);
+
+    }
+
+    // Characters are stored inline, up to a capacity of N, and on the heap only once the output grows past it
+    template <std::size_t N = fmt::inline_buffer_size>
+    class FormatBuffer {
+        public:
+            FormatBuffer();
+            ~FormatBuffer();
+
+            [[nodiscard]] const char* data() const;
+            [[nodiscard]] std::size_t size() const;
+            [[nodiscard]] bool empty() const;
+
+            [[nodiscard]] std::string_view view() const;
+            [[nodiscard]] std::string str() const;
+
+            void clear();
+
+            // Output iterator that appends to the buffer
+            [[nodiscard]] fmt::appender out();
+
+        private:
+            fmt::basic_memory_buffer<char, N> m_buffer;
+    };
+
+    template <typename OutputIt>
+    struct FormatToResult {
+        OutputIt out; // Past the last character written
+        std::size_t size; // Length of the complete output, which exceeds the number of characters written if the output was truncated
+        bool truncated;
     };
 
     // Throws std::runtime_error if the format string is invalid or an argument is missing
     template <typename ...Ts>
     std::string format(const FormatString& str, const Ts&... args);
 
+    // Writes the output to 'out', returns the iterator past the last character written
+    // Output is written directly into fmt buffers (through fmt::appender), other iterators receive it through a memory buffer with inline storage for
+    // fmt::inline_buffer_size characters, which only allocates for longer output
+    template <std::output_iterator<char> OutputIt, typename ...Ts>
+    OutputIt format_to(OutputIt out, const FormatString& str, const Ts&... args);
+
+    // Appends the output to 'buffer', returns the contents of the buffer
+    template <std::size_t N, typename ...Ts>
+    std::string_view format_to(FormatBuffer<N>& buffer, const FormatString& str, const Ts&... args);
+
+    // Writes at most 'n' characters of the output to 'out'
+    template <std::output_iterator<char> OutputIt, typename ...Ts>
+    FormatToResult<OutputIt> format_to_n(OutputIt out, std::size_t n, const FormatString& str, const Ts&... args);
+
+    // Returns the length of the output, without writing it
+    template <typename ...Ts>
+    std::size_t formatted_size(const FormatString& str, const Ts&... args);
+
+    // Maximum number of elements printed by container formatters unless overridden by the format specification, 0 for no limit
+    // Elements past the limit are not visited, and are summarized as "... (M more)"
+    void set_container_format_limit(std::size_t limit);
+    [[nodiscard]] std::size_t container_format_limit();
+
+    namespace detail {
+
+        // Returns the remainder of 'spec' following a leading 'n=<count>' section (and its ':' separator), which is stored in 'limit'
+        // 'spec' is returned unchanged if it does not start with a limit
+        [[nodiscard]] constexpr std::string_view parse_element_limit(std::string_view spec, std::size_t& limit);
+
+        // Formatter for standard containers, which are formatted as a set of key-value pairs if 'C' is a map
+        template <typename C, bool Associative = is_map<C>::value || is_unordered_map<C>::value>
+        class ContainerFormatter {
+            public:
+                fmt::format_parse_context::iterator parse(fmt::format_parse_context& ctx);
+                fmt::format_context::iterator format(const C& value, fmt::format_context& ctx) const;
+
+            private:
+                std::size_t m_limit = std::numeric_limits<std::size_t>::max(); // Maximum value if not specified, to defer to container_format_limit()
+                fmt::formatter<std::ranges::range_value_t<C>> m_formatter;
+        };
+
+        template <typename C>
+        class ContainerFormatter<C, true> {
+            public:
+                fmt::format_parse_context::iterator parse(fmt::format_parse_context& ctx);
+                fmt::format_context::iterator format(const C& value, fmt::format_context& ctx) const;
+
+            private:
+                std::size_t m_limit = std::numeric_limits<std::size_t>::max();
+                fmt::formatter<typename C::key_type> m_key_formatter;
+                fmt::formatter<typename C::mapped_type> m_value_formatter;
+        };
+
+    }
+
 }
 
 // fmt::formatter specializations for compound / container types
@@ -109,46 +353,62 @@ struct fmt::formatter<std::tuple<Ts...>> {
         std::tuple<fmt::formatter<Ts>...> m_formatters;
 };
 
+// Container formatters print at most utils::container_format_limit() elements, which can be overridden with a leading 'n=<count>' section of the
+// format specification (e.g. "{:n=32}", or "{:n=32:>4}" to also format each element with ">4")
+// The remainder of the specification applies to each element (sequences, sets) or is split into a key and a value specification ("{:>4:x}", maps)
+
 // std::vector
-template <typename T>
-struct fmt::formatter<std::vector<T>> {
-    fmt::format_parse_context::iterator parse(fmt::format_parse_context& ctx);
-    fmt::format_context::iterator format(const std::vector<T>& value, fmt::format_context& ctx) const;
+template <typename T, typename A>
+struct fmt::formatter<std::vector<T, A>> : utils::detail::ContainerFormatter<std::vector<T, A>> {
+};
 
-    private:
-        fmt::formatter<T> m_formatter;
+// std::deque
+template <typename T, typename A>
+struct fmt::formatter<std::deque<T, A>> : utils::detail::ContainerFormatter<std::deque<T, A>> {
+};
+
+// std::array
+template <typename T, std::size_t N>
+struct fmt::formatter<std::array<T, N>> : utils::detail::ContainerFormatter<std::array<T, N>> {
 };
 
 // std::span
-template <typename T>
-struct fmt::formatter<std::span<T>> {
-    fmt::format_parse_context::iterator parse(fmt::format_parse_context& ctx);
-    fmt::format_context::iterator format(const std::span<T>& value, fmt::format_context& ctx) const;
+template <typename T, std::size_t E>
+struct fmt::formatter<std::span<T, E>> : utils::detail::ContainerFormatter<std::span<T, E>> {
+};
 
-    private:
-        fmt::formatter<std::remove_cv_t<T>> m_formatter;
+// std::map
+template <typename K, typename V, typename C, typename A>
+struct fmt::formatter<std::map<K, V, C, A>> : utils::detail::ContainerFormatter<std::map<K, V, C, A>> {
 };
 
 // std::unordered_map
 template <typename K, typename V, typename H, typename P, typename A>
-struct fmt::formatter<std::unordered_map<K, V, H, P, A>> {
-    fmt::format_parse_context::iterator parse(fmt::format_parse_context& ctx);
-    fmt::format_context::iterator format(const std::unordered_map<K, V, H, P, A>& value, fmt::format_context& ctx) const;
+struct fmt::formatter<std::unordered_map<K, V, H, P, A>> : utils::detail::ContainerFormatter<std::unordered_map<K, V, H, P, A>> {
+};
 
-    private:
-        fmt::formatter<K> m_key_formatter;
-        fmt::formatter<V> m_value_formatter;
+// std::set
+template <typename K, typename C, typename A>
+struct fmt::formatter<std::set<K, C, A>> : utils::detail::ContainerFormatter<std::set<K, C, A>> {
 };
 
 // std::unordered_set
 template <typename K, typename H, typename E, typename A>
-struct fmt::formatter<std::unordered_set<K, H, E, A>> {
+struct fmt::formatter<std::unordered_set<K, H, E, A>> : utils::detail::ContainerFormatter<std::unordered_set<K, H, E, A>> {
+};
+
+// std::optional, formatted as "optional(value)" or "none" (the format specification applies to the value)
+// fmt provides this formatter (and the one for std::variant) in fmt/std.h as of version 10
+#if FMT_VERSION < 100000
+template <typename T>
+struct fmt::formatter<std::optional<T>> {
     fmt::format_parse_context::iterator parse(fmt::format_parse_context& ctx);
-    fmt::format_context::iterator format(const std::unordered_set<K, H, E, A>& value, fmt::format_context& ctx) const;
+    fmt::format_context::iterator format(const std::optional<T>& value, fmt::format_context& ctx) const;
 
     private:
-        fmt::formatter<K> m_formatter;
+        fmt::formatter<T> m_formatter;
 };
+#endif
 
 // Template definitions
 #include "utils/detail/string.tpp"
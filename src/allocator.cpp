@@ -1,24 +1,130 @@
 #include "utils/allocator.hpp"
+#include "utils/platform.hpp"
 #include <memory>
+#include <algorithm> // std::max, std::sort
+#include <cstdlib> // std::malloc, std::free
+
+#if !defined(PLATFORM_WINDOWS)
+    #include <sys/mman.h> // mmap, munmap, madvise
+    #include <unistd.h> // sysconf
+#endif
 
 namespace utils {
 
-    BumpAllocator::BumpAllocator(std::size_t size, float growth_factor) : m_growth_factor(growth_factor),
-                                                                          m_current_block_index(0) {
-        allocate_block(size);
+    namespace detail {
+
+        // Default huge page size on x86-64 / AArch64 (MAP_HUGETLB without an explicit MAP_HUGE_* size flag)
+        constexpr std::size_t huge_page_size = megabytes(2);
+
+        std::size_t page_size() {
+            #if !defined(PLATFORM_WINDOWS)
+                static const std::size_t size = static_cast<std::size_t>(sysconf(_SC_PAGESIZE));
+                return size;
+            #else
+                return kilobytes(4);
+            #endif
+        }
+
+        std::size_t round_up(std::size_t value, std::size_t multiple) {
+            return (value + multiple - 1) / multiple * multiple;
+        }
+
+        // Writes one byte per page so that the kernel backs the entire range with physical memory up front
+        void touch_pages(void* data, std::size_t size) {
+            volatile std::byte* bytes = static_cast<std::byte*>(data);
+            for (std::size_t offset = 0; offset < size; offset += page_size()) {
+                bytes[offset] = std::byte { 0 };
+            }
+        }
+
+        // Returns nullptr if the mapping could not be created
+        // 'capacity' is rounded up to the granularity of the pages backing the mapping
+        void* map_block(std::size_t& capacity, BumpAllocator::HugePages huge_pages, bool prefault) {
+            #if !defined(PLATFORM_WINDOWS)
+                int flags = MAP_PRIVATE | MAP_ANONYMOUS;
+                void* data = MAP_FAILED;
+
+                #if defined(MAP_HUGETLB)
+                    if (huge_pages == BumpAllocator::HugePages::Explicit) {
+                        std::size_t huge_capacity = round_up(capacity, huge_page_size);
+                        data = mmap(nullptr, huge_capacity, PROT_READ | PROT_WRITE, flags | MAP_HUGETLB | (prefault ? MAP_POPULATE : 0), -1, 0);
+
+                        if (data != MAP_FAILED) {
+                            capacity = huge_capacity;
+                            return data;
+                        }
+
+                        // No huge pages reserved (vm.nr_hugepages), fall back to transparent huge pages
+                        huge_pages = BumpAllocator::HugePages::Transparent;
+                    }
+                #endif
+
+                if (huge_pages == BumpAllocator::HugePages::Transparent) {
+                    // Aligning the size to the huge page size gives khugepaged the best chance of collapsing the range
+                    capacity = round_up(capacity, huge_page_size);
+                }
+                else {
+                    capacity = round_up(capacity, page_size());
+                }
+
+                #if defined(MAP_POPULATE)
+                    // MAP_POPULATE faults pages in before madvise has a chance to request huge pages, so populate manually in that case
+                    bool populate = prefault && huge_pages != BumpAllocator::HugePages::Transparent;
+                    if (populate) {
+                        flags |= MAP_POPULATE;
+                    }
+                #else
+                    bool populate = false;
+                #endif
+
+                data = mmap(nullptr, capacity, PROT_READ | PROT_WRITE, flags, -1, 0);
+                if (data == MAP_FAILED) {
+                    return nullptr;
+                }
+
+                #if defined(MADV_HUGEPAGE)
+                    if (huge_pages == BumpAllocator::HugePages::Transparent) {
+                        madvise(data, capacity, MADV_HUGEPAGE);
+                    }
+                #endif
+
+                if (prefault && !populate) {
+                    touch_pages(data, capacity);
+                }
+
+                return data;
+            #else
+                // mmap is not available, Mapped blocks fall back to the heap
+                return nullptr;
+            #endif
+        }
+
+    }
+
+    BumpAllocator::BumpAllocator(std::size_t size, float growth_factor) : BumpAllocator(Configuration { .size = size, .growth_factor = growth_factor }) {
+    }
+
+    BumpAllocator::BumpAllocator(const Configuration& configuration) : m_configuration(configuration),
+                                                                       m_current_block_index(0),
+                                                                       m_statistics() {
+        allocate_block(configuration.size);
     }
 
     BumpAllocator::~BumpAllocator() {
         for (Block& block : m_blocks) {
-            free(block.data);
-            block.data = nullptr;
+            release_block(block);
         }
     }
 
-    BumpAllocator::BumpAllocator(BumpAllocator&& other) noexcept : m_growth_factor(other.m_growth_factor),
+    BumpAllocator::BumpAllocator(BumpAllocator&& other) noexcept : m_configuration(other.m_configuration),
                                                                    m_blocks(std::move(other.m_blocks)),
-                                                                   m_current_block_index(other.m_current_block_index) {
+                                                                   m_current_block_index(other.m_current_block_index),
+                                                                   m_statistics(other.m_statistics),
+                                                                   m_allocation_sites(std::move(other.m_allocation_sites)) {
+        other.m_blocks.clear();
         other.m_current_block_index = 0;
+        other.m_statistics = { };
+        other.m_allocation_sites.clear();
     }
 
     BumpAllocator& BumpAllocator::operator=(BumpAllocator&& other) noexcept {
@@ -27,46 +133,120 @@ namespace utils {
         }
 
         for (Block& block : m_blocks) {
-            free(block.data);
-            block.data = nullptr;
+            release_block(block);
         }
 
-        m_growth_factor = other.m_growth_factor;
+        m_configuration = other.m_configuration;
         m_blocks = std::move(other.m_blocks);
         m_current_block_index = other.m_current_block_index;
+        m_statistics = other.m_statistics;
+        m_allocation_sites = std::move(other.m_allocation_sites);
 
+        other.m_blocks.clear();
         other.m_current_block_index = 0;
+        other.m_statistics = { };
+        other.m_allocation_sites.clear();
 
         return *this;
     }
 
-    void* BumpAllocator::allocate(std::size_t size, std::size_t alignment) {
+    void* BumpAllocator::allocate(std::size_t size, std::size_t alignment, [[maybe_unused]] std::source_location source) {
         while (true) {
+            if (m_current_block_index == m_blocks.size()) {
+                // No blocks can accommodate an allocation of the requested size (or all blocks were released)
+                // Reserve enough space for the worst-case alignment adjustment so that the new block is guaranteed to fit the allocation
+                allocate_block(size + alignment - 1);
+            }
+
             Block& block = m_blocks[m_current_block_index];
 
-            void* data = static_cast<std::byte*>(block.data) + block.size;
+            std::byte* unaligned = static_cast<std::byte*>(block.data) + block.size;
+            void* data = unaligned;
             std::size_t remaining = block.capacity - block.size;
 
             if (std::align(alignment, size, data, remaining)) {
                 // Block can fit the (aligned) allocation
-                block.size = static_cast<std::size_t>(static_cast<std::byte*>(data) - block.data) + size;
-                return data;
-            }
+                block.size = static_cast<std::size_t>(static_cast<std::byte*>(data) - static_cast<std::byte*>(block.data)) + size;
+
+                ++m_statistics.allocation_count;
+                m_statistics.bytes_requested += size;
+                m_statistics.bytes_padding += static_cast<std::size_t>(static_cast<std::byte*>(data) - unaligned);
+
+                std::size_t in_use = m_statistics.bytes_requested + m_statistics.bytes_padding + m_statistics.bytes_skipped;
+                m_statistics.high_water_mark = std::max(m_statistics.high_water_mark, in_use);
 
-            if (m_current_block_index + 1 == m_blocks.size()) {
-                // No blocks can accommodate a block of the requested size
-                allocate_block(size);
+                #if !defined NDEBUG
+                    AllocationSite& site = m_allocation_sites.try_emplace({ source.file_name(), source.line() }, source, 0, 0).first->second;
+                    ++site.count;
+                    site.bytes += size;
+                #endif
+
+                return data;
             }
 
+            // The remainder of this block is abandoned until the next reset
+            m_statistics.bytes_skipped += block.capacity - block.size;
             ++m_current_block_index;
         }
     }
 
     void BumpAllocator::reset() {
-        for (Block& block : m_blocks) {
+        std::size_t retained = 0;
+
+        std::erase_if(m_blocks, [this, &retained](Block& block) -> bool {
             block.size = 0;
-        }
+
+            if (retained + block.capacity <= m_configuration.retain) {
+                retained += block.capacity;
+                return false;
+            }
+
+            #if !defined(PLATFORM_WINDOWS) && defined(MADV_DONTNEED)
+                if (m_configuration.release_policy == ReleasePolicy::Decommit && block.backing == Backing::Mapped) {
+                    // Keep the address range but let the kernel reclaim the physical pages, which are zero-filled again on the next access
+                    madvise(block.data, block.capacity, MADV_DONTNEED);
+                    return false;
+                }
+            #endif
+
+            release_block(block);
+            return true;
+        });
+
         m_current_block_index = 0;
+
+        m_statistics.allocation_count = 0;
+        m_statistics.bytes_requested = 0;
+        m_statistics.bytes_padding = 0;
+        m_statistics.bytes_skipped = 0;
+        ++m_statistics.reset_count;
+    }
+
+    BumpAllocator::Statistics BumpAllocator::statistics() const {
+        Statistics statistics = m_statistics;
+
+        statistics.block_count = m_blocks.size();
+        statistics.bytes_reserved = 0;
+        for (const Block& block : m_blocks) {
+            statistics.bytes_reserved += block.capacity;
+        }
+
+        return statistics;
+    }
+
+    std::vector<BumpAllocator::AllocationSite> BumpAllocator::allocation_sites() const {
+        std::vector<AllocationSite> sites { };
+        sites.reserve(m_allocation_sites.size());
+
+        for (const auto& [key, site] : m_allocation_sites) {
+            sites.emplace_back(site);
+        }
+
+        std::sort(sites.begin(), sites.end(), [](const AllocationSite& a, const AllocationSite& b) -> bool {
+            return a.bytes > b.bytes;
+        });
+
+        return sites;
     }
 
     void BumpAllocator::allocate_block(std::size_t size) {
@@ -76,11 +256,93 @@ namespace utils {
         }
 
         while (capacity < size) {
-            capacity = static_cast<std::size_t>(static_cast<float>(capacity) * m_growth_factor);
+            capacity = static_cast<std::size_t>(static_cast<float>(capacity) * m_configuration.growth_factor);
+        }
+
+        if (m_configuration.backing == Backing::Mapped) {
+            void* data = detail::map_block(capacity, m_configuration.huge_pages, m_configuration.prefault);
+            if (data) {
+                m_blocks.emplace_back(data, 0, capacity, Backing::Mapped);
+                return;
+            }
+        }
+
+        void* data = std::malloc(capacity);
+        if (!data) {
+            throw std::bad_alloc();
+        }
+
+        if (m_configuration.prefault) {
+            detail::touch_pages(data, capacity);
+        }
+
+        m_blocks.emplace_back(data, 0, capacity, Backing::Heap);
+    }
+
+    void BumpAllocator::release_block(Block& block) {
+        if (!block.data) {
+            return;
+        }
+
+        #if !defined(PLATFORM_WINDOWS)
+            if (block.backing == Backing::Mapped) {
+                munmap(block.data, block.capacity);
+                block.data = nullptr;
+                return;
+            }
+        #endif
+
+        std::free(block.data);
+        block.data = nullptr;
+    }
+
+    ObjectArena::ObjectArena(std::size_t size, float growth_factor) : m_allocator(size, growth_factor),
+                                                                      m_destructors(nullptr) {
+    }
+
+    ObjectArena::ObjectArena(const BumpAllocator::Configuration& configuration) : m_allocator(configuration),
+                                                                                  m_destructors(nullptr) {
+    }
+
+    ObjectArena::~ObjectArena() {
+        destroy();
+    }
+
+    ObjectArena::ObjectArena(ObjectArena&& other) noexcept : m_allocator(std::move(other.m_allocator)),
+                                                             m_destructors(other.m_destructors) {
+        other.m_destructors = nullptr;
+    }
+
+    ObjectArena& ObjectArena::operator=(ObjectArena&& other) noexcept {
+        if (this == &other) {
+            return *this;
         }
 
-        void* data = malloc(capacity);
-        m_blocks.emplace_back(data, 0, capacity);
+        destroy();
+
+        m_allocator = std::move(other.m_allocator);
+        m_destructors = other.m_destructors;
+
+        other.m_destructors = nullptr;
+
+        return *this;
+    }
+
+    void ObjectArena::reset() {
+        destroy();
+        m_allocator.reset();
+    }
+
+    BumpAllocator::Statistics ObjectArena::statistics() const {
+        return m_allocator.statistics();
+    }
+
+    void ObjectArena::destroy() {
+        // Records are linked from the most recently created object, so objects are destroyed in reverse order of construction
+        for (DestructorRecord* record = m_destructors; record; record = record->previous) {
+            record->destructor(record->object);
+        }
+        m_destructors = nullptr;
     }
 
 }
@@ -0,0 +1,381 @@
+
+#include "utils/csv.hpp"
+#include <algorithm> // std::clamp, std::count
+#include <bit> // std::countr_zero
+#include <cstring> // std::memcpy
+#include <exception> // std::exception_ptr, std::current_exception, std::rethrow_exception
+#include <thread> // std::thread
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+    #define UTILS_CSV_SSE2 1
+    #include <emmintrin.h>
+#endif
+
+#if defined(__AVX2__)
+    #define UTILS_CSV_AVX2 1
+    #include <immintrin.h>
+#endif
+
+namespace utils {
+
+    namespace detail {
+
+        constexpr std::size_t CSV_BLOCK_SIZE = 64;
+
+        // Bitmasks of the positions of delimiters, newlines, and quotes within a 64-byte block (bit i corresponds to byte i)
+        struct CsvBlock {
+            std::uint64_t delimiters;
+            std::uint64_t newlines;
+            std::uint64_t quotes;
+        };
+
+        CsvBlock classify(const char* data, char delimiter, char quote) {
+            CsvBlock block { 0, 0, 0 };
+
+            #if defined(UTILS_CSV_AVX2)
+                __m256i delimiter_pattern = _mm256_set1_epi8(delimiter);
+                __m256i newline_pattern = _mm256_set1_epi8('\n');
+                __m256i quote_pattern = _mm256_set1_epi8(quote);
+
+                for (std::size_t i = 0; i < CSV_BLOCK_SIZE; i += 32) {
+                    __m256i bytes = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + i));
+
+                    block.delimiters |= static_cast<std::uint64_t>(static_cast<std::uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(bytes, delimiter_pattern)))) << i;
+                    block.newlines |= static_cast<std::uint64_t>(static_cast<std::uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(bytes, newline_pattern)))) << i;
+                    block.quotes |= static_cast<std::uint64_t>(static_cast<std::uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(bytes, quote_pattern)))) << i;
+                }
+            #elif defined(UTILS_CSV_SSE2)
+                __m128i delimiter_pattern = _mm_set1_epi8(delimiter);
+                __m128i newline_pattern = _mm_set1_epi8('\n');
+                __m128i quote_pattern = _mm_set1_epi8(quote);
+
+                for (std::size_t i = 0; i < CSV_BLOCK_SIZE; i += 16) {
+                    __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i));
+
+                    block.delimiters |= static_cast<std::uint64_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(bytes, delimiter_pattern))) << i;
+                    block.newlines |= static_cast<std::uint64_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(bytes, newline_pattern))) << i;
+                    block.quotes |= static_cast<std::uint64_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(bytes, quote_pattern))) << i;
+                }
+            #else
+                for (std::size_t i = 0; i < CSV_BLOCK_SIZE; ++i) {
+                    block.delimiters |= static_cast<std::uint64_t>(data[i] == delimiter) << i;
+                    block.newlines |= static_cast<std::uint64_t>(data[i] == '\n') << i;
+                    block.quotes |= static_cast<std::uint64_t>(data[i] == quote) << i;
+                }
+            #endif
+
+            if (!quote) {
+                // Quoting is disabled (and padding bytes would otherwise match)
+                block.quotes = 0;
+            }
+
+            return block;
+        }
+
+        // Sets each bit to the parity of the number of set bits at or below its position
+        std::uint64_t prefix_xor(std::uint64_t bits) {
+            bits ^= bits << 1;
+            bits ^= bits << 2;
+            bits ^= bits << 4;
+            bits ^= bits << 8;
+            bits ^= bits << 16;
+            bits ^= bits << 32;
+            return bits;
+        }
+
+        // Invokes 'function' with each index in [0, count) on its own thread (index 0 on the calling thread), rethrows the first exception after all threads have finished
+        template <typename Fn>
+        void run_parallel(std::size_t count, const Fn& function) {
+            std::vector<std::exception_ptr> exceptions(count);
+
+            auto run = [&](std::size_t index) {
+                try {
+                    function(index);
+                }
+                catch (...) {
+                    exceptions[index] = std::current_exception();
+                }
+            };
+
+            std::vector<std::thread> threads;
+            threads.reserve(count - 1);
+            for (std::size_t i = 1; i < count; ++i) {
+                threads.emplace_back(run, i);
+            }
+
+            run(0);
+
+            for (std::thread& thread : threads) {
+                thread.join();
+            }
+
+            for (std::exception_ptr& exception : exceptions) {
+                if (exception) {
+                    std::rethrow_exception(exception);
+                }
+            }
+        }
+
+    }
+
+    CsvRecord::CsvRecord() : m_quote('\0') {
+    }
+
+    std::size_t CsvRecord::size() const {
+        return m_fields.size();
+    }
+
+    std::string_view CsvRecord::operator[](std::size_t index) const {
+        return m_fields[index].value;
+    }
+
+    std::string_view CsvRecord::unescaped(std::size_t index, std::string& buffer) const {
+        const Field& field = m_fields[index];
+        if (!field.quoted) {
+            return field.value;
+        }
+
+        std::size_t position = field.value.find(m_quote);
+        if (position == std::string_view::npos) {
+            return field.value;
+        }
+
+        buffer.assign(field.value.data(), position);
+        for (std::size_t i = position; i < field.value.length(); ++i) {
+            buffer += field.value[i];
+
+            // Skip the second quote of each escaped pair
+            if (field.value[i] == m_quote && i + 1 < field.value.length() && field.value[i + 1] == m_quote) {
+                ++i;
+            }
+        }
+
+        return buffer;
+    }
+
+    std::string_view CsvRecord::line() const {
+        return m_line;
+    }
+
+    CsvReader::CsvReader(std::string_view buffer, CsvDialect dialect, bool final) : m_buffer(buffer),
+                                                                                    m_dialect(dialect),
+                                                                                    m_final(final),
+                                                                                    m_record(0),
+                                                                                    m_block(0),
+                                                                                    m_structurals(0),
+                                                                                    m_quoted(0) {
+    }
+
+    bool CsvReader::next(CsvRecord& record) {
+        record.m_fields.clear();
+        record.m_quote = m_dialect.quote;
+
+        // Fields are only added once the end of the record is found, so that a record that is continued in the next buffer can be resumed from the
+        // delimiters visited so far
+        auto add_record = [&](std::size_t end) {
+            std::size_t field = m_record;
+
+            auto add_field = [&](std::size_t end) {
+                std::string_view value = m_buffer.substr(field, end - field);
+                bool quoted = m_dialect.quote && value.length() >= 2 && value.front() == m_dialect.quote && value.back() == m_dialect.quote;
+                if (quoted) {
+                    value = value.substr(1, value.length() - 2);
+                }
+
+                record.m_fields.push_back({ value, quoted });
+            };
+
+            for (std::size_t delimiter : m_delimiters) {
+                add_field(delimiter);
+                field = delimiter + 1;
+            }
+            m_delimiters.clear();
+
+            // Line terminators may be "\r\n"
+            if (end > field && m_buffer[end - 1] == '\r') {
+                --end;
+            }
+
+            add_field(end);
+            record.m_line = m_buffer.substr(m_record, end - m_record);
+        };
+
+        while (true) {
+            while (!m_structurals) {
+                // A trailing partial block is only classified once the input is final, as it may be continued in the next buffer
+                if (m_block >= m_buffer.length() || (!m_final && m_buffer.length() - m_block < detail::CSV_BLOCK_SIZE)) {
+                    // Reached the end of the input, the last record may not be terminated by a newline
+                    if (!m_final || m_record == m_buffer.length()) {
+                        return false;
+                    }
+
+                    add_record(m_buffer.length());
+                    m_record = m_buffer.length();
+
+                    if (record.m_line.empty()) {
+                        record.m_fields.clear();
+                        return false;
+                    }
+                    return true;
+                }
+
+                advance();
+            }
+
+            std::size_t position = m_block - detail::CSV_BLOCK_SIZE + static_cast<std::size_t>(std::countr_zero(m_structurals));
+            m_structurals &= m_structurals - 1;
+
+            if (m_buffer[position] == m_dialect.delimiter) {
+                m_delimiters.push_back(position);
+                continue;
+            }
+
+            // Newline
+            add_record(position);
+            m_record = position + 1;
+
+            if (record.m_line.empty()) {
+                // Skip empty lines
+                record.m_fields.clear();
+                continue;
+            }
+
+            return true;
+        }
+    }
+
+    std::string_view CsvReader::remaining() const {
+        return m_buffer.substr(m_record);
+    }
+
+    void CsvReader::resume(std::string_view buffer, bool final) {
+        // Positions are relative to the start of the record in progress, which is now at the start of the buffer
+        for (std::size_t& delimiter : m_delimiters) {
+            delimiter -= m_record;
+        }
+        m_block -= m_record;
+        m_record = 0;
+
+        m_buffer = buffer;
+        m_final = final;
+    }
+
+    void CsvReader::advance() {
+        const char* data = m_buffer.data() + m_block;
+        std::size_t available = m_buffer.length() - m_block;
+
+        // The final (partial) block is padded with bytes that do not match any structural character
+        char padded[detail::CSV_BLOCK_SIZE] { };
+        if (available < detail::CSV_BLOCK_SIZE) {
+            std::memcpy(padded, data, available);
+            data = padded;
+        }
+
+        detail::CsvBlock block = detail::classify(data, m_dialect.delimiter, m_dialect.quote);
+
+        // Bits between an opening and a closing quote are set, continuing a quoted field from the previous block if necessary
+        std::uint64_t quoted = detail::prefix_xor(block.quotes) ^ m_quoted;
+        m_quoted = static_cast<std::uint64_t>(static_cast<std::int64_t>(quoted) >> 63);
+
+        m_structurals = (block.delimiters | block.newlines) & ~quoted;
+        m_block += detail::CSV_BLOCK_SIZE;
+    }
+
+    CsvStream::CsvStream(std::istream& stream, CsvDialect dialect, std::size_t chunk_size) : m_stream(stream),
+                                                                                             m_dialect(dialect),
+                                                                                             m_chunk_size(chunk_size),
+                                                                                             m_reader(std::string_view(), dialect, false),
+                                                                                             m_exhausted(false) {
+    }
+
+    bool CsvStream::next(CsvRecord& record) {
+        while (!m_reader.next(record)) {
+            if (!refill()) {
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+    bool CsvStream::refill() {
+        if (m_exhausted) {
+            return false;
+        }
+
+        // Keep the partial record at the end of the previous chunk, the reader continues from the last position it classified instead of rescanning it
+        // (once a record spans several chunks it starts at the beginning of the buffer, and nothing is moved)
+        m_buffer.erase(0, m_buffer.length() - m_reader.remaining().length());
+
+        std::size_t length = m_buffer.length();
+        m_buffer.resize(length + m_chunk_size);
+        m_stream.read(m_buffer.data() + length, static_cast<std::streamsize>(m_chunk_size));
+
+        std::size_t read = static_cast<std::size_t>(m_stream.gcount());
+        m_buffer.resize(length + read);
+
+        // A short read marks the end of the stream, after which the last record no longer needs to be terminated
+        m_exhausted = read < m_chunk_size;
+        m_reader.resume(m_buffer, m_exhausted);
+        return true;
+    }
+
+    namespace detail {
+
+        void parse_parallel(std::string_view buffer, const utils::InplaceFunction<void(std::size_t chunk, const CsvRecord& record)>& callback, CsvDialect dialect, std::size_t threads) {
+            if (threads == 0) {
+                threads = std::max(1u, std::thread::hardware_concurrency());
+            }
+
+            // Chunks smaller than this are not worth a thread
+            constexpr std::size_t MINIMUM_CHUNK_SIZE = kilobytes(256);
+            std::size_t count = std::clamp<std::size_t>(buffer.length() / MINIMUM_CHUNK_SIZE, 1, threads);
+
+            std::vector<std::size_t> boundaries(count + 1);
+            for (std::size_t i = 0; i <= count; ++i) {
+                boundaries[i] = buffer.length() / count * i;
+            }
+            boundaries[count] = buffer.length();
+
+            // Whether a chunk starts within a quoted field depends on the parity of the number of quotes before it
+            std::vector<std::size_t> quotes(count, 0);
+            if (dialect.quote) {
+                run_parallel(count, [&](std::size_t i) {
+                    quotes[i] = static_cast<std::size_t>(std::count(buffer.begin() + boundaries[i], buffer.begin() + boundaries[i + 1], dialect.quote));
+                });
+            }
+
+            // Move the start of each chunk past the first newline that is not within a quoted field
+            std::size_t parity = 0;
+            for (std::size_t i = 1; i < count; ++i) {
+                parity += quotes[i - 1];
+
+                bool quoted = parity & 1;
+                std::size_t position = boundaries[i];
+
+                for (; position < buffer.length(); ++position) {
+                    if (dialect.quote && buffer[position] == dialect.quote) {
+                        quoted = !quoted;
+                    }
+                    else if (buffer[position] == '\n' && !quoted) {
+                        ++position;
+                        break;
+                    }
+                }
+
+                boundaries[i] = position;
+            }
+
+            run_parallel(count, [&](std::size_t i) {
+                CsvReader reader(buffer.substr(boundaries[i], boundaries[i + 1] - boundaries[i]), dialect);
+                CsvRecord record;
+
+                while (reader.next(record)) {
+                    callback(i, record);
+                }
+            });
+        }
+
+    }
+
+}
@@ -9,8 +9,8 @@ namespace utils {
 
         IdGenerator id_generator { };
         EventQueue event_queue { };
-        std::unordered_map<std::type_index, std::vector<std::weak_ptr<Callback>>> dispatch_map { };
-        std::unordered_map<std::uintptr_t, CallbackRegistration> callback_registrations { };
+        FlatHashMap<std::type_index, std::vector<std::weak_ptr<Callback>>> dispatch_map { };
+        FlatHashMap<std::uintptr_t, CallbackRegistration> callback_registrations { };
 
         template <typename T>
         bool is_uninitialized(const std::weak_ptr<T>& ptr) {
@@ -119,118 +119,22 @@ namespace utils {
         }
         
         // EventQueue implementation
-        EventQueue::EventQueue(std::size_t size) : m_data(malloc(size)),
-                                                   m_offset(0),
-                                                   m_capacity(size),
-                                                   m_allocation_count(0) {
-        }
-        
-        void EventQueue::reallocate() {
-            // Increase allocator capacity
-            void* new_data = malloc(m_capacity);
-            
-            std::byte* dst = reinterpret_cast<std::byte*>(new_data);
-            std::byte* src = reinterpret_cast<std::byte*>(m_data);
-            std::byte* last_copied_from = src;
-            
-            // Copy over elements + allocation metadata
-            // Consecutive allocations that are trivially copyable are copied over in bulk
-            for (std::size_t i = 0; i < m_allocation_count; ++i) {
-                const Allocation& allocation = *reinterpret_cast<Allocation*>(src);
-                std::size_t total_size = sizeof(Allocation) + allocation.size;
-                
-                bool is_trivial = allocation.copy_op == Allocation::CopyConstructorType::None;
-                
-                if (!is_trivial) {
-                    // Bulk copy any trivially copyable elements before this allocation
-                    if (src != last_copied_from) {
-                        std::size_t block_size = src - last_copied_from;
-                        std::memcpy(dst, last_copied_from, block_size);
-                        dst += block_size;
-                    }
-                    
-                    // Copy allocation header
-                    std::memcpy(dst, src, sizeof(Allocation));
-                    
-                    // Copy block
-                    std::size_t offset = sizeof(Allocation);
-                    switch (allocation.copy_op) {
-                        case Allocation::CopyConstructorType::Copy:
-                            allocation.copy_constructor.copy(dst + offset, src + offset);
-                            break;
-                        case Allocation::CopyConstructorType::Move:
-                            allocation.copy_constructor.move(dst + offset, src + offset);
-                            break;
-                    }
-                    
-                    dst += total_size;
-                    last_copied_from = src + total_size;
-                }
-                // Simply step over trivially-copyable blocks, as batch memcpy will copy the data of this block later
-                // else { ... }
-                
-                src += total_size;
-            }
-            
-            // Copy any trailing trivially-copyable blocks
-            if (src != last_copied_from) {
-                std::size_t block_size = src - last_copied_from;
-                std::memcpy(dst, last_copied_from, block_size);
-                // dst += block_size;
-            }
-            
-            free(m_data);
-            m_data = new_data;
+        EventQueue::EventQueue(std::size_t size) : m_arena(size),
+                                                   m_events() {
         }
         
         void EventQueue::reset() {
-            std::byte* base = reinterpret_cast<std::byte*>(m_data);
-            
-            for (std::size_t i = 0; i < m_allocation_count; ++i) {
-                const Allocation& allocation = *reinterpret_cast<Allocation*>(base);
-                
-                if (allocation.destructor) {
-                    // Non-trivially destructible type, need to call destructor for this object before resetting allocator
-                    allocation.destructor(base + sizeof(Allocation));
-                }
-                
-                // Step to next block
-                base += sizeof(Allocation) + allocation.size;
-            }
-            
-            // Reset allocator internals
-            m_allocation_count = 0;
-            m_offset = 0;
-        }
-        
-        // Note: begin() and end() functions should return the same pointer for empty containers
-        EventQueue::ForwardIterator EventQueue::begin() {
-            return m_data;
-        }
-        EventQueue::ForwardIterator EventQueue::end() {
-            return reinterpret_cast<std::byte*>(m_data) + m_offset; // Points to one past the last element
-        }
-
-        // EventQueue::ForwardIterator implementation
-        EventQueue::ForwardIterator::ForwardIterator(void* base) : m_base(base) {
-        }
-        
-        EventData EventQueue::ForwardIterator::operator*() const {
-            const EventQueue::Allocation& allocation = *reinterpret_cast<EventQueue::Allocation*>(m_base);
-            return {
-                .data = reinterpret_cast<std::byte*>(m_base) + sizeof(Allocation), // Return a pointer to the data segment
-                .type = allocation.type
-            };
+            // Destroys any non-trivially destructible events, in reverse order of dispatch
+            m_arena.reset();
+            m_events.clear();
         }
         
-        EventQueue::ForwardIterator& EventQueue::ForwardIterator::operator++() {
-            const EventQueue::Allocation& allocation = *reinterpret_cast<EventQueue::Allocation*>(m_base);
-            m_base = reinterpret_cast<std::byte*>(m_base) + sizeof(Allocation) + allocation.size;
-            return *this;
+        EventQueue::ForwardIterator EventQueue::begin() const {
+            return m_events.begin();
         }
         
-        bool EventQueue::ForwardIterator::operator!=(const EventQueue::ForwardIterator& other) const {
-            return m_base != other.m_base;
+        EventQueue::ForwardIterator EventQueue::end() const {
+            return m_events.end();
         }
 
         CallbackHandle get_callback(std::size_t address, std::size_t id) {
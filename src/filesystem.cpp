@@ -1,18 +1,1423 @@
 
 #include "utils/filesystem.hpp"
-#include <fstream> // std::ifstream, std::ofstream
+#include "utils/events.hpp"
+#include "utils/platform.hpp"
+#include "utils/string.hpp"
+#include <algorithm> // std::min, std::max, std::clamp, std::copy
+#include <atomic> // std::atomic, std::atomic_ref
+#include <bit> // std::bit_ceil
+#include <condition_variable> // std::condition_variable
+#include <cstring> // std::memcpy
+#include <fstream> // std::ofstream
+#include <mutex> // std::mutex, std::unique_lock
+#include <new> // std::align_val_t
+#include <stdexcept> // std::runtime_error
+#include <system_error> // std::generic_category, std::system_category
+#include <thread> // std::thread
+#include <utility> // std::exchange, std::swap
+#include <vector> // std::vector
+
+#if defined(PLATFORM_WINDOWS)
+    #define NOMINMAX
+    #define WIN32_LEAN_AND_MEAN
+    #include <windows.h>
+#else
+    #include <fcntl.h> // open, posix_fadvise
+    #include <sys/mman.h> // mmap, munmap, madvise
+    #include <sys/stat.h> // fstat
+    #include <sys/uio.h> // writev
+    #include <unistd.h> // close, pread, sysconf
+    #include <cerrno> // errno
+#endif
+
+#if defined(PLATFORM_LINUX) && __has_include(<linux/io_uring.h>)
+    #define UTILS_IO_URING 1
+    #include <linux/io_uring.h>
+    #include <sys/syscall.h> // __NR_io_uring_setup, __NR_io_uring_enter, __NR_io_uring_register
+#endif
 
 namespace utils {
 
-    std::string read(const std::filesystem::path& path) {
-        std::ifstream file(path, std::ios::binary | std::ios::ate);
-        std::streamsize length = file.tellg();
+    namespace detail {
+
+        #if defined(PLATFORM_WINDOWS)
+            std::string last_error() {
+                return std::system_category().message(static_cast<int>(GetLastError()));
+            }
+        #else
+            std::string last_error() {
+                return std::generic_category().message(errno);
+            }
+
+            // Closes the file descriptor once the file is mapped (or fails to be), the mapping remains valid
+            struct FileDescriptor {
+                ~FileDescriptor() {
+                    if (fd >= 0) {
+                        ::close(fd);
+                    }
+                }
+
+                int fd;
+            };
+        #endif
+
+    }
+
+    Result<MappedFile> MappedFile::open(const std::filesystem::path& path, const MapOptions& options) {
+        MappedFile file;
+
+        #if defined(PLATFORM_WINDOWS)
+            DWORD flags = FILE_ATTRIBUTE_NORMAL;
+            if (options.access == MapAdvice::Sequential) {
+                flags |= FILE_FLAG_SEQUENTIAL_SCAN;
+            }
+            else if (options.access == MapAdvice::Random) {
+                flags |= FILE_FLAG_RANDOM_ACCESS;
+            }
+
+            HANDLE handle = CreateFileW(path.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE, nullptr, OPEN_EXISTING, flags, nullptr);
+            if (handle == INVALID_HANDLE_VALUE) {
+                return Result<MappedFile>::NOT_OK(utils::format("failed to open '{}': {}", path.string(), detail::last_error()));
+            }
+
+            LARGE_INTEGER size;
+            if (!GetFileSizeEx(handle, &size)) {
+                std::string error = utils::format("failed to query the size of '{}': {}", path.string(), detail::last_error());
+                CloseHandle(handle);
+                return Result<MappedFile>::NOT_OK(std::move(error));
+            }
+
+            if (size.QuadPart == 0) {
+                // Empty files cannot be mapped
+                CloseHandle(handle);
+                return Result<MappedFile>::OK(std::move(file));
+            }
+
+            // The view keeps the mapping (and the file) open after both handles are closed
+            HANDLE mapping = CreateFileMappingW(handle, nullptr, PAGE_READONLY, 0, 0, nullptr);
+            void* data = mapping ? MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0) : nullptr;
+            std::string error = data ? std::string() : utils::format("failed to map '{}': {}", path.string(), detail::last_error());
+
+            if (mapping) {
+                CloseHandle(mapping);
+            }
+            CloseHandle(handle);
+
+            if (!data) {
+                return Result<MappedFile>::NOT_OK(std::move(error));
+            }
+
+            file.m_data = static_cast<std::byte*>(data);
+            file.m_size = static_cast<std::size_t>(size.QuadPart);
+        #else
+            detail::FileDescriptor descriptor { ::open(path.c_str(), O_RDONLY | O_CLOEXEC) };
+            if (descriptor.fd < 0) {
+                return Result<MappedFile>::NOT_OK(utils::format("failed to open '{}': {}", path.string(), detail::last_error()));
+            }
+
+            struct stat status;
+            if (::fstat(descriptor.fd, &status) != 0) {
+                return Result<MappedFile>::NOT_OK(utils::format("failed to query the size of '{}': {}", path.string(), detail::last_error()));
+            }
+
+            if (status.st_size == 0) {
+                // Empty files cannot be mapped
+                return Result<MappedFile>::OK(std::move(file));
+            }
+
+            int flags = MAP_PRIVATE;
+            #if defined(MAP_POPULATE)
+                if (options.populate) {
+                    flags |= MAP_POPULATE;
+                }
+            #endif
 
-        std::string content(length, '\0');
-        file.seekg(0);
-        file.read(&content[0], length);
+            void* data = ::mmap(nullptr, static_cast<std::size_t>(status.st_size), PROT_READ, flags, descriptor.fd, 0);
+            if (data == MAP_FAILED) {
+                return Result<MappedFile>::NOT_OK(utils::format("failed to map '{}': {}", path.string(), detail::last_error()));
+            }
 
-        return std::move(content);
+            file.m_data = static_cast<std::byte*>(data);
+            file.m_size = static_cast<std::size_t>(status.st_size);
+
+            // Hints are not binding, a kernel that does not support one maps the file all the same
+            if (options.access != MapAdvice::Normal) {
+                (void) file.advise(options.access);
+            }
+
+            if (options.huge_pages) {
+                (void) file.advise(MapAdvice::HugePages);
+            }
+
+            #if defined(MAP_POPULATE)
+                if (options.will_need && !options.populate) {
+                    (void) file.advise(MapAdvice::WillNeed);
+                }
+            #else
+                if (options.will_need || options.populate) {
+                    (void) file.advise(MapAdvice::WillNeed);
+                }
+            #endif
+        #endif
+
+        return Result<MappedFile>::OK(std::move(file));
+    }
+
+    MappedFile::MappedFile() : m_data(nullptr),
+                               m_size(0u) {
+    }
+
+    MappedFile::~MappedFile() {
+        unmap();
+    }
+
+    MappedFile::MappedFile(MappedFile&& other) noexcept : m_data(std::exchange(other.m_data, nullptr)),
+                                                          m_size(std::exchange(other.m_size, 0u)) {
+    }
+
+    MappedFile& MappedFile::operator=(MappedFile&& other) noexcept {
+        if (this != &other) {
+            unmap();
+            m_data = std::exchange(other.m_data, nullptr);
+            m_size = std::exchange(other.m_size, 0u);
+        }
+
+        return *this;
+    }
+
+    const std::byte* MappedFile::data() const {
+        return m_data;
+    }
+
+    std::size_t MappedFile::size() const {
+        return m_size;
+    }
+
+    bool MappedFile::empty() const {
+        return m_size == 0u;
+    }
+
+    std::span<const std::byte> MappedFile::bytes() const {
+        return { m_data, m_size };
+    }
+
+    std::string_view MappedFile::view() const {
+        return { reinterpret_cast<const char*>(m_data), m_size };
+    }
+
+    Result<void> MappedFile::advise(MapAdvice advice, std::size_t offset, std::size_t length) const {
+        if (offset >= m_size) {
+            return Result<void>::OK();
+        }
+
+        length = std::min(length, m_size - offset);
+
+        #if defined(PLATFORM_WINDOWS)
+            if (advice == MapAdvice::WillNeed) {
+                WIN32_MEMORY_RANGE_ENTRY range { m_data + offset, length };
+                if (!PrefetchVirtualMemory(GetCurrentProcess(), 1, &range, 0)) {
+                    return Result<void>::NOT_OK(utils::format("failed to prefetch mapped file: {}", detail::last_error()));
+                }
+            }
+
+            // Other hints have no equivalent for mapped views
+            return Result<void>::OK();
+        #else
+            int flag;
+            switch (advice) {
+                case MapAdvice::Normal:
+                    flag = MADV_NORMAL;
+                    break;
+                case MapAdvice::Sequential:
+                    flag = MADV_SEQUENTIAL;
+                    break;
+                case MapAdvice::Random:
+                    flag = MADV_RANDOM;
+                    break;
+                case MapAdvice::WillNeed:
+                    flag = MADV_WILLNEED;
+                    break;
+                case MapAdvice::DontNeed:
+                    flag = MADV_DONTNEED;
+                    break;
+                case MapAdvice::HugePages:
+                    #if defined(MADV_HUGEPAGE)
+                        flag = MADV_HUGEPAGE;
+                        break;
+                    #else
+                        return Result<void>::NOT_OK("huge pages are not supported on this platform");
+                    #endif
+                default:
+                    return Result<void>::NOT_OK("invalid advice");
+            }
+
+            // Ranges must start on a page boundary (the mapping itself does)
+            std::size_t page = static_cast<std::size_t>(::sysconf(_SC_PAGESIZE));
+            std::size_t start = offset / page * page;
+
+            if (::madvise(m_data + start, offset + length - start, flag) != 0) {
+                return Result<void>::NOT_OK(utils::format("failed to apply advice to mapped file: {}", detail::last_error()));
+            }
+
+            return Result<void>::OK();
+        #endif
+    }
+
+    void MappedFile::unmap() {
+        if (!m_data) {
+            return;
+        }
+
+        #if defined(PLATFORM_WINDOWS)
+            UnmapViewOfFile(m_data);
+        #else
+            ::munmap(m_data, m_size);
+        #endif
+
+        m_data = nullptr;
+        m_size = 0u;
+    }
+
+    namespace detail {
+
+        // Alignment of buffers, offsets, and sizes for reads that bypass the page cache
+        constexpr std::size_t DIRECT_IO_ALIGNMENT = kilobytes(4);
+
+        // Handle to an open file, closed on destruction
+        class NativeFile {
+            public:
+                enum class Mode {
+                    Read,
+                    ReadDirect,
+                    Write,
+                    Append
+                };
+
+                NativeFile();
+                ~NativeFile();
+
+                NativeFile(const NativeFile&) = delete;
+                NativeFile& operator=(const NativeFile&) = delete;
+
+                [[nodiscard]] Result<void> open(const std::filesystem::path& path, Mode mode);
+
+                // Reads up to 'size' bytes at 'offset', fewer bytes are only returned at the end of the file
+                [[nodiscard]] Result<std::size_t> read(void* buffer, std::size_t size, std::uint64_t offset);
+
+                // Writes all of 'pieces' in order
+                [[nodiscard]] Result<void> write(std::span<const std::string_view> pieces);
+
+                [[nodiscard]] Result<void> close();
+
+            private:
+                std::string m_path; // For error messages
+                bool m_direct;
+
+                #if defined(PLATFORM_WINDOWS)
+                    HANDLE m_handle;
+                #else
+                    int m_fd;
+                #endif
+        };
+
+        #if defined(PLATFORM_WINDOWS)
+            NativeFile::NativeFile() : m_direct(false),
+                                       m_handle(INVALID_HANDLE_VALUE) {
+            }
+        #else
+            NativeFile::NativeFile() : m_direct(false),
+                                       m_fd(-1) {
+            }
+        #endif
+
+        NativeFile::~NativeFile() {
+            (void) close();
+        }
+
+        Result<void> NativeFile::open(const std::filesystem::path& path, Mode mode) {
+            m_path = path.string();
+            m_direct = mode == Mode::ReadDirect;
+
+            #if defined(PLATFORM_WINDOWS)
+                bool reading = mode == Mode::Read || mode == Mode::ReadDirect;
+
+                DWORD flags = FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN;
+                if (m_direct) {
+                    flags |= FILE_FLAG_NO_BUFFERING;
+                }
+
+                m_handle = CreateFileW(path.c_str(), reading ? GENERIC_READ : (mode == Mode::Append ? FILE_APPEND_DATA : GENERIC_WRITE), FILE_SHARE_READ, nullptr, reading ? OPEN_EXISTING : (mode == Mode::Append ? OPEN_ALWAYS : CREATE_ALWAYS), flags, nullptr);
+                if (m_handle == INVALID_HANDLE_VALUE) {
+                    return Result<void>::NOT_OK(utils::format("failed to open '{}': {}", m_path, last_error()));
+                }
+            #else
+                int flags = O_CLOEXEC;
+                switch (mode) {
+                    case Mode::Read:
+                    case Mode::ReadDirect:
+                        flags |= O_RDONLY;
+                        break;
+                    case Mode::Write:
+                        flags |= O_WRONLY | O_CREAT | O_TRUNC;
+                        break;
+                    case Mode::Append:
+                        flags |= O_WRONLY | O_CREAT | O_APPEND;
+                        break;
+                }
+
+                #if defined(O_DIRECT)
+                    if (m_direct) {
+                        m_fd = ::open(path.c_str(), flags | O_DIRECT, 0666);
+                        if (m_fd < 0 && errno == EINVAL) {
+                            // Filesystem does not support direct I/O
+                            m_direct = false;
+                        }
+                    }
+                #else
+                    m_direct = false;
+                #endif
+
+                if (!m_direct) {
+                    m_fd = ::open(path.c_str(), flags, 0666);
+                }
+
+                if (m_fd < 0) {
+                    return Result<void>::NOT_OK(utils::format("failed to open '{}': {}", m_path, last_error()));
+                }
+
+                #if !defined(O_DIRECT) && defined(F_NOCACHE)
+                    if (mode == Mode::ReadDirect) {
+                        ::fcntl(m_fd, F_NOCACHE, 1);
+                    }
+                #endif
+
+                #if defined(POSIX_FADV_SEQUENTIAL)
+                    if (mode == Mode::Read) {
+                        ::posix_fadvise(m_fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+                    }
+                #endif
+            #endif
+
+            return Result<void>::OK();
+        }
+
+        Result<std::size_t> NativeFile::read(void* buffer, std::size_t size, std::uint64_t offset) {
+            std::size_t total = 0u;
+
+            while (total < size) {
+                #if defined(PLATFORM_WINDOWS)
+                    std::uint64_t position = offset + total;
+
+                    OVERLAPPED overlapped { };
+                    overlapped.Offset = static_cast<DWORD>(position);
+                    overlapped.OffsetHigh = static_cast<DWORD>(position >> 32);
+
+                    DWORD count = 0;
+                    if (!ReadFile(m_handle, static_cast<char*>(buffer) + total, static_cast<DWORD>(std::min<std::size_t>(size - total, 1u << 30)), &count, &overlapped) && GetLastError() != ERROR_HANDLE_EOF) {
+                        return Result<std::size_t>::NOT_OK(utils::format("failed to read '{}': {}", m_path, last_error()));
+                    }
+                #else
+                    ssize_t count = ::pread(m_fd, static_cast<char*>(buffer) + total, size - total, static_cast<off_t>(offset + total));
+                    if (count < 0) {
+                        if (errno == EINTR) {
+                            continue;
+                        }
+
+                        return Result<std::size_t>::NOT_OK(utils::format("failed to read '{}': {}", m_path, last_error()));
+                    }
+                #endif
+
+                total += static_cast<std::size_t>(count);
+
+                // Short reads only happen at the end of the file, where reading again at an unaligned offset would fail for direct I/O
+                if (count == 0 || m_direct) {
+                    break;
+                }
+            }
+
+            return Result<std::size_t>::OK(total);
+        }
+
+        Result<void> NativeFile::write(std::span<const std::string_view> pieces) {
+            #if defined(PLATFORM_WINDOWS)
+                for (std::string_view piece : pieces) {
+                    while (!piece.empty()) {
+                        DWORD count = 0;
+                        if (!WriteFile(m_handle, piece.data(), static_cast<DWORD>(std::min<std::size_t>(piece.length(), 1u << 30)), &count, nullptr)) {
+                            return Result<void>::NOT_OK(utils::format("failed to write '{}': {}", m_path, last_error()));
+                        }
+
+                        piece.remove_prefix(count);
+                    }
+                }
+            #else
+                // Gathered into as few calls as the limit on the number of buffers per call allows
+                constexpr std::size_t MAX_BUFFERS = 64;
+                iovec buffers[MAX_BUFFERS];
+
+                std::size_t index = 0u;
+                std::size_t offset = 0u; // Into the first piece that has not been written in its entirety
+
+                while (index < pieces.size()) {
+                    std::size_t count = 0u;
+                    for (std::size_t i = index; i < pieces.size() && count < MAX_BUFFERS; ++i) {
+                        std::string_view piece = i == index ? pieces[i].substr(offset) : pieces[i];
+                        if (!piece.empty()) {
+                            buffers[count++] = { const_cast<char*>(piece.data()), piece.length() };
+                        }
+                    }
+
+                    if (count == 0u) {
+                        break;
+                    }
+
+                    ssize_t written = ::writev(m_fd, buffers, static_cast<int>(count));
+                    if (written < 0) {
+                        if (errno == EINTR) {
+                            continue;
+                        }
+
+                        return Result<void>::NOT_OK(utils::format("failed to write '{}': {}", m_path, last_error()));
+                    }
+
+                    // Skip the pieces that were written, which may end partway through a piece
+                    std::size_t remaining = static_cast<std::size_t>(written);
+                    while (index < pieces.size() && remaining >= pieces[index].length() - offset) {
+                        remaining -= pieces[index].length() - offset;
+                        offset = 0u;
+                        ++index;
+                    }
+                    offset += remaining;
+                }
+            #endif
+
+            return Result<void>::OK();
+        }
+
+        Result<void> NativeFile::close() {
+            #if defined(PLATFORM_WINDOWS)
+                if (m_handle == INVALID_HANDLE_VALUE) {
+                    return Result<void>::OK();
+                }
+
+                bool closed = CloseHandle(std::exchange(m_handle, INVALID_HANDLE_VALUE));
+            #else
+                if (m_fd < 0) {
+                    return Result<void>::OK();
+                }
+
+                bool closed = ::close(std::exchange(m_fd, -1)) == 0;
+            #endif
+
+            if (!closed) {
+                return Result<void>::NOT_OK(utils::format("failed to close '{}': {}", m_path, last_error()));
+            }
+
+            return Result<void>::OK();
+        }
+
+        // Reads chunks into two buffers in turn, one of which is handed out while the next chunk is read into the other (on a background thread, if enabled)
+        class ChunkReader {
+            public:
+                ChunkReader(std::unique_ptr<NativeFile> file, std::size_t chunk_size, bool read_ahead);
+                ~ChunkReader();
+
+                [[nodiscard]] Result<std::span<const std::byte>> next();
+
+            private:
+                struct Chunk {
+                    std::byte* data;
+                    std::size_t size;
+                    std::string error;
+                };
+
+                struct AlignedDelete {
+                    void operator()(std::byte* data) const {
+                        ::operator delete(data, std::align_val_t(DIRECT_IO_ALIGNMENT));
+                    }
+                };
+
+                // Reads the chunk at the current offset into 'chunk', returns false at the end of the file (or if the read failed)
+                bool read(Chunk& chunk);
+
+                void run();
+
+                std::unique_ptr<NativeFile> m_file;
+                std::size_t m_chunk_size;
+                std::uint64_t m_offset; // Only accessed by the thread reading chunks
+                std::unique_ptr<std::byte, AlignedDelete> m_buffer;
+                Chunk m_chunks[2];
+
+                std::size_t m_front; // Chunk that is handed out (or next to be)
+                std::size_t m_ready; // Chunks that have been read but not handed out
+                bool m_held; // Front chunk is handed out
+                bool m_exhausted; // Last chunk (at the end of the file, or that failed) was handed out
+
+                std::thread m_thread;
+                std::mutex m_lock;
+                std::condition_variable m_condition;
+                bool m_stopping;
+        };
+
+        ChunkReader::ChunkReader(std::unique_ptr<NativeFile> file, std::size_t chunk_size, bool read_ahead) : m_file(std::move(file)),
+                                                                                                                 m_chunk_size(chunk_size),
+                                                                                                                 m_offset(0u),
+                                                                                                                 m_buffer(static_cast<std::byte*>(::operator new(chunk_size * 2u, std::align_val_t(DIRECT_IO_ALIGNMENT)))),
+                                                                                                                 m_chunks { { m_buffer.get(), 0u, { } }, { m_buffer.get() + chunk_size, 0u, { } } },
+                                                                                                                 m_front(0u),
+                                                                                                                 m_ready(0u),
+                                                                                                                 m_held(false),
+                                                                                                                 m_exhausted(false),
+                                                                                                                 m_stopping(false) {
+            if (read_ahead) {
+                m_thread = std::thread(&ChunkReader::run, this);
+            }
+        }
+
+        ChunkReader::~ChunkReader() {
+            if (m_thread.joinable()) {
+                {
+                    std::unique_lock<std::mutex> lock(m_lock);
+                    m_stopping = true;
+                }
+                m_condition.notify_all();
+                m_thread.join();
+            }
+        }
+
+        Result<std::span<const std::byte>> ChunkReader::next() {
+            if (!m_exhausted) {
+                if (!m_thread.joinable()) {
+                    m_exhausted = !read(m_chunks[0]);
+                }
+                else {
+                    std::unique_lock<std::mutex> lock(m_lock);
+                    if (m_held) {
+                        // Return the previous chunk to the background thread
+                        m_held = false;
+                        m_front = (m_front + 1u) % 2u;
+                        m_condition.notify_all();
+                    }
+
+                    m_condition.wait(lock, [this]() {
+                        return m_ready > 0u;
+                    });
+
+                    --m_ready;
+                    m_held = true;
+
+                    const Chunk& chunk = m_chunks[m_front];
+                    m_exhausted = chunk.size == 0u || !chunk.error.empty();
+                }
+            }
+
+            const Chunk& chunk = m_thread.joinable() ? m_chunks[m_front] : m_chunks[0];
+            if (!chunk.error.empty()) {
+                return Result<std::span<const std::byte>>::NOT_OK(chunk.error);
+            }
+
+            return Result<std::span<const std::byte>>::OK(std::span<const std::byte>(chunk.data, chunk.size));
+        }
+
+        bool ChunkReader::read(Chunk& chunk) {
+            Result<std::size_t> result = m_file->read(chunk.data, m_chunk_size, m_offset);
+            if (!result.ok()) {
+                chunk.size = 0u;
+                chunk.error = result.error();
+                return false;
+            }
+
+            chunk.size = result.result();
+            m_offset += chunk.size;
+            return chunk.size > 0u;
+        }
+
+        void ChunkReader::run() {
+            while (true) {
+                std::size_t index;
+                {
+                    std::unique_lock<std::mutex> lock(m_lock);
+                    m_condition.wait(lock, [this]() {
+                        return m_stopping || m_ready + static_cast<std::size_t>(m_held) < 2u;
+                    });
+
+                    if (m_stopping) {
+                        return;
+                    }
+
+                    // Slot following the chunks that are held or ready
+                    index = (m_front + static_cast<std::size_t>(m_held) + m_ready) % 2u;
+                }
+
+                bool more = read(m_chunks[index]);
+
+                {
+                    std::unique_lock<std::mutex> lock(m_lock);
+                    ++m_ready;
+                }
+                m_condition.notify_all();
+
+                if (!more) {
+                    return;
+                }
+            }
+        }
+
+    }
+
+    Result<FileReader> FileReader::open(const std::filesystem::path& path, const ReadOptions& options) {
+        std::unique_ptr<detail::NativeFile> file = std::make_unique<detail::NativeFile>();
+
+        Result<void> result = file->open(path, options.direct ? detail::NativeFile::Mode::ReadDirect : detail::NativeFile::Mode::Read);
+        if (!result.ok()) {
+            return Result<FileReader>::NOT_OK(result.error());
+        }
+
+        // Direct reads must be aligned in size as well as in offset
+        std::size_t chunk_size = std::max(options.chunk_size, detail::DIRECT_IO_ALIGNMENT);
+        chunk_size = (chunk_size + detail::DIRECT_IO_ALIGNMENT - 1u) / detail::DIRECT_IO_ALIGNMENT * detail::DIRECT_IO_ALIGNMENT;
+
+        FileReader reader;
+        reader.m_reader = std::make_unique<detail::ChunkReader>(std::move(file), chunk_size, options.read_ahead);
+        return Result<FileReader>::OK(std::move(reader));
+    }
+
+    FileReader::FileReader() : m_exhausted(false) {
+    }
+
+    FileReader::~FileReader() = default;
+
+    FileReader::FileReader(FileReader&& other) noexcept = default;
+
+    FileReader& FileReader::operator=(FileReader&& other) noexcept = default;
+
+    Result<std::span<const std::byte>> FileReader::next() {
+        if (!m_reader) {
+            return Result<std::span<const std::byte>>::OK();
+        }
+
+        return m_reader->next();
+    }
+
+    FileReader::LineRange FileReader::lines() {
+        return { this };
+    }
+
+    bool FileReader::next_line(std::string_view& line) {
+        m_line.clear();
+
+        while (!m_exhausted) {
+            std::size_t position = m_chunk.find('\n');
+
+            if (position != std::string_view::npos) {
+                if (m_line.empty()) {
+                    line = m_chunk.substr(0u, position);
+                }
+                else {
+                    m_line.append(m_chunk.substr(0u, position));
+                    line = m_line;
+                }
+
+                m_chunk.remove_prefix(position + 1u);
+
+                if (!line.empty() && line.back() == '\r') {
+                    line.remove_suffix(1u);
+                }
+
+                return true;
+            }
+
+            // The next chunk replaces this one, the beginning of the line must be kept
+            m_line.append(m_chunk);
+
+            Result<std::span<const std::byte>> chunk = next();
+            if (!chunk.ok()) {
+                m_exhausted = true;
+                throw std::runtime_error(chunk.error());
+            }
+
+            std::span<const std::byte> bytes = chunk.result();
+            m_chunk = std::string_view(reinterpret_cast<const char*>(bytes.data()), bytes.size());
+
+            if (m_chunk.empty()) {
+                // Last line may not be terminated
+                m_exhausted = true;
+
+                if (!m_line.empty()) {
+                    line = m_line;
+                    if (line.back() == '\r') {
+                        line.remove_suffix(1u);
+                    }
+
+                    return true;
+                }
+            }
+        }
+
+        return false;
+    }
+
+    FileReader::LineIterator::LineIterator() : m_reader(nullptr) {
+    }
+
+    FileReader::LineIterator::LineIterator(FileReader* reader) : m_reader(reader) {
+        ++*this;
+    }
+
+    std::string_view FileReader::LineIterator::operator*() const {
+        return m_line;
+    }
+
+    FileReader::LineIterator& FileReader::LineIterator::operator++() {
+        if (m_reader && !m_reader->next_line(m_line)) {
+            m_reader = nullptr;
+        }
+
+        return *this;
+    }
+
+    void FileReader::LineIterator::operator++(int) {
+        ++*this;
+    }
+
+    bool FileReader::LineIterator::operator==(std::default_sentinel_t) const {
+        return !m_reader;
+    }
+
+    FileReader::LineIterator FileReader::LineRange::begin() const {
+        return LineIterator(reader);
+    }
+
+    std::default_sentinel_t FileReader::LineRange::end() const {
+        return std::default_sentinel;
+    }
+
+    Result<FileWriter> FileWriter::open(const std::filesystem::path& path, const WriteOptions& options) {
+        std::unique_ptr<detail::NativeFile> file = std::make_unique<detail::NativeFile>();
+
+        Result<void> result = file->open(path, options.append ? detail::NativeFile::Mode::Append : detail::NativeFile::Mode::Write);
+        if (!result.ok()) {
+            return Result<FileWriter>::NOT_OK(result.error());
+        }
+
+        FileWriter writer;
+        writer.m_file = std::move(file);
+        writer.m_capacity = std::max(options.buffer_size, std::size_t(1u));
+        writer.m_buffer = std::make_unique_for_overwrite<char[]>(writer.m_capacity);
+        return Result<FileWriter>::OK(std::move(writer));
+    }
+
+    FileWriter::FileWriter() : m_capacity(0u),
+                               m_size(0u) {
+    }
+
+    FileWriter::~FileWriter() {
+        (void) close();
+    }
+
+    FileWriter::FileWriter(FileWriter&& other) noexcept : m_file(std::move(other.m_file)),
+                                                          m_buffer(std::move(other.m_buffer)),
+                                                          m_capacity(std::exchange(other.m_capacity, 0u)),
+                                                          m_size(std::exchange(other.m_size, 0u)) {
+    }
+
+    FileWriter& FileWriter::operator=(FileWriter&& other) noexcept {
+        if (this != &other) {
+            (void) close();
+
+            m_file = std::move(other.m_file);
+            m_buffer = std::move(other.m_buffer);
+            m_capacity = std::exchange(other.m_capacity, 0u);
+            m_size = std::exchange(other.m_size, 0u);
+        }
+
+        return *this;
+    }
+
+    Result<void> FileWriter::write(std::string_view data) {
+        return write(std::span<const std::string_view>(&data, 1u));
+    }
+
+    Result<void> FileWriter::write(std::initializer_list<std::string_view> pieces) {
+        return write(std::span<const std::string_view>(pieces.begin(), pieces.size()));
+    }
+
+    Result<void> FileWriter::write(std::span<const std::string_view> pieces) {
+        if (!m_file) {
+            return Result<void>::NOT_OK("file is not open");
+        }
+
+        std::size_t length = 0u;
+        for (std::string_view piece : pieces) {
+            length += piece.length();
+        }
+
+        if (m_size + length <= m_capacity) {
+            for (std::string_view piece : pieces) {
+                std::memcpy(m_buffer.get() + m_size, piece.data(), piece.length());
+                m_size += piece.length();
+            }
+
+            return Result<void>::OK();
+        }
+
+        // Written along with the contents of the buffer, the buffer goes first to preserve the order of writes
+        constexpr std::size_t MAX_PIECES = 16;
+        if (pieces.size() < MAX_PIECES) {
+            std::string_view gathered[MAX_PIECES];
+            gathered[0] = std::string_view(m_buffer.get(), m_size);
+            std::copy(pieces.begin(), pieces.end(), gathered + 1);
+
+            m_size = 0u;
+            return m_file->write(std::span<const std::string_view>(gathered, pieces.size() + 1u));
+        }
+
+        Result<void> result = flush();
+        if (!result.ok()) {
+            return result;
+        }
+
+        return m_file->write(pieces);
+    }
+
+    Result<void> FileWriter::flush() {
+        if (!m_file || m_size == 0u) {
+            return Result<void>::OK();
+        }
+
+        std::string_view contents(m_buffer.get(), m_size);
+        m_size = 0u;
+        return m_file->write(std::span<const std::string_view>(&contents, 1u));
+    }
+
+    Result<void> FileWriter::close() {
+        if (!m_file) {
+            return Result<void>::OK();
+        }
+
+        Result<void> flushed = flush();
+        Result<void> closed = m_file->close();
+        m_file.reset();
+
+        return flushed.ok() ? closed : flushed;
+    }
+
+    namespace detail {
+
+        // Size of the first read of each file read by read_many(), doubled for every read that fills the buffer
+        constexpr std::size_t BATCH_READ_SIZE = kilobytes(16);
+
+        Result<std::string> read_file(const std::filesystem::path& path) {
+            NativeFile file;
+
+            Result<void> opened = file.open(path, NativeFile::Mode::Read);
+            if (!opened.ok()) {
+                return Result<std::string>::NOT_OK(opened.error());
+            }
+
+            std::string contents;
+            std::size_t size = 0u;
+
+            while (true) {
+                contents.resize(std::max(contents.size() * 2u, BATCH_READ_SIZE));
+
+                Result<std::size_t> result = file.read(contents.data() + size, contents.size() - size, size);
+                if (!result.ok()) {
+                    return Result<std::string>::NOT_OK(result.error());
+                }
+
+                size += result.result();
+                if (size < contents.size()) {
+                    break;
+                }
+            }
+
+            contents.resize(size);
+            return Result<std::string>::OK(std::move(contents));
+        }
+
+        #if defined(UTILS_IO_URING)
+            // Submission and completion queues of an io_uring instance, shared with the kernel
+            class IoUring {
+                public:
+                    IoUring();
+                    ~IoUring();
+
+                    IoUring(const IoUring&) = delete;
+                    IoUring& operator=(const IoUring&) = delete;
+
+                    // Returns false if io_uring is not available, or does not support opening and reading files
+                    [[nodiscard]] bool initialize(unsigned entries);
+
+                    // Returns nullptr if the submission queue is full
+                    [[nodiscard]] io_uring_sqe* get_sqe();
+
+                    // Submits queued entries and waits for at least one completion, returns false on failure
+                    [[nodiscard]] bool submit_and_wait();
+
+                    // Returns the next completion, or nullptr if there are none (the completion is consumed by the next call)
+                    [[nodiscard]] const io_uring_cqe* next_cqe();
+
+                private:
+                    int m_fd;
+
+                    void* m_rings;
+                    std::size_t m_rings_size;
+                    void* m_completion_ring; // Equal to 'm_rings' if the kernel maps both rings at once
+                    std::size_t m_completion_ring_size;
+                    io_uring_sqe* m_sqes;
+                    std::size_t m_sqes_size;
+
+                    unsigned* m_sq_head;
+                    unsigned* m_sq_tail;
+                    unsigned m_sq_mask;
+                    unsigned* m_sq_array;
+                    unsigned m_sq_entries;
+                    unsigned m_pending; // Entries queued since the last submission
+
+                    unsigned* m_cq_head;
+                    unsigned* m_cq_tail;
+                    unsigned m_cq_mask;
+                    io_uring_cqe* m_cqes;
+                    bool m_consumed; // Completion returned by the last call to next_cqe() has not been released yet
+            };
+
+            IoUring::IoUring() : m_fd(-1),
+                                 m_rings(MAP_FAILED),
+                                 m_rings_size(0u),
+                                 m_completion_ring(MAP_FAILED),
+                                 m_completion_ring_size(0u),
+                                 m_sqes(static_cast<io_uring_sqe*>(MAP_FAILED)),
+                                 m_sqes_size(0u),
+                                 m_sq_head(nullptr),
+                                 m_sq_tail(nullptr),
+                                 m_sq_mask(0u),
+                                 m_sq_array(nullptr),
+                                 m_sq_entries(0u),
+                                 m_pending(0u),
+                                 m_cq_head(nullptr),
+                                 m_cq_tail(nullptr),
+                                 m_cq_mask(0u),
+                                 m_cqes(nullptr),
+                                 m_consumed(false) {
+            }
+
+            IoUring::~IoUring() {
+                if (m_sqes != MAP_FAILED) {
+                    ::munmap(m_sqes, m_sqes_size);
+                }
+
+                if (m_completion_ring != MAP_FAILED && m_completion_ring != m_rings) {
+                    ::munmap(m_completion_ring, m_completion_ring_size);
+                }
+
+                if (m_rings != MAP_FAILED) {
+                    ::munmap(m_rings, m_rings_size);
+                }
+
+                if (m_fd >= 0) {
+                    ::close(m_fd);
+                }
+            }
+
+            bool IoUring::initialize(unsigned entries) {
+                io_uring_params parameters { };
+                m_fd = static_cast<int>(::syscall(__NR_io_uring_setup, entries, &parameters));
+                if (m_fd < 0) {
+                    // Not supported by the kernel, or disabled (e.g. by a seccomp filter)
+                    return false;
+                }
+
+                // Opening files through io_uring requires Linux 5.6, which is also the first version that can be probed for supported operations
+                constexpr std::size_t PROBE_OPERATIONS = 256;
+                std::unique_ptr<std::byte[]> storage = std::make_unique<std::byte[]>(sizeof(io_uring_probe) + PROBE_OPERATIONS * sizeof(io_uring_probe_op));
+                io_uring_probe* probe = reinterpret_cast<io_uring_probe*>(storage.get());
+
+                if (::syscall(__NR_io_uring_register, m_fd, IORING_REGISTER_PROBE, probe, PROBE_OPERATIONS) < 0) {
+                    return false;
+                }
+
+                for (unsigned operation : { IORING_OP_OPENAT, IORING_OP_READ }) {
+                    if (operation > probe->last_op || !(probe->ops[operation].flags & IO_URING_OP_SUPPORTED)) {
+                        return false;
+                    }
+                }
+
+                m_rings_size = parameters.sq_off.array + parameters.sq_entries * sizeof(unsigned);
+                m_completion_ring_size = parameters.cq_off.cqes + parameters.cq_entries * sizeof(io_uring_cqe);
+
+                bool single_mapping = parameters.features & IORING_FEAT_SINGLE_MMAP;
+                if (single_mapping) {
+                    m_rings_size = m_completion_ring_size = std::max(m_rings_size, m_completion_ring_size);
+                }
+
+                m_rings = ::mmap(nullptr, m_rings_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, m_fd, IORING_OFF_SQ_RING);
+                if (m_rings == MAP_FAILED) {
+                    return false;
+                }
+
+                m_completion_ring = single_mapping ? m_rings : ::mmap(nullptr, m_completion_ring_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, m_fd, IORING_OFF_CQ_RING);
+                if (m_completion_ring == MAP_FAILED) {
+                    return false;
+                }
+
+                m_sqes_size = parameters.sq_entries * sizeof(io_uring_sqe);
+                m_sqes = static_cast<io_uring_sqe*>(::mmap(nullptr, m_sqes_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, m_fd, IORING_OFF_SQES));
+                if (m_sqes == MAP_FAILED) {
+                    return false;
+                }
+
+                char* rings = static_cast<char*>(m_rings);
+                m_sq_head = reinterpret_cast<unsigned*>(rings + parameters.sq_off.head);
+                m_sq_tail = reinterpret_cast<unsigned*>(rings + parameters.sq_off.tail);
+                m_sq_mask = *reinterpret_cast<unsigned*>(rings + parameters.sq_off.ring_mask);
+                m_sq_array = reinterpret_cast<unsigned*>(rings + parameters.sq_off.array);
+                m_sq_entries = parameters.sq_entries;
+
+                char* completion_ring = static_cast<char*>(m_completion_ring);
+                m_cq_head = reinterpret_cast<unsigned*>(completion_ring + parameters.cq_off.head);
+                m_cq_tail = reinterpret_cast<unsigned*>(completion_ring + parameters.cq_off.tail);
+                m_cq_mask = *reinterpret_cast<unsigned*>(completion_ring + parameters.cq_off.ring_mask);
+                m_cqes = reinterpret_cast<io_uring_cqe*>(completion_ring + parameters.cq_off.cqes);
+
+                return true;
+            }
+
+            io_uring_sqe* IoUring::get_sqe() {
+                // Only this thread writes the tail, the kernel advances the head as it consumes entries
+                unsigned tail = *m_sq_tail + m_pending;
+                if (tail - std::atomic_ref<unsigned>(*m_sq_head).load(std::memory_order_acquire) >= m_sq_entries) {
+                    return nullptr;
+                }
+
+                unsigned index = tail & m_sq_mask;
+                m_sq_array[index] = index;
+                ++m_pending;
+
+                io_uring_sqe* sqe = &m_sqes[index];
+                std::memset(sqe, 0, sizeof(io_uring_sqe));
+                return sqe;
+            }
+
+            bool IoUring::submit_and_wait() {
+                unsigned tail = *m_sq_tail + std::exchange(m_pending, 0u);
+                std::atomic_ref<unsigned>(*m_sq_tail).store(tail, std::memory_order_release);
+
+                while (true) {
+                    // Entries that were not consumed by an interrupted call are submitted again
+                    unsigned submitted = tail - std::atomic_ref<unsigned>(*m_sq_head).load(std::memory_order_acquire);
+
+                    long result = ::syscall(__NR_io_uring_enter, m_fd, submitted, 1u, IORING_ENTER_GETEVENTS, nullptr, 0);
+                    if (result >= 0) {
+                        return true;
+                    }
+
+                    if (errno != EINTR) {
+                        return false;
+                    }
+                }
+            }
+
+            const io_uring_cqe* IoUring::next_cqe() {
+                unsigned head = *m_cq_head;
+                if (m_consumed) {
+                    std::atomic_ref<unsigned>(*m_cq_head).store(++head, std::memory_order_release);
+                    m_consumed = false;
+                }
+
+                if (head == std::atomic_ref<unsigned>(*m_cq_tail).load(std::memory_order_acquire)) {
+                    return nullptr;
+                }
+
+                m_consumed = true;
+                return &m_cqes[head & m_cq_mask];
+            }
+
+            // Returns false if io_uring is not available, in which case no files were read
+            bool read_many_io_uring(std::span<const std::filesystem::path> paths, const utils::InplaceFunction<void(std::size_t index, Result<std::string>& contents)>& callback, std::size_t queue_depth) {
+                struct Read {
+                    std::string contents;
+                    std::size_t size;
+                    int fd;
+                    bool pending; // Operation (open or read) has been queued, and its completion has not been consumed
+                    bool done; // Passed to the callback
+                };
+
+                // Closing the ring does not wait for operations in flight, which must therefore be cancelled and completed before the buffers are freed
+                std::vector<Read> reads(paths.size(), Read { { }, 0u, -1, false, false });
+
+                // Every file being read has at most one operation in flight, so there is always space to continue reading it
+                queue_depth = std::min<std::size_t>(queue_depth, 4096u);
+
+                IoUring ring;
+                if (!ring.initialize(static_cast<unsigned>(std::bit_ceil(queue_depth)))) {
+                    return false;
+                }
+
+                // Each completion identifies the file (upper bits) and the operation (lowest bit) it belongs to
+                constexpr std::uint64_t OPEN = 0u;
+                constexpr std::uint64_t READ = 1u;
+                constexpr std::uint64_t CANCEL = std::numeric_limits<std::uint64_t>::max();
+
+                std::size_t opened = 0u;
+                std::size_t completed = 0u;
+                std::size_t in_flight = 0u;
+
+                auto complete = [&](std::size_t index, Result<std::string> result) {
+                    Read& read = reads[index];
+                    if (read.fd >= 0) {
+                        ::close(read.fd);
+                    }
+
+                    read = Read { { }, 0u, -1, false, true };
+                    --in_flight;
+                    ++completed;
+                    callback(index, result);
+                };
+
+                // Reads into the unused capacity of the buffer, which is grown first if there is none
+                auto submit_read = [&](std::size_t index, io_uring_sqe* sqe) {
+                    Read& read = reads[index];
+                    if (read.size == read.contents.size()) {
+                        read.contents.resize(std::max(read.contents.size() * 2u, BATCH_READ_SIZE));
+                    }
+
+                    sqe->opcode = IORING_OP_READ;
+                    sqe->fd = read.fd;
+                    sqe->addr = reinterpret_cast<std::uint64_t>(read.contents.data() + read.size);
+                    sqe->len = static_cast<std::uint32_t>(std::min<std::size_t>(read.contents.size() - read.size, 1u << 30));
+                    sqe->off = read.size;
+                    sqe->user_data = (index << 1u) | READ;
+                    read.pending = true;
+                };
+
+                // Cancels all operations in flight and consumes their completions (closing files opened in the meantime), so that the kernel no longer
+                // refers to the buffers once this returns
+                // If the ring cannot be waited on, the buffers are leaked instead, as they may still be written to
+                auto cancel = [&]() {
+                    std::size_t outstanding = static_cast<std::size_t>(std::ranges::count_if(reads, &Read::pending));
+                    std::size_t cancelled = 0u; // Files for which a cancellation has been queued, in order
+                    std::size_t cancellations = 0u; // Cancellations whose completions have not been consumed
+
+                    while (outstanding || cancellations) {
+                        for (; cancelled < opened; ++cancelled) {
+                            Read& read = reads[cancelled];
+                            if (!read.pending) {
+                                continue;
+                            }
+
+                            io_uring_sqe* sqe = ring.get_sqe();
+                            if (!sqe) {
+                                break;
+                            }
+
+                            // Cancellation fails if the operation has already completed (or cannot be interrupted), its completion is consumed below either way
+                            sqe->opcode = IORING_OP_ASYNC_CANCEL;
+                            sqe->addr = (cancelled << 1u) | (read.fd >= 0 ? READ : OPEN);
+                            sqe->user_data = CANCEL;
+                            ++cancellations;
+                        }
+
+                        if (!ring.submit_and_wait()) {
+                            break;
+                        }
+
+                        while (const io_uring_cqe* cqe = ring.next_cqe()) {
+                            if (cqe->user_data == CANCEL) {
+                                --cancellations;
+                                continue;
+                            }
+
+                            Read& read = reads[static_cast<std::size_t>(cqe->user_data >> 1u)];
+                            if ((cqe->user_data & 1u) == OPEN && cqe->res >= 0) {
+                                read.fd = cqe->res;
+                            }
+
+                            read.pending = false;
+                            --outstanding;
+                        }
+                    }
+
+                    // Files remain open while they are being read, even if their descriptors are closed
+                    for (Read& read : reads) {
+                        if (read.fd >= 0) {
+                            ::close(read.fd);
+                            read.fd = -1;
+                        }
+                    }
+
+                    if (outstanding || cancellations) {
+                        static_cast<void>(new std::vector<Read>(std::move(reads)));
+                    }
+                };
+
+                bool failed = false;
+                try {
+                    while (completed < paths.size()) {
+                        while (opened < paths.size() && in_flight < queue_depth) {
+                            io_uring_sqe* sqe = ring.get_sqe();
+                            if (!sqe) {
+                                break;
+                            }
+
+                            sqe->opcode = IORING_OP_OPENAT;
+                            sqe->fd = AT_FDCWD;
+                            sqe->addr = reinterpret_cast<std::uint64_t>(paths[opened].c_str());
+                            sqe->open_flags = O_RDONLY | O_CLOEXEC;
+                            sqe->user_data = (opened << 1u) | OPEN;
+
+                            reads[opened].pending = true;
+                            ++opened;
+                            ++in_flight;
+                        }
+
+                        if (!ring.submit_and_wait()) {
+                            failed = true;
+                            break;
+                        }
+
+                        while (const io_uring_cqe* cqe = ring.next_cqe()) {
+                            std::size_t index = static_cast<std::size_t>(cqe->user_data >> 1u);
+                            std::uint64_t operation = cqe->user_data & 1u;
+                            int result = cqe->res;
+                            reads[index].pending = false;
+
+                            if (result < 0) {
+                                complete(index, Result<std::string>::NOT_OK(utils::format("failed to {} '{}': {}", operation == OPEN ? "open" : "read", paths[index].string(), std::generic_category().message(-result))));
+                                continue;
+                            }
+
+                            Read& read = reads[index];
+                            if (operation == OPEN) {
+                                read.fd = result;
+                            }
+                            else {
+                                bool filled = read.size + static_cast<std::size_t>(result) == read.contents.size();
+                                read.size += static_cast<std::size_t>(result);
+
+                                // Short reads of regular files only happen at the end of the file
+                                if (!filled) {
+                                    read.contents.resize(read.size);
+                                    complete(index, Result<std::string>::OK(std::move(read.contents)));
+                                    continue;
+                                }
+                            }
+
+                            io_uring_sqe* sqe = ring.get_sqe();
+                            if (!sqe) {
+                                // Submission queue is at least as large as the number of files in flight, and entries are consumed on submission
+                                complete(index, read_file(paths[index]));
+                                continue;
+                            }
+
+                            submit_read(index, sqe);
+                        }
+                    }
+                }
+                catch (...) {
+                    cancel();
+                    throw;
+                }
+
+                if (failed) {
+                    // Files that have not completed are read by the calling thread, once the operations in flight have been cancelled
+                    std::vector<std::size_t> remaining;
+                    for (std::size_t index = 0u; index < paths.size(); ++index) {
+                        if (!reads[index].done) {
+                            remaining.push_back(index);
+                        }
+                    }
+
+                    cancel();
+
+                    for (std::size_t index : remaining) {
+                        Result<std::string> result = read_file(paths[index]);
+                        callback(index, result);
+                    }
+                }
+
+                return true;
+            }
+        #endif
+
+        void read_many_threads(std::span<const std::filesystem::path> paths, const utils::InplaceFunction<void(std::size_t index, Result<std::string>& contents)>& callback, std::size_t threads) {
+            struct Completion {
+                std::size_t index;
+                Result<std::string> contents;
+            };
+
+            std::atomic<std::size_t> next { 0u };
+
+            std::mutex lock;
+            std::condition_variable condition;
+            std::vector<Completion> completions;
+
+            auto run = [&]() {
+                for (std::size_t index = next.fetch_add(1u, std::memory_order_relaxed); index < paths.size(); index = next.fetch_add(1u, std::memory_order_relaxed)) {
+                    Result<std::string> contents = read_file(paths[index]);
+
+                    std::unique_lock<std::mutex> guard(lock);
+                    completions.push_back({ index, std::move(contents) });
+                    condition.notify_one();
+                }
+            };
+
+            std::vector<std::thread> pool;
+
+            // Threads finish the file they are reading and stop, so that the pool can be joined if creating a thread or invoking the callback throws
+            auto stop = [&]() {
+                next.store(paths.size(), std::memory_order_relaxed);
+                for (std::thread& thread : pool) {
+                    thread.join();
+                }
+            };
+
+            try {
+                pool.reserve(threads);
+                for (std::size_t i = 0u; i < threads; ++i) {
+                    pool.emplace_back(run);
+                }
+
+                // Callbacks are invoked outside of the lock, so that they do not hold up the threads
+                std::vector<Completion> batch;
+                std::size_t completed = 0u;
+
+                while (completed < paths.size()) {
+                    {
+                        std::unique_lock<std::mutex> guard(lock);
+                        condition.wait(guard, [&]() {
+                            return !completions.empty();
+                        });
+                        std::swap(batch, completions);
+                    }
+
+                    for (Completion& completion : batch) {
+                        callback(completion.index, completion.contents);
+                    }
+
+                    completed += batch.size();
+                    batch.clear();
+                }
+            }
+            catch (...) {
+                stop();
+                throw;
+            }
+
+            stop();
+        }
+
+    }
+
+    std::string read(const std::filesystem::path& path) {
+        // Read with explicit reads rather than through a mapping, so that a file truncated by another process while it is read is reported as a short read
+        // instead of raising SIGBUS
+        Result<std::string> contents = detail::read_file(path);
+        if (!contents.ok()) {
+            throw std::runtime_error(contents.error());
+        }
+
+        return std::move(contents.result());
     }
 
     void write(const std::filesystem::path& path, std::string_view content) {
@@ -21,4 +1426,31 @@ namespace utils {
         // File automatically closed by the destructor
     }
 
+    void read_many(std::span<const std::filesystem::path> paths, const InplaceFunction<void(std::size_t index, Result<std::string>& contents)>& callback, const BatchReadOptions& options) {
+        if (paths.empty()) {
+            return;
+        }
+
+        std::size_t queue_depth = std::max(options.queue_depth, std::size_t(1u));
+
+        #if defined(UTILS_IO_URING)
+            if (options.io_uring && detail::read_many_io_uring(paths, callback, queue_depth)) {
+                return;
+            }
+        #endif
+
+        detail::read_many_threads(paths, callback, std::clamp<std::size_t>(options.threads, 1u, std::min(paths.size(), queue_depth)));
+    }
+
+    void dispatch_read_events(std::span<const std::filesystem::path> paths, const BatchReadOptions& options) {
+        read_many(paths, [paths](std::size_t index, Result<std::string>& contents) {
+            if (contents.ok()) {
+                dispatch_event(FileReadEvent { index, paths[index], std::move(contents.result()), { } });
+            }
+            else {
+                dispatch_event(FileReadEvent { index, paths[index], { }, contents.error() });
+            }
+        }, options);
+    }
+
 }
@@ -0,0 +1,528 @@
+#include "utils/filters.hpp"
+#include <algorithm> // std::max, std::min, std::ranges::any_of
+#include <bit> // std::bit_ceil, std::countl_zero
+#include <cmath> // std::ceil, std::exp, std::ldexp, std::log, std::pow, std::sqrt
+#include <cstring> // std::memcpy, std::memcmp
+#include <stdexcept> // std::invalid_argument
+
+namespace utils {
+
+    namespace detail {
+
+        // Serialized filters start with this header, followed by the raw table
+        struct FilterHeader {
+            char magic[4];
+            std::uint32_t version;
+            std::uint64_t parameters[3];
+        };
+
+        constexpr std::uint32_t filter_format_version = 1;
+
+        // Structures derive several independent indices from a single hash, so weak user-provided hashes are remixed first
+        // A single multiply-fold leaves sequential inputs correlated across the high and low halves, two rounds are needed to decorrelate them
+        std::uint64_t remix(std::uint64_t hash) {
+            hash = hash64_mix(hash ^ hash64_secret[0], hash64_secret[1]);
+            return hash64_mix(hash ^ hash64_secret[2], hash64_secret[3]);
+        }
+
+        // Maps 'value' uniformly onto [0, range) without a division
+        std::size_t reduce(std::uint32_t value, std::size_t range) {
+            return static_cast<std::size_t>((static_cast<std::uint64_t>(value) * range) >> 32);
+        }
+
+        void prefetch([[maybe_unused]] const void* address) {
+            #if defined(__GNUC__) || defined(__clang__)
+                __builtin_prefetch(address);
+            #endif
+        }
+
+        // BloomFilter sets one bit in each of the 8 words of a block, with the bit position derived from the hash by a different odd multiplier per word
+        // (split block Bloom filter, as used by Parquet / Impala), the fixed-length loops over the words are vectorized by the compiler
+        constexpr std::uint32_t bloom_salt[8] = { 0x47b6137bu, 0x44974d91u, 0x8824ad5bu, 0xa2b7289du, 0x705495c7u, 0x2df1424bu, 0x9efc4947u, 0x5c6bfb31u };
+
+        // Expected false positive rate of a split block Bloom filter with an average of 'load' elements per block
+        // Block loads follow a Poisson distribution, a block holding c elements has a false positive rate of (1 - (1 - 1/64)^c)^8
+        double blocked_bloom_false_positive_rate(double load) {
+            double rate = 0.0;
+            double probability = std::exp(-load); // P(c = 0)
+
+            std::size_t limit = static_cast<std::size_t>(load + 10.0 * std::sqrt(load) + 10.0);
+            for (std::size_t c = 0; c <= limit; ++c) {
+                if (c > 0) {
+                    probability *= load / static_cast<double>(c);
+                }
+                rate += probability * std::pow(1.0 - std::pow(1.0 - 1.0 / 64.0, static_cast<double>(c)), 8.0);
+            }
+
+            return rate;
+        }
+
+        // Number of elements batch operations look ahead when prefetching
+        constexpr std::size_t prefetch_distance = 8;
+
+        std::vector<std::byte> serialize_filter(const char (&magic)[5], std::uint64_t p0, std::uint64_t p1, std::uint64_t p2, const void* payload, std::size_t size) {
+            FilterHeader header { };
+            std::memcpy(header.magic, magic, sizeof(header.magic));
+            header.version = filter_format_version;
+            header.parameters[0] = p0;
+            header.parameters[1] = p1;
+            header.parameters[2] = p2;
+
+            std::vector<std::byte> data(sizeof(FilterHeader) + size);
+            std::memcpy(data.data(), &header, sizeof(FilterHeader));
+            std::memcpy(data.data() + sizeof(FilterHeader), payload, size);
+            return data;
+        }
+
+        // Returns an empty string on success, or a description of why 'data' is not a valid serialized filter
+        std::string read_filter_header(std::span<const std::byte> data, const char (&magic)[5], FilterHeader& header) {
+            if (data.size() < sizeof(FilterHeader)) {
+                return "buffer is too small to contain a filter header";
+            }
+
+            std::memcpy(&header, data.data(), sizeof(FilterHeader));
+
+            if (std::memcmp(header.magic, magic, sizeof(header.magic)) != 0) {
+                return "invalid filter magic (not a serialized " + std::string(magic, 4) + " filter, or written with a different byte order)";
+            }
+
+            if (header.version != filter_format_version) {
+                return "unsupported filter format version " + std::to_string(header.version);
+            }
+
+            return { };
+        }
+
+    }
+
+    // BloomFilter implementation
+
+    BloomFilter::BloomFilter(std::size_t expected_elements, double false_positive_rate) {
+        if (!(false_positive_rate > 0.0 && false_positive_rate < 1.0)) {
+            throw std::invalid_argument("BloomFilter false positive rate must be in the range (0, 1)");
+        }
+
+        double elements = static_cast<double>(std::max<std::size_t>(expected_elements, 1));
+
+        // Start from the optimal size of a standard Bloom filter and grow until the false positive rate of the blocked layout (which is higher, as blocks
+        // are unevenly loaded) meets the target
+        double ln2 = std::log(2.0);
+        double bits = -elements * std::log(false_positive_rate) / (ln2 * ln2);
+        std::size_t blocks = std::max<std::size_t>(static_cast<std::size_t>(std::ceil(bits / 512.0)), 1);
+
+        while (detail::blocked_bloom_false_positive_rate(elements / static_cast<double>(blocks)) > false_positive_rate) {
+            blocks += blocks / 32 + 1;
+        }
+
+        m_blocks.resize(blocks);
+        clear();
+    }
+
+    void BloomFilter::insert_hash(std::uint64_t hash) {
+        hash = detail::remix(hash);
+        Block& block = m_blocks[block_index(hash)];
+
+        std::uint32_t key = static_cast<std::uint32_t>(hash);
+        for (std::size_t i = 0; i < 8; ++i) {
+            block.words[i] |= std::uint64_t(1) << ((key * detail::bloom_salt[i]) >> 26);
+        }
+    }
+
+    bool BloomFilter::contains_hash(std::uint64_t hash) const {
+        hash = detail::remix(hash);
+        const Block& block = m_blocks[block_index(hash)];
+
+        // Branchless to allow vectorization, an early exit would mispredict on roughly half of all negative queries
+        std::uint32_t key = static_cast<std::uint32_t>(hash);
+        bool present = true;
+        for (std::size_t i = 0; i < 8; ++i) {
+            present &= ((block.words[i] >> ((key * detail::bloom_salt[i]) >> 26)) & 1u) != 0;
+        }
+
+        return present;
+    }
+
+    void BloomFilter::insert_hashes(std::span<const std::uint64_t> hashes) {
+        for (std::size_t i = 0; i < hashes.size(); ++i) {
+            if (i + detail::prefetch_distance < hashes.size()) {
+                detail::prefetch(&m_blocks[block_index(detail::remix(hashes[i + detail::prefetch_distance]))]);
+            }
+            insert_hash(hashes[i]);
+        }
+    }
+
+    std::size_t BloomFilter::contains_hashes(std::span<const std::uint64_t> hashes, std::span<bool> results) const {
+        if (results.size() < hashes.size()) {
+            throw std::invalid_argument("BloomFilter::contains_hashes results buffer is too small");
+        }
+
+        std::size_t count = 0;
+        for (std::size_t i = 0; i < hashes.size(); ++i) {
+            if (i + detail::prefetch_distance < hashes.size()) {
+                detail::prefetch(&m_blocks[block_index(detail::remix(hashes[i + detail::prefetch_distance]))]);
+            }
+            results[i] = contains_hash(hashes[i]);
+            count += results[i];
+        }
+
+        return count;
+    }
+
+    void BloomFilter::clear() {
+        std::fill(m_blocks.begin(), m_blocks.end(), Block { });
+    }
+
+    std::size_t BloomFilter::size_bytes() const {
+        return m_blocks.size() * sizeof(Block);
+    }
+
+    std::vector<std::byte> BloomFilter::serialize() const {
+        return detail::serialize_filter("UBLF", m_blocks.size(), 0, 0, m_blocks.data(), size_bytes());
+    }
+
+    Result<BloomFilter> BloomFilter::deserialize(std::span<const std::byte> data) {
+        detail::FilterHeader header { };
+        if (std::string error = detail::read_filter_header(data, "UBLF", header); !error.empty()) {
+            return Result<BloomFilter>::NOT_OK(std::move(error));
+        }
+
+        // Compared against the payload, as the product of a crafted block count may overflow
+        std::uint64_t blocks = header.parameters[0];
+        std::size_t payload = data.size() - sizeof(detail::FilterHeader);
+        if (blocks == 0 || payload % sizeof(Block) != 0 || blocks != payload / sizeof(Block)) {
+            return Result<BloomFilter>::NOT_OK("BloomFilter payload size does not match its header");
+        }
+
+        BloomFilter filter { };
+        filter.m_blocks.resize(blocks);
+        std::memcpy(filter.m_blocks.data(), data.data() + sizeof(detail::FilterHeader), filter.size_bytes());
+
+        return Result<BloomFilter>::OK(std::move(filter));
+    }
+
+    std::size_t BloomFilter::block_index(std::uint64_t hash) const {
+        // High bits select the block, low bits select the bits within the block
+        return detail::reduce(static_cast<std::uint32_t>(hash >> 32), m_blocks.size());
+    }
+
+    // CuckooFilter implementation
+
+    CuckooFilter::CuckooFilter(std::size_t capacity) {
+        // Buckets of 4 reliably reach a 95% load factor before insertions start to fail
+        std::size_t buckets = static_cast<std::size_t>(std::ceil(static_cast<double>(std::max<std::size_t>(capacity, 1)) / (SLOTS_PER_BUCKET * 0.95)));
+        m_buckets.resize(std::bit_ceil(buckets));
+    }
+
+    bool CuckooFilter::insert_hash(std::uint64_t hash) {
+        if (m_victim_fingerprint) {
+            // A previous insertion already failed, the filter is considered full
+            return false;
+        }
+
+        Location location = locate(hash);
+        if (bucket_insert(m_buckets[location.primary], location.fingerprint) || bucket_insert(m_buckets[location.alternate], location.fingerprint)) {
+            ++m_size;
+            return true;
+        }
+
+        // Both buckets are full, evict existing fingerprints to their alternate buckets until one finds a free slot
+        std::uint16_t fingerprint = location.fingerprint;
+        std::size_t bucket = (fingerprint & 1u) ? location.alternate : location.primary;
+
+        for (std::size_t kick = 0; kick < MAX_KICKS; ++kick) {
+            std::size_t shift = 16 * ((fingerprint + kick) % SLOTS_PER_BUCKET);
+            std::uint16_t evicted = static_cast<std::uint16_t>(m_buckets[bucket] >> shift);
+
+            m_buckets[bucket] = (m_buckets[bucket] & ~(std::uint64_t(0xffff) << shift)) | (static_cast<std::uint64_t>(fingerprint) << shift);
+
+            fingerprint = evicted;
+            bucket = alternate(bucket, fingerprint);
+
+            if (bucket_insert(m_buckets[bucket], fingerprint)) {
+                ++m_size;
+                return true;
+            }
+        }
+
+        // The last evicted fingerprint is kept aside so that no previously inserted element is lost
+        m_victim_fingerprint = fingerprint;
+        m_victim_bucket = bucket;
+        ++m_size;
+        return true;
+    }
+
+    bool CuckooFilter::contains_hash(std::uint64_t hash) const {
+        Location location = locate(hash);
+
+        bool victim = m_victim_fingerprint == location.fingerprint && (m_victim_bucket == location.primary || m_victim_bucket == location.alternate);
+        return bucket_contains(m_buckets[location.primary], location.fingerprint) || bucket_contains(m_buckets[location.alternate], location.fingerprint) || victim;
+    }
+
+    bool CuckooFilter::erase_hash(std::uint64_t hash) {
+        Location location = locate(hash);
+
+        if (bucket_erase(m_buckets[location.primary], location.fingerprint) || bucket_erase(m_buckets[location.alternate], location.fingerprint)) {
+            --m_size;
+
+            if (m_victim_fingerprint) {
+                // A slot was freed, try to move the victim back into the table
+                std::uint16_t fingerprint = m_victim_fingerprint;
+                std::size_t bucket = m_victim_bucket;
+
+                if (bucket_insert(m_buckets[bucket], fingerprint) || bucket_insert(m_buckets[alternate(bucket, fingerprint)], fingerprint)) {
+                    m_victim_fingerprint = 0;
+                }
+            }
+
+            return true;
+        }
+
+        if (m_victim_fingerprint == location.fingerprint && (m_victim_bucket == location.primary || m_victim_bucket == location.alternate)) {
+            m_victim_fingerprint = 0;
+            --m_size;
+            return true;
+        }
+
+        return false;
+    }
+
+    std::size_t CuckooFilter::insert_hashes(std::span<const std::uint64_t> hashes) {
+        for (std::size_t i = 0; i < hashes.size(); ++i) {
+            if (!insert_hash(hashes[i])) {
+                return i;
+            }
+        }
+
+        return hashes.size();
+    }
+
+    std::size_t CuckooFilter::contains_hashes(std::span<const std::uint64_t> hashes, std::span<bool> results) const {
+        if (results.size() < hashes.size()) {
+            throw std::invalid_argument("CuckooFilter::contains_hashes results buffer is too small");
+        }
+
+        std::size_t count = 0;
+        for (std::size_t i = 0; i < hashes.size(); ++i) {
+            if (i + detail::prefetch_distance < hashes.size()) {
+                Location upcoming = locate(hashes[i + detail::prefetch_distance]);
+                detail::prefetch(&m_buckets[upcoming.primary]);
+                detail::prefetch(&m_buckets[upcoming.alternate]);
+            }
+            results[i] = contains_hash(hashes[i]);
+            count += results[i];
+        }
+
+        return count;
+    }
+
+    void CuckooFilter::clear() {
+        std::fill(m_buckets.begin(), m_buckets.end(), 0);
+        m_size = 0;
+        m_victim_fingerprint = 0;
+        m_victim_bucket = 0;
+    }
+
+    std::size_t CuckooFilter::size() const {
+        return m_size;
+    }
+
+    std::size_t CuckooFilter::size_bytes() const {
+        return m_buckets.size() * sizeof(std::uint64_t);
+    }
+
+    std::vector<std::byte> CuckooFilter::serialize() const {
+        std::uint64_t victim = static_cast<std::uint64_t>(m_victim_fingerprint) | (static_cast<std::uint64_t>(m_victim_bucket) << 16);
+        return detail::serialize_filter("UCKF", m_buckets.size(), m_size, victim, m_buckets.data(), size_bytes());
+    }
+
+    Result<CuckooFilter> CuckooFilter::deserialize(std::span<const std::byte> data) {
+        detail::FilterHeader header { };
+        if (std::string error = detail::read_filter_header(data, "UCKF", header); !error.empty()) {
+            return Result<CuckooFilter>::NOT_OK(std::move(error));
+        }
+
+        // Compared against the payload, as the product of a crafted bucket count may overflow
+        std::uint64_t buckets = header.parameters[0];
+        std::size_t payload = data.size() - sizeof(detail::FilterHeader);
+        if (!std::has_single_bit(buckets) || payload % sizeof(std::uint64_t) != 0 || buckets != payload / sizeof(std::uint64_t)) {
+            return Result<CuckooFilter>::NOT_OK("CuckooFilter payload size does not match its header");
+        }
+
+        CuckooFilter filter { };
+        filter.m_buckets.resize(buckets);
+        std::memcpy(filter.m_buckets.data(), data.data() + sizeof(detail::FilterHeader), filter.size_bytes());
+
+        filter.m_victim_fingerprint = static_cast<std::uint16_t>(header.parameters[2]);
+        filter.m_victim_bucket = static_cast<std::size_t>(header.parameters[2] >> 16) & (buckets - 1);
+
+        // Every element occupies a slot, except for the one kept aside after a failed insertion
+        std::uint64_t size = header.parameters[1];
+        if (size > buckets * SLOTS_PER_BUCKET + (filter.m_victim_fingerprint ? 1u : 0u)) {
+            return Result<CuckooFilter>::NOT_OK("CuckooFilter element count exceeds its capacity");
+        }
+
+        filter.m_size = static_cast<std::size_t>(size);
+
+        return Result<CuckooFilter>::OK(std::move(filter));
+    }
+
+    CuckooFilter::Location CuckooFilter::locate(std::uint64_t hash) const {
+        hash = detail::remix(hash);
+
+        // Fingerprint from the high bits, primary bucket from the low bits
+        std::uint16_t fingerprint = static_cast<std::uint16_t>(hash >> 48);
+        if (!fingerprint) {
+            fingerprint = 1;
+        }
+
+        std::size_t primary = static_cast<std::size_t>(hash) & (m_buckets.size() - 1);
+        return { fingerprint, primary, alternate(primary, fingerprint) };
+    }
+
+    std::size_t CuckooFilter::alternate(std::size_t bucket, std::uint16_t fingerprint) const {
+        // XOR with a function of the fingerprint only, so that the alternate of the alternate is the original bucket
+        return (bucket ^ (static_cast<std::size_t>(fingerprint) * 0x5bd1e995u)) & (m_buckets.size() - 1);
+    }
+
+    bool CuckooFilter::bucket_contains(std::uint64_t bucket, std::uint16_t fingerprint) {
+        // Checks all 4 slots at once: a slot matches if it becomes zero after XOR with the broadcast fingerprint
+        constexpr std::uint64_t lsbs = 0x0001000100010001ull;
+        constexpr std::uint64_t msbs = 0x8000800080008000ull;
+
+        std::uint64_t x = bucket ^ (lsbs * fingerprint);
+        return ((x - lsbs) & ~x & msbs) != 0;
+    }
+
+    bool CuckooFilter::bucket_insert(std::uint64_t& bucket, std::uint16_t fingerprint) {
+        for (std::size_t slot = 0; slot < SLOTS_PER_BUCKET; ++slot) {
+            std::size_t shift = 16 * slot;
+            if (((bucket >> shift) & 0xffff) == 0) {
+                bucket |= static_cast<std::uint64_t>(fingerprint) << shift;
+                return true;
+            }
+        }
+
+        return false;
+    }
+
+    bool CuckooFilter::bucket_erase(std::uint64_t& bucket, std::uint16_t fingerprint) {
+        for (std::size_t slot = 0; slot < SLOTS_PER_BUCKET; ++slot) {
+            std::size_t shift = 16 * slot;
+            if (((bucket >> shift) & 0xffff) == fingerprint) {
+                bucket &= ~(std::uint64_t(0xffff) << shift);
+                return true;
+            }
+        }
+
+        return false;
+    }
+
+    // HyperLogLog implementation
+
+    HyperLogLog::HyperLogLog(unsigned precision) : m_precision(precision) {
+        if (precision < 4 || precision > 18) {
+            throw std::invalid_argument("HyperLogLog precision must be in the range [4, 18]");
+        }
+
+        m_registers.resize(std::size_t(1) << precision);
+    }
+
+    void HyperLogLog::insert_hash(std::uint64_t hash) {
+        hash = detail::remix(hash);
+
+        // The top bits select the register, which records the longest run of leading zeros seen in the remaining bits
+        std::size_t index = static_cast<std::size_t>(hash >> (64 - m_precision));
+        std::uint64_t remaining = (hash << m_precision) | (std::uint64_t(1) << (m_precision - 1)); // Sentinel bit bounds the rank
+        std::uint8_t rank = static_cast<std::uint8_t>(std::countl_zero(remaining) + 1);
+
+        m_registers[index] = std::max(m_registers[index], rank);
+    }
+
+    void HyperLogLog::insert_hashes(std::span<const std::uint64_t> hashes) {
+        for (std::uint64_t hash : hashes) {
+            insert_hash(hash);
+        }
+    }
+
+    double HyperLogLog::estimate() const {
+        double m = static_cast<double>(m_registers.size());
+
+        double sum = 0.0;
+        std::size_t zeros = 0;
+        for (std::uint8_t rank : m_registers) {
+            sum += std::ldexp(1.0, -static_cast<int>(rank));
+            zeros += rank == 0;
+        }
+
+        double alpha;
+        switch (m_registers.size()) {
+            case 16:
+                alpha = 0.673;
+                break;
+            case 32:
+                alpha = 0.697;
+                break;
+            case 64:
+                alpha = 0.709;
+                break;
+            default:
+                alpha = 0.7213 / (1.0 + 1.079 / m);
+                break;
+        }
+
+        double estimate = alpha * m * m / sum;
+
+        if (estimate <= 2.5 * m && zeros) {
+            // Small range correction (linear counting), no large range correction is necessary with 64-bit hashes
+            return m * std::log(m / static_cast<double>(zeros));
+        }
+
+        return estimate;
+    }
+
+    void HyperLogLog::merge(const HyperLogLog& other) {
+        if (other.m_precision != m_precision) {
+            throw std::invalid_argument("HyperLogLog sketches with different precisions cannot be merged");
+        }
+
+        for (std::size_t i = 0; i < m_registers.size(); ++i) {
+            m_registers[i] = std::max(m_registers[i], other.m_registers[i]);
+        }
+    }
+
+    void HyperLogLog::clear() {
+        std::fill(m_registers.begin(), m_registers.end(), 0);
+    }
+
+    unsigned HyperLogLog::precision() const {
+        return m_precision;
+    }
+
+    std::vector<std::byte> HyperLogLog::serialize() const {
+        return detail::serialize_filter("UHLL", m_precision, 0, 0, m_registers.data(), m_registers.size());
+    }
+
+    Result<HyperLogLog> HyperLogLog::deserialize(std::span<const std::byte> data) {
+        detail::FilterHeader header { };
+        if (std::string error = detail::read_filter_header(data, "UHLL", header); !error.empty()) {
+            return Result<HyperLogLog>::NOT_OK(std::move(error));
+        }
+
+        std::uint64_t precision = header.parameters[0];
+        if (precision < 4 || precision > 18 || data.size() - sizeof(detail::FilterHeader) != (std::size_t(1) << precision)) {
+            return Result<HyperLogLog>::NOT_OK("HyperLogLog payload size does not match its header");
+        }
+
+        HyperLogLog sketch(static_cast<unsigned>(precision));
+        std::memcpy(sketch.m_registers.data(), data.data() + sizeof(detail::FilterHeader), sketch.m_registers.size());
+
+        // Ranks are bounded by the number of hash bits that remain after the register index (see insert_hash)
+        std::uint8_t max_rank = static_cast<std::uint8_t>(64u - precision + 1u);
+        if (std::ranges::any_of(sketch.m_registers, [max_rank](std::uint8_t rank) { return rank > max_rank; })) {
+            return Result<HyperLogLog>::NOT_OK("HyperLogLog register rank exceeds the maximum for its precision");
+        }
+
+        return Result<HyperLogLog>::OK(std::move(sketch));
+    }
+
+}
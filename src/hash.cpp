@@ -0,0 +1,18 @@
+
+#include "utils/hash.hpp"
+#include <cstring> // std::strlen
+
+namespace utils {
+
+    void hash_combine(std::size_t& seed, const char* value) {
+        hash_combine(seed, value, std::strlen(value));
+    }
+
+    void hash_combine(std::size_t& seed, const char* value, std::size_t length) {
+        std::size_t hash = static_cast<std::size_t>(hash64(std::string_view(value, length)));
+
+        // Inspired by Boost
+        seed ^= hash + 0x9e3779b9 + (seed << 6) + (seed >> 2);
+    }
+
+}
@@ -0,0 +1,150 @@
+#include "utils/interner.hpp"
+#include "utils/hash.hpp"
+#include <bit> // std::bit_width
+#include <cstring> // std::memcpy
+
+namespace utils {
+
+    StringInterner::Table::Table(std::size_t capacity) : capacity(capacity),
+                                                         slots(std::make_unique<std::atomic<std::uint64_t>[]>(capacity)) {
+        for (std::size_t i = 0; i < capacity; ++i) {
+            slots[i].store(0, std::memory_order_relaxed);
+        }
+    }
+
+    StringInterner::Shard::Shard() : table(nullptr),
+                                     size(0),
+                                     strings(kilobytes(16)) {
+        tables.emplace_back(std::make_unique<Table>(64));
+        table.store(tables.back().get(), std::memory_order_relaxed);
+    }
+
+    StringInterner::StringInterner() : m_size(0) {
+        for (std::atomic<std::string_view*>& segment : m_segments) {
+            segment.store(nullptr, std::memory_order_relaxed);
+        }
+    }
+
+    StringInterner::~StringInterner() {
+        for (std::atomic<std::string_view*>& segment : m_segments) {
+            delete[] segment.load(std::memory_order_relaxed);
+        }
+    }
+
+    StringInterner::Atom StringInterner::intern(std::string_view value) {
+        std::uint64_t hash = hash64(value);
+        Shard& shard = m_shards[hash & (SHARD_COUNT - 1)];
+
+        // Most strings have already been interned, check without locking first
+        if (std::optional<Atom> atom = find(value, hash, shard)) {
+            return *atom;
+        }
+
+        std::lock_guard<std::mutex> lock(shard.mutex);
+
+        // Another thread may have inserted the same string in the meantime
+        if (std::optional<Atom> atom = find(value, hash, shard)) {
+            return *atom;
+        }
+
+        // Strings are stored null-terminated for interoperability with C APIs
+        char* data = static_cast<char*>(shard.strings.allocate(value.length() + 1, 1));
+        std::memcpy(data, value.data(), value.length());
+        data[value.length()] = '\0';
+
+        Atom atom = m_size.fetch_add(1, std::memory_order_relaxed);
+        entry(atom) = std::string_view(data, value.length());
+
+        Table* table = shard.table.load(std::memory_order_relaxed);
+        if ((shard.size + 1) * 2 > table->capacity) {
+            // Grow at 50% load to keep probe sequences short, readers still probing the old table remain valid as it is never freed
+            std::unique_ptr<Table> grown = std::make_unique<Table>(table->capacity * 2);
+
+            for (std::size_t i = 0; i < table->capacity; ++i) {
+                std::uint64_t slot = table->slots[i].load(std::memory_order_relaxed);
+                if (slot) {
+                    insert(*grown, slot, static_cast<Atom>(slot) - 1);
+                }
+            }
+
+            table = grown.get();
+            shard.tables.emplace_back(std::move(grown));
+            shard.table.store(table, std::memory_order_release);
+        }
+
+        // Release ordering publishes the string (and its entry) to readers that observe the slot
+        insert(*table, hash, atom);
+        ++shard.size;
+
+        return atom;
+    }
+
+    std::optional<StringInterner::Atom> StringInterner::find(std::string_view value) const {
+        std::uint64_t hash = hash64(value);
+        return find(value, hash, m_shards[hash & (SHARD_COUNT - 1)]);
+    }
+
+    std::string_view StringInterner::lookup(Atom atom) const {
+        return entry(atom);
+    }
+
+    std::size_t StringInterner::size() const {
+        return m_size.load(std::memory_order_relaxed);
+    }
+
+    std::optional<StringInterner::Atom> StringInterner::find(std::string_view value, std::uint64_t hash, const Shard& shard) const {
+        const Table* table = shard.table.load(std::memory_order_acquire);
+
+        std::uint64_t tag = hash >> 32;
+        std::size_t mask = table->capacity - 1;
+
+        for (std::size_t position = tag & mask; ; position = (position + 1) & mask) {
+            std::uint64_t slot = table->slots[position].load(std::memory_order_acquire);
+            if (!slot) {
+                return std::nullopt;
+            }
+
+            // Only strings with a matching hash tag are compared
+            if ((slot >> 32) == tag) {
+                Atom atom = static_cast<Atom>(slot) - 1;
+                if (entry(atom) == value) {
+                    return atom;
+                }
+            }
+        }
+    }
+
+    void StringInterner::insert(Table& table, std::uint64_t hash, Atom atom) {
+        std::uint64_t tag = hash >> 32;
+        std::size_t mask = table.capacity - 1;
+
+        std::size_t position = tag & mask;
+        while (table.slots[position].load(std::memory_order_relaxed)) {
+            position = (position + 1) & mask;
+        }
+
+        table.slots[position].store((tag << 32) | (static_cast<std::uint64_t>(atom) + 1), std::memory_order_release);
+    }
+
+    std::string_view& StringInterner::entry(Atom atom) const {
+        // Segment k holds FIRST_SEGMENT_SIZE * 2^k entries, starting at atom FIRST_SEGMENT_SIZE * (2^k - 1)
+        std::size_t index = static_cast<std::size_t>(std::bit_width(atom / FIRST_SEGMENT_SIZE + 1) - 1);
+        std::size_t offset = atom - FIRST_SEGMENT_SIZE * ((std::size_t(1) << index) - 1);
+
+        std::string_view* segment = m_segments[index].load(std::memory_order_acquire);
+        if (!segment) {
+            // Only reachable from intern(), as atoms are published to readers after their entry is written
+            // Writers from different shards may race to create the same segment, the loser discards its allocation
+            std::string_view* created = new std::string_view[FIRST_SEGMENT_SIZE << index];
+            if (m_segments[index].compare_exchange_strong(segment, created, std::memory_order_acq_rel)) {
+                segment = created;
+            }
+            else {
+                delete[] created;
+            }
+        }
+
+        return segment[offset];
+    }
+
+}
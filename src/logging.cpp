@@ -1,10 +1,30 @@
 
 #include "utils/logging.hpp"
+#include "utils/flat_hash_map.hpp"
 #include <spdlog/sinks/stdout_color_sinks.h>
 #include <spdlog/sinks/dist_sink.h>
 #include <spdlog/logger.h>
 
+#if defined(SPDLOG_FMT_EXTERNAL)
+    #include <fmt/args.h>
+#else
+    #include <spdlog/fmt/bundled/args.h>
+#endif
+
+#include <algorithm> // std::max, std::equal, std::ranges::find
+#include <atomic> // std::atomic
+#include <bit> // std::bit_ceil, std::endian
+#include <chrono> // std::chrono::nanoseconds
+#include <condition_variable> // std::condition_variable
+#include <cstdint> // std::uint64_t
+#include <cstring> // std::memcpy
+#include <fstream> // std::ofstream
+#include <limits> // std::numeric_limits
+#include <mutex> // std::mutex, std::unique_lock
+#include <thread> // std::thread
+#include <unordered_map> // std::unordered_map
 #include <utility>
+#include <vector> // std::vector
 
 namespace utils::logging {
 
@@ -42,6 +62,815 @@ namespace utils::logging {
             return instance;
         }
 
+        std::atomic<int> runtime_level { static_cast<int>(Level::Debug) };
+
+        // Keeps the level cached by each tag up to date with the runtime level, or the level set for its name
+        class TagRegistry {
+            public:
+                void add(Tag& tag);
+                void remove(Tag& tag);
+
+                void set_level(Level level);
+                void set_level(std::string_view name, Level level);
+                void reset_level(std::string_view name);
+
+            private:
+                std::mutex m_lock;
+                std::vector<Tag*> m_tags;
+                std::unordered_map<std::string, Level> m_levels; // Levels set by name, applied to tags that are created later
+        };
+
+        TagRegistry& tag_registry() {
+            static TagRegistry instance;
+            return instance;
+        }
+
+        void TagRegistry::add(Tag& tag) {
+            std::unique_lock<std::mutex> lock(m_lock);
+
+            auto iterator = m_levels.find(tag.m_name);
+            tag.m_override = iterator != m_levels.end();
+            tag.m_level.store(tag.m_override ? static_cast<int>(iterator->second) : runtime_level.load(std::memory_order_relaxed), std::memory_order_relaxed);
+
+            m_tags.emplace_back(&tag);
+        }
+
+        void TagRegistry::remove(Tag& tag) {
+            std::unique_lock<std::mutex> lock(m_lock);
+            std::erase(m_tags, &tag);
+        }
+
+        void TagRegistry::set_level(Level level) {
+            std::unique_lock<std::mutex> lock(m_lock);
+            runtime_level.store(static_cast<int>(level), std::memory_order_relaxed);
+
+            for (Tag* tag : m_tags) {
+                if (!tag->m_override) {
+                    tag->m_level.store(static_cast<int>(level), std::memory_order_relaxed);
+                }
+            }
+        }
+
+        void TagRegistry::set_level(std::string_view name, Level level) {
+            std::unique_lock<std::mutex> lock(m_lock);
+            m_levels[std::string(name)] = level;
+
+            for (Tag* tag : m_tags) {
+                if (tag->m_name == name) {
+                    tag->m_override = true;
+                    tag->m_level.store(static_cast<int>(level), std::memory_order_relaxed);
+                }
+            }
+        }
+
+        void TagRegistry::reset_level(std::string_view name) {
+            std::unique_lock<std::mutex> lock(m_lock);
+            m_levels.erase(std::string(name));
+
+            for (Tag* tag : m_tags) {
+                if (tag->m_name == name) {
+                    tag->m_override = false;
+                    tag->m_level.store(runtime_level.load(std::memory_order_relaxed), std::memory_order_relaxed);
+                }
+            }
+        }
+
+        // Single-producer, single-consumer ring of variable-size records (each preceded by its size), written by one logging thread and read by the
+        // background thread
+        class RecordBuffer {
+            public:
+                RecordBuffer(std::size_t capacity, std::size_t generation);
+                ~RecordBuffer();
+
+                // Producer
+                [[nodiscard]] std::byte* reserve(std::size_t size);
+                void commit();
+
+                // Consumer
+                [[nodiscard]] const Record* front();
+                void pop();
+
+                [[nodiscard]] std::size_t max_record_size() const;
+
+                std::size_t generation; // Buffers are replaced when asynchronous logging is enabled with different options
+                std::atomic<bool> abandoned; // Owning thread has exited, the buffer is removed once it has been drained
+
+            private:
+                // Slots (header and record) are aligned to, and a multiple of, 8 bytes
+                static constexpr std::size_t ALIGNMENT = 8u;
+                static constexpr std::uint64_t SKIP = 1ull << 63; // Marks the unused space at the end of the buffer that precedes a wrapped slot
+
+                std::unique_ptr<std::byte[]> m_data;
+                std::size_t m_mask;
+
+                alignas(64) std::atomic<std::uint64_t> m_head; // Position of the first unread slot, written by the consumer
+                std::uint64_t m_front; // Size of the slot returned by front()
+
+                alignas(64) std::atomic<std::uint64_t> m_tail; // Position past the last published slot, written by the producer
+                std::uint64_t m_cached_head; // Last head observed by the producer
+                std::uint64_t m_pending; // Size of the slot returned by reserve()
+        };
+
+        RecordBuffer::RecordBuffer(std::size_t capacity, std::size_t generation) : generation(generation),
+                                                                                   abandoned(false),
+                                                                                   m_data(std::make_unique<std::byte[]>(capacity)),
+                                                                                   m_mask(capacity - 1u),
+                                                                                   m_head(0u),
+                                                                                   m_front(0u),
+                                                                                   m_tail(0u),
+                                                                                   m_cached_head(0u),
+                                                                                   m_pending(0u) {
+        }
+
+        RecordBuffer::~RecordBuffer() = default;
+
+        std::byte* RecordBuffer::reserve(std::size_t size) {
+            std::uint64_t capacity = m_mask + 1u;
+            std::uint64_t slot = (sizeof(std::uint64_t) + size + ALIGNMENT - 1u) & ~(ALIGNMENT - 1u);
+
+            std::uint64_t tail = m_tail.load(std::memory_order_relaxed);
+            std::uint64_t offset = tail & m_mask;
+
+            // Slots are contiguous, a slot that does not fit before the end of the buffer starts over at the beginning
+            std::uint64_t skipped = (capacity - offset < slot) ? capacity - offset : 0u;
+
+            if (tail + skipped + slot - m_cached_head > capacity) {
+                m_cached_head = m_head.load(std::memory_order_acquire);
+                if (tail + skipped + slot - m_cached_head > capacity) {
+                    return nullptr;
+                }
+            }
+
+            if (skipped) {
+                std::uint64_t header = skipped | SKIP;
+                std::memcpy(m_data.get() + offset, &header, sizeof(header));
+                offset = 0u;
+            }
+
+            std::memcpy(m_data.get() + offset, &slot, sizeof(slot));
+            m_pending = skipped + slot;
+            return m_data.get() + offset + sizeof(std::uint64_t);
+        }
+
+        void RecordBuffer::commit() {
+            m_tail.store(m_tail.load(std::memory_order_relaxed) + m_pending, std::memory_order_release);
+        }
+
+        const Record* RecordBuffer::front() {
+            std::uint64_t head = m_head.load(std::memory_order_relaxed);
+            std::uint64_t tail = m_tail.load(std::memory_order_acquire);
+
+            while (head != tail) {
+                std::uint64_t header;
+                std::memcpy(&header, m_data.get() + (head & m_mask), sizeof(header));
+
+                if (header & SKIP) {
+                    head += header & ~SKIP;
+                    continue;
+                }
+
+                // Releases the skipped space to the producer
+                m_head.store(head, std::memory_order_release);
+                m_front = header;
+                return reinterpret_cast<const Record*>(m_data.get() + (head & m_mask) + sizeof(std::uint64_t));
+            }
+
+            m_head.store(head, std::memory_order_release);
+            return nullptr;
+        }
+
+        void RecordBuffer::pop() {
+            m_head.store(m_head.load(std::memory_order_relaxed) + m_front, std::memory_order_release);
+        }
+
+        std::size_t RecordBuffer::max_record_size() const {
+            // Guarantees that a record fits after skipping the end of the buffer
+            return (m_mask + 1u) / 2u - sizeof(std::uint64_t);
+        }
+
+        constexpr char BINARY_LOG_MAGIC[8] = { 'U', 'T', 'I', 'L', 'S', 'L', 'O', 'G' };
+        constexpr std::uint8_t BINARY_LOG_VERSION = 2u;
+
+        // Arguments are recorded in the byte order of the writer, which follows the version in the header
+        constexpr std::uint8_t BINARY_LOG_LITTLE_ENDIAN = 0u;
+        constexpr std::uint8_t BINARY_LOG_BIG_ENDIAN = 1u;
+        constexpr std::uint8_t BINARY_LOG_BYTE_ORDER = std::endian::native == std::endian::little ? BINARY_LOG_LITTLE_ENDIAN : BINARY_LOG_BIG_ENDIAN;
+
+        // Entries of binary logs, records are combined with their level in the lower bits
+        constexpr std::uint8_t BINARY_LOG_CALL_SITE = 0x01u;
+        constexpr std::uint8_t BINARY_LOG_RECORD = 0x10u;
+
+        // Unsigned integers are written in little-endian base 128, 7 bits per byte
+        void write_varint(fmt::memory_buffer& out, std::uint64_t value) {
+            while (value >= 0x80u) {
+                out.push_back(static_cast<char>((value & 0x7fu) | 0x80u));
+                value >>= 7;
+            }
+            out.push_back(static_cast<char>(value));
+        }
+
+        void write_string(fmt::memory_buffer& out, std::string_view value) {
+            write_varint(out, value.length());
+            out.append(value.data(), value.data() + value.length());
+        }
+
+        [[nodiscard]] bool read_varint(std::istream& stream, std::uint64_t& value) {
+            value = 0u;
+            for (unsigned shift = 0u; shift < 64u; shift += 7u) {
+                int byte = stream.get();
+                if (byte == std::istream::traits_type::eof()) {
+                    return false;
+                }
+
+                value |= static_cast<std::uint64_t>(byte & 0x7f) << shift;
+                if (!(byte & 0x80)) {
+                    return true;
+                }
+            }
+
+            return false;
+        }
+
+        [[nodiscard]] bool read_string(std::istream& stream, std::string& value) {
+            std::uint64_t length;
+            if (!read_varint(stream, length) || length > std::numeric_limits<std::uint32_t>::max()) {
+                return false;
+            }
+
+            value.resize(length);
+            return static_cast<bool>(stream.read(value.data(), static_cast<std::streamsize>(length)));
+        }
+
+        // Writes records to a binary log on the background thread
+        // Each call site is assigned an identifier the first time one of its records is written, which subsequent records refer to
+        class BinaryLogWriter {
+            public:
+                explicit BinaryLogWriter(std::ofstream file);
+                ~BinaryLogWriter();
+
+                void write(const Record& record, fmt::memory_buffer& buffer);
+
+                // Writes out buffered entries, returns false if the file could not be written (once it fails, all further entries are discarded, as
+                // they may refer to call sites that were lost)
+                bool commit(bool flush);
+
+            private:
+                // Format string (nullptr for records written as text), file, line, and signature of a call site
+                using CallSite = std::tuple<const char*, const char*, std::uint32_t, const RecordSignature*>;
+
+                std::ofstream m_file;
+                fmt::memory_buffer m_entries;
+                fmt::memory_buffer m_text; // Encoded arguments of records written as text
+                FlatHashMap<CallSite, std::uint64_t> m_call_sites;
+                std::int64_t m_time; // Timestamps are written relative to the previous record
+        };
+
+        BinaryLogWriter::BinaryLogWriter(std::ofstream file) : m_file(std::move(file)),
+                                                               m_time(0) {
+            m_entries.append(std::begin(BINARY_LOG_MAGIC), std::end(BINARY_LOG_MAGIC));
+            m_entries.push_back(static_cast<char>(BINARY_LOG_VERSION));
+            m_entries.push_back(static_cast<char>(BINARY_LOG_BYTE_ORDER));
+        }
+
+        BinaryLogWriter::~BinaryLogWriter() {
+            commit(true);
+        }
+
+        void BinaryLogWriter::write(const Record& record, fmt::memory_buffer& buffer) {
+            const char* arguments = reinterpret_cast<const char*>(&record + 1);
+            std::size_t size = record.arguments;
+
+            // Records with arguments are written as-is only if their format string is a literal (and therefore identifies the call site) and all arguments are portable
+            const RecordSignature* signature = record.signature;
+            if (signature && (!record.literal || std::ranges::find(signature->types, ArgumentType::Opaque) != signature->types.end())) {
+                signature = nullptr;
+            }
+
+            if (!signature) {
+                std::string_view message = record.message;
+
+                if (record.signature) {
+                    buffer.clear();
+
+                    try {
+                        record.signature->format(record, buffer);
+                    }
+                    catch (const std::exception& e) {
+                        buffer.clear();
+                        fmt::format_to(fmt::appender(buffer), "failed to format message: {}", e.what());
+                    }
+
+                    message = std::string_view(buffer.data(), buffer.size());
+                }
+
+                // Written as a single string argument
+                m_text.resize(sizeof(std::uint32_t) + message.length());
+                encode_string(reinterpret_cast<std::byte*>(m_text.data()), message);
+
+                arguments = m_text.data();
+                size = m_text.size();
+            }
+
+            CallSite key { signature ? record.message.data() : nullptr, record.source.file_name(), record.source.line(), signature };
+            auto [iterator, inserted] = m_call_sites.try_emplace(key, m_call_sites.size());
+            std::uint64_t id = iterator->second;
+
+            if (inserted) {
+                m_entries.push_back(static_cast<char>(BINARY_LOG_CALL_SITE));
+                write_varint(m_entries, id);
+                write_varint(m_entries, record.source.line());
+                write_string(m_entries, record.source.file_name());
+                write_string(m_entries, record.source.function_name());
+
+                constexpr ArgumentType text[] = { ArgumentType::String };
+                std::span<const ArgumentType> types = signature ? signature->types : std::span<const ArgumentType>(text);
+
+                write_string(m_entries, signature ? record.message : "{}");
+                write_varint(m_entries, types.size());
+                for (ArgumentType type : types) {
+                    m_entries.push_back(static_cast<char>(type));
+                }
+            }
+
+            std::int64_t time = std::chrono::duration_cast<std::chrono::nanoseconds>(record.time.time_since_epoch()).count();
+            std::int64_t delta = time - m_time;
+            m_time = time;
+
+            m_entries.push_back(static_cast<char>(BINARY_LOG_RECORD | static_cast<std::uint8_t>(record.level)));
+            write_varint(m_entries, id);
+            write_varint(m_entries, (static_cast<std::uint64_t>(delta) << 1) ^ static_cast<std::uint64_t>(delta >> 63)); // Zigzag encoding, records from different threads may be out of order
+            write_varint(m_entries, record.thread);
+            write_varint(m_entries, size);
+            m_entries.append(arguments, arguments + size);
+        }
+
+        bool BinaryLogWriter::commit(bool flush) {
+            if (m_entries.size()) {
+                if (m_file) {
+                    m_file.write(m_entries.data(), static_cast<std::streamsize>(m_entries.size()));
+                }
+                m_entries.clear();
+            }
+
+            if (flush && m_file) {
+                m_file.flush();
+            }
+
+            return static_cast<bool>(m_file);
+        }
+
+        // Call sites are only registered and unregistered once, when their static limiter is constructed and destroyed
+        struct LimiterRegistry {
+            std::mutex lock;
+            std::vector<LimiterSite*> sites;
+        };
+
+        LimiterRegistry& limiter_registry() {
+            static LimiterRegistry registry;
+            return registry;
+        }
+
+        LimiterSite::~LimiterSite() {
+            unregister_limiter_site(*this);
+        }
+
+        void register_limiter_site(LimiterSite& site) {
+            LimiterRegistry& registry = limiter_registry();
+            std::unique_lock<std::mutex> lock(registry.lock);
+            registry.sites.emplace_back(&site);
+        }
+
+        void unregister_limiter_site(LimiterSite& site) {
+            LimiterRegistry& registry = limiter_registry();
+            std::unique_lock<std::mutex> lock(registry.lock);
+            std::erase(registry.sites, &site);
+        }
+
+        void report_suppressed() {
+            struct Suppressed {
+                spdlog::level::level_enum level;
+                std::source_location source;
+                std::size_t count;
+            };
+
+            // Logged after releasing the lock, as logging may wait for the background thread, which reports suppressed messages itself
+            std::vector<Suppressed> pending;
+            {
+                LimiterRegistry& registry = limiter_registry();
+                std::unique_lock<std::mutex> lock(registry.lock);
+
+                for (LimiterSite* site : registry.sites) {
+                    if (std::size_t count = site->suppressed(site->limiter)) {
+                        pending.push_back({ site->level, site->source, count });
+                    }
+                }
+            }
+
+            for (const Suppressed& suppressed : pending) {
+                log_suppressed(suppressed.level, suppressed.source, suppressed.count);
+            }
+        }
+
+        class AsyncBackend {
+            public:
+                AsyncBackend();
+                ~AsyncBackend();
+
+                // Records are written to 'binary' instead of to the sinks, if provided
+                void start(const AsyncOptions& options, std::unique_ptr<BinaryLogWriter> binary = nullptr);
+                void stop();
+
+                // Called by logging threads, a successful reserve() must be followed by commit()
+                [[nodiscard]] std::byte* reserve(std::size_t size, bool& dropped);
+                void commit();
+                void flush();
+
+                std::atomic<bool> running;
+                std::atomic<bool> binary;
+                std::atomic<std::size_t> dropped;
+
+            private:
+                struct LocalBuffer {
+                    ~LocalBuffer();
+                    std::shared_ptr<RecordBuffer> buffer;
+                };
+
+                [[nodiscard]] RecordBuffer& local_buffer();
+
+                void run();
+
+                // Writes all queued messages, returns the number of messages written
+                std::size_t drain(fmt::memory_buffer& buffer);
+                void write(const Record& record, fmt::memory_buffer& buffer);
+
+                // Options are read by logging threads, and published along with a new generation when asynchronous logging is (re-)enabled
+                std::atomic<std::size_t> m_capacity;
+                std::atomic<OverflowPolicy> m_overflow;
+                std::chrono::milliseconds m_interval;
+                std::atomic<std::size_t> m_generation;
+
+                // Logging threads between the start of reserve() and commit() (or a failed reserve()), which stop() waits for before the final drain
+                std::atomic<std::size_t> m_producers;
+                std::unique_ptr<BinaryLogWriter> m_binary;
+
+                std::mutex m_buffers_lock;
+                std::vector<std::shared_ptr<RecordBuffer>> m_buffers;
+
+                std::thread m_thread;
+                std::mutex m_lock;
+                std::condition_variable m_wakeup; // Background thread is woken early to make space, flush, or stop
+                std::condition_variable m_flushed_condition;
+                bool m_notified;
+                bool m_stopping;
+                std::uint64_t m_flush_requested;
+                std::uint64_t m_flushed;
+                std::size_t m_reported; // Dropped messages that have been reported
+
+                // Written and reported by the background thread only
+                std::size_t m_failed; // Messages that a sink failed to write
+                std::string m_failure; // Error of the last failed write
+                bool m_binary_failed;
+        };
+
+        // Set on the background thread, which writes messages logged while it formats a message (by user-defined formatters) synchronously, as it would
+        // otherwise wait for itself when its own buffer is full or a flush is requested
+        thread_local bool background_thread = false;
+
+        AsyncBackend& async_backend() {
+            static AsyncBackend instance;
+            return instance;
+        }
+
+        AsyncBackend::AsyncBackend() : running(false),
+                                       binary(false),
+                                       dropped(0u),
+                                       m_capacity(0u),
+                                       m_overflow(OverflowPolicy::Block),
+                                       m_interval(0),
+                                       m_generation(0u),
+                                       m_producers(0u),
+                                       m_notified(false),
+                                       m_stopping(false),
+                                       m_flush_requested(0u),
+                                       m_flushed(0u),
+                                       m_reported(0u),
+                                       m_failed(0u),
+                                       m_binary_failed(false) {
+            // The background thread writes to the logger and reports suppressed messages, both of which must therefore be destroyed after this
+            detail::logger();
+            limiter_registry();
+        }
+
+        AsyncBackend::~AsyncBackend() {
+            stop();
+        }
+
+        AsyncBackend::LocalBuffer::~LocalBuffer() {
+            if (buffer) {
+                buffer->abandoned.store(true, std::memory_order_release);
+            }
+        }
+
+        void AsyncBackend::start(const AsyncOptions& options, std::unique_ptr<BinaryLogWriter> writer) {
+            stop();
+
+            m_binary = std::move(writer);
+            m_binary_failed = false;
+            binary.store(m_binary != nullptr, std::memory_order_relaxed);
+
+            m_capacity.store(std::bit_ceil(std::max(options.buffer_size, kilobytes(4))), std::memory_order_relaxed);
+            m_overflow.store(options.overflow, std::memory_order_relaxed);
+            m_interval = options.interval;
+
+            // Logging threads that observe the new generation replace their buffers using the options above
+            m_generation.fetch_add(1u, std::memory_order_release);
+
+            m_thread = std::thread(&AsyncBackend::run, this);
+            running.store(true);
+        }
+
+        void AsyncBackend::stop() {
+            if (!m_thread.joinable()) {
+                return;
+            }
+
+            // Logging threads check whether asynchronous logging is enabled after registering as a producer (both sequentially consistent), so that
+            // any thread that queues a message after this is waited for below, and all other threads write their messages synchronously
+            running.store(false);
+            while (m_producers.load() != 0u) {
+                // The background thread keeps running (and making space for blocked threads) until all messages have been committed
+                std::this_thread::yield();
+            }
+
+            {
+                std::unique_lock<std::mutex> lock(m_lock);
+                m_stopping = true;
+            }
+            m_wakeup.notify_one();
+            m_thread.join();
+
+            // Closes the binary log
+            m_binary.reset();
+            binary.store(false, std::memory_order_relaxed);
+
+            std::unique_lock<std::mutex> lock(m_lock);
+            m_stopping = false;
+        }
+
+        RecordBuffer& AsyncBackend::local_buffer() {
+            thread_local LocalBuffer local;
+
+            std::size_t generation = m_generation.load(std::memory_order_acquire);
+            if (!local.buffer || local.buffer->generation != generation) {
+                if (local.buffer) {
+                    local.buffer->abandoned.store(true, std::memory_order_release);
+                }
+
+                local.buffer = std::make_shared<RecordBuffer>(m_capacity.load(std::memory_order_relaxed), generation);
+
+                std::unique_lock<std::mutex> lock(m_buffers_lock);
+                m_buffers.emplace_back(local.buffer);
+            }
+
+            return *local.buffer;
+        }
+
+        std::byte* AsyncBackend::reserve(std::size_t size, bool& is_dropped) {
+            m_producers.fetch_add(1u);
+            if (!running.load()) {
+                // Disabled after the caller checked, stop() may have already drained the buffers
+                m_producers.fetch_sub(1u, std::memory_order_release);
+                return nullptr;
+            }
+
+            RecordBuffer* buffer;
+            try {
+                buffer = &local_buffer();
+            }
+            catch (...) {
+                // Allocating the buffer of a new thread (or generation) failed
+                m_producers.fetch_sub(1u, std::memory_order_release);
+                throw;
+            }
+
+            if (size > buffer->max_record_size()) {
+                m_producers.fetch_sub(1u, std::memory_order_release);
+                return nullptr;
+            }
+
+            std::byte* storage = buffer->reserve(size);
+            while (!storage) {
+                if (m_overflow.load(std::memory_order_relaxed) == OverflowPolicy::Drop) {
+                    dropped.fetch_add(1u, std::memory_order_relaxed);
+                    is_dropped = true;
+                    m_producers.fetch_sub(1u, std::memory_order_release);
+                    return nullptr;
+                }
+
+                // The background thread is not stopped while this thread is registered as a producer, and will make space
+                {
+                    std::unique_lock<std::mutex> lock(m_lock);
+                    m_notified = true;
+                }
+                m_wakeup.notify_one();
+                std::this_thread::yield();
+
+                storage = buffer->reserve(size);
+            }
+
+            return storage;
+        }
+
+        void AsyncBackend::commit() {
+            local_buffer().commit();
+            m_producers.fetch_sub(1u, std::memory_order_release);
+        }
+
+        void AsyncBackend::flush() {
+            if (background_thread) {
+                // Called while formatting a message, earlier messages are either written or being written
+                detail::logger().flush();
+                return;
+            }
+
+            std::unique_lock<std::mutex> lock(m_lock);
+            if (!running.load(std::memory_order_acquire) || m_stopping) {
+                // Queued messages are (or are being) written by stop()
+                lock.unlock();
+                detail::logger().flush();
+                return;
+            }
+
+            // Acknowledged by the background thread, at the latest when it stops
+            std::uint64_t ticket = ++m_flush_requested;
+            m_wakeup.notify_one();
+            m_flushed_condition.wait(lock, [&]() {
+                return m_flushed >= ticket;
+            });
+        }
+
+        void AsyncBackend::run() {
+            background_thread = true;
+            fmt::memory_buffer buffer;
+
+            std::chrono::steady_clock::time_point reported = std::chrono::steady_clock::now(); // Last report of suppressed messages
+
+            while (true) {
+                std::uint64_t requested;
+                bool stopping;
+                {
+                    std::unique_lock<std::mutex> lock(m_lock);
+                    requested = m_flush_requested;
+                    stopping = m_stopping;
+                    m_notified = false;
+                }
+
+                // Messages queued before a flush (or stop) was requested are written before it is acknowledged
+                std::size_t written = drain(buffer);
+                if (m_binary && !m_binary->commit(requested != m_flushed || stopping) && !m_binary_failed) {
+                    detail::logger().log(spdlog::level::err, "failed to write binary log, subsequent messages are discarded");
+                    m_binary_failed = true;
+                }
+
+                std::size_t count = dropped.load(std::memory_order_relaxed);
+                if (count != m_reported) {
+                    detail::logger().log(spdlog::level::warn, "dropped {} log message(s) (buffer full)", count - m_reported);
+                    m_reported = count;
+                }
+
+                std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+                if (now - reported >= std::chrono::seconds(1)) {
+                    // Written synchronously, as this is the background thread
+                    report_suppressed();
+                    reported = now;
+                }
+
+                if (m_failed) {
+                    // Reaches the sinks that are still working (the logger reports errors of the failing sink itself to stderr)
+                    detail::logger().log(spdlog::level::err, "failed to write {} log message(s): {}", m_failed, m_failure);
+                    m_failed = 0u;
+                }
+
+                if (requested != m_flushed) {
+                    detail::logger().flush();
+
+                    {
+                        std::unique_lock<std::mutex> lock(m_lock);
+                        m_flushed = requested;
+                    }
+                    m_flushed_condition.notify_all();
+                }
+
+                if (stopping) {
+                    detail::logger().flush();
+
+                    {
+                        // Threads waiting for a flush requested after the final drain
+                        std::unique_lock<std::mutex> lock(m_lock);
+                        m_flushed = m_flush_requested;
+                    }
+                    m_flushed_condition.notify_all();
+                    return;
+                }
+
+                if (!written) {
+                    std::unique_lock<std::mutex> lock(m_lock);
+                    m_wakeup.wait_for(lock, m_interval, [&]() {
+                        return m_notified || m_stopping || m_flush_requested != requested;
+                    });
+                }
+            }
+        }
+
+        std::size_t AsyncBackend::drain(fmt::memory_buffer& buffer) {
+            std::vector<std::shared_ptr<RecordBuffer>> buffers;
+            {
+                std::unique_lock<std::mutex> lock(m_buffers_lock);
+                buffers = m_buffers;
+            }
+
+            std::size_t count = 0u;
+            for (const std::shared_ptr<RecordBuffer>& records : buffers) {
+                // Checked before draining, so that records published before the owning thread exited are not missed
+                bool abandoned = records->abandoned.load(std::memory_order_acquire);
+
+                while (const Record* record = records->front()) {
+                    write(*record, buffer);
+                    records->pop();
+                    ++count;
+                }
+
+                if (abandoned) {
+                    std::unique_lock<std::mutex> lock(m_buffers_lock);
+                    std::erase(m_buffers, records);
+                }
+            }
+
+            return count;
+        }
+
+        void AsyncBackend::write(const Record& record, fmt::memory_buffer& buffer) {
+            if (m_binary) {
+                m_binary->write(record, buffer);
+                return;
+            }
+
+            spdlog::logger& logger = detail::logger();
+            std::string_view message = record.message;
+
+            if (record.signature) {
+                buffer.clear();
+
+                try {
+                    record.signature->format(record, buffer);
+                }
+                catch (const std::exception& e) {
+                    // Cannot be reported to the logging thread
+                    buffer.clear();
+                    fmt::format_to(fmt::appender(buffer), "failed to format message: {}", e.what());
+                }
+
+                message = std::string_view(buffer.data(), buffer.size());
+            }
+
+            spdlog::details::log_msg msg(record.time, spdlog::source_loc(record.source.file_name(), static_cast<int>(record.source.line()), record.source.function_name()), logger.name(), record.level, spdlog::string_view_t(message.data(), message.length()));
+            msg.thread_id = record.thread;
+
+            for (const spdlog::sink_ptr& sink : logger.sinks()) {
+                if (sink->should_log(record.level)) {
+                    try {
+                        sink->log(msg);
+                    }
+                    catch (const std::exception& e) {
+                        // Sink errors are not propagated out of the background thread, and are reported once the current batch has been written
+                        ++m_failed;
+                        m_failure = e.what();
+                    }
+                }
+            }
+
+            if (record.level >= logger.flush_level()) {
+                // Failures are reported to stderr by the logger
+                logger.flush();
+            }
+        }
+
+        bool async_enabled() {
+            return !background_thread && async_backend().running.load(std::memory_order_acquire);
+        }
+
+        bool binary_enabled() {
+            return async_backend().binary.load(std::memory_order_relaxed);
+        }
+
+        std::byte* reserve_record(std::size_t size, bool& dropped) {
+            return async_backend().reserve(size, dropped);
+        }
+
+        void commit_record() {
+            async_backend().commit();
+        }
+
     }
 
     void set_pattern(std::string_view pattern) {
@@ -59,4 +888,332 @@ namespace utils::logging {
         sink->remove_sink(std::move(s));
     }
 
+    void set_level(Level level) {
+        detail::tag_registry().set_level(level);
+    }
+
+    Level get_level() {
+        return static_cast<Level>(detail::runtime_level.load(std::memory_order_relaxed));
+    }
+
+    void set_level(std::string_view tag, Level level) {
+        detail::tag_registry().set_level(tag, level);
+    }
+
+    void reset_level(std::string_view tag) {
+        detail::tag_registry().reset_level(tag);
+    }
+
+    Tag::Tag(std::string_view name) : m_name(name),
+                                      m_level(static_cast<int>(Level::Debug)),
+                                      m_override(false) {
+        detail::tag_registry().add(*this);
+    }
+
+    Tag::~Tag() {
+        detail::tag_registry().remove(*this);
+    }
+
+    std::string_view Tag::name() const {
+        return m_name;
+    }
+
+    // Computed in floating point and saturated, so that large intervals and bursts cannot overflow (or make 'm_next' overflow when advanced)
+    RateLimiter::RateLimiter(double rate, std::uint32_t burst) : m_interval(static_cast<std::int64_t>(1e9 / std::max(rate, 1e-9))),
+                                                                 m_tolerance(static_cast<std::int64_t>(std::min(static_cast<double>(m_interval) * (std::max(burst, 1u) - 1u), static_cast<double>(std::numeric_limits<std::int64_t>::max() / 4)))),
+                                                                 m_next(0),
+                                                                 m_suppressed(0u) {
+    }
+
+    Sampler::Sampler(std::uint32_t n) : m_n(std::max(n, 1u)),
+                                        m_count(0u),
+                                        m_reported(0u) {
+    }
+
+    void enable_async(const AsyncOptions& options) {
+        detail::async_backend().start(options);
+    }
+
+    void disable_async() {
+        detail::async_backend().stop();
+    }
+
+    void flush() {
+        // Queued before the flush, and therefore written by it
+        detail::report_suppressed();
+        detail::async_backend().flush();
+    }
+
+    std::size_t dropped_messages() {
+        return detail::async_backend().dropped.load(std::memory_order_relaxed);
+    }
+
+    Result<void> enable_binary(const std::filesystem::path& path, const AsyncOptions& options) {
+        std::ofstream file(path, std::ios::binary | std::ios::trunc);
+        if (!file) {
+            return Result<void>::NOT_OK(fmt::format("failed to open binary log '{}'", path.string()));
+        }
+
+        detail::async_backend().start(options, std::make_unique<detail::BinaryLogWriter>(std::move(file)));
+        return Result<void>::OK();
+    }
+
+    Result<void> decode_binary_log(std::istream& stream, const InplaceFunction<void(const DecodedMessage&)>& callback) {
+        using detail::ArgumentType;
+
+        char magic[sizeof(detail::BINARY_LOG_MAGIC)];
+        if (!stream.read(magic, sizeof(magic)) || !std::equal(std::begin(magic), std::end(magic), std::begin(detail::BINARY_LOG_MAGIC))) {
+            return Result<void>::NOT_OK("not a binary log");
+        }
+
+        int version = stream.get();
+        if (version != detail::BINARY_LOG_VERSION) {
+            return Result<void>::NOT_OK(fmt::format("unsupported binary log version {}", version));
+        }
+
+        int byte_order = stream.get();
+        if (byte_order != detail::BINARY_LOG_LITTLE_ENDIAN && byte_order != detail::BINARY_LOG_BIG_ENDIAN) {
+            return Result<void>::NOT_OK(fmt::format("invalid binary log byte order {}", byte_order));
+        }
+        if (byte_order != detail::BINARY_LOG_BYTE_ORDER) {
+            return Result<void>::NOT_OK("binary log was written with a different byte order");
+        }
+
+        struct CallSite {
+            std::string file;
+            std::string function;
+            std::string format;
+            std::uint32_t line;
+            std::vector<ArgumentType> types;
+        };
+
+        std::vector<CallSite> call_sites;
+        std::int64_t time = 0;
+
+        std::string arguments;
+        fmt::memory_buffer message;
+
+        while (true) {
+            int entry = stream.get();
+            if (entry == std::istream::traits_type::eof()) {
+                break;
+            }
+
+            if (entry == detail::BINARY_LOG_CALL_SITE) {
+                std::uint64_t id;
+                std::uint64_t line;
+                std::uint64_t count;
+                CallSite site;
+
+                if (!detail::read_varint(stream, id) || !detail::read_varint(stream, line) || !detail::read_string(stream, site.file) || !detail::read_string(stream, site.function) || !detail::read_string(stream, site.format) || !detail::read_varint(stream, count) || count > std::numeric_limits<std::uint16_t>::max()) {
+                    return Result<void>::NOT_OK("truncated call site entry");
+                }
+
+                if (id != call_sites.size()) {
+                    return Result<void>::NOT_OK(fmt::format("unexpected call site identifier {}", id));
+                }
+
+                site.line = static_cast<std::uint32_t>(line);
+                site.types.resize(count);
+                if (!stream.read(reinterpret_cast<char*>(site.types.data()), static_cast<std::streamsize>(count))) {
+                    return Result<void>::NOT_OK("truncated call site entry");
+                }
+
+                call_sites.emplace_back(std::move(site));
+                continue;
+            }
+
+            if ((entry & 0xf0) != detail::BINARY_LOG_RECORD || (entry & 0x0f) >= spdlog::level::n_levels) {
+                return Result<void>::NOT_OK(fmt::format("invalid entry {:#04x}", entry));
+            }
+
+            std::uint64_t id;
+            std::uint64_t delta;
+            std::uint64_t thread;
+            std::uint64_t size;
+
+            if (!detail::read_varint(stream, id) || !detail::read_varint(stream, delta) || !detail::read_varint(stream, thread) || !detail::read_varint(stream, size) || size > std::numeric_limits<std::uint32_t>::max()) {
+                return Result<void>::NOT_OK("truncated record entry");
+            }
+
+            if (id >= call_sites.size()) {
+                return Result<void>::NOT_OK(fmt::format("record refers to unknown call site {}", id));
+            }
+
+            arguments.resize(size);
+            if (!stream.read(arguments.data(), static_cast<std::streamsize>(size))) {
+                return Result<void>::NOT_OK("truncated record entry");
+            }
+
+            time += static_cast<std::int64_t>(delta >> 1) ^ -static_cast<std::int64_t>(delta & 1u);
+            const CallSite& site = call_sites[id];
+
+            // Arguments refer to (and names are null-terminated within) 'arguments', which outlives the store
+            fmt::dynamic_format_arg_store<fmt::format_context> store;
+            const char* in = arguments.data();
+            const char* end = in + arguments.size();
+            bool valid = true;
+
+            auto read = [&](void* out, std::size_t length) {
+                if (static_cast<std::size_t>(end - in) < length) {
+                    valid = false;
+                    return false;
+                }
+
+                std::memcpy(out, in, length);
+                in += length;
+                return true;
+            };
+
+            auto read_string = [&](std::string_view& out) {
+                std::uint32_t length;
+                if (!read(&length, sizeof(length)) || static_cast<std::size_t>(end - in) < length) {
+                    valid = false;
+                    return false;
+                }
+
+                out = std::string_view(in, length);
+                in += length;
+                return true;
+            };
+
+            for (std::size_t i = 0u; i < site.types.size() && valid; ++i) {
+                const char* name = nullptr;
+                ArgumentType type = site.types[i];
+
+                if (type == ArgumentType::Named) {
+                    std::string_view value;
+                    if (!read_string(value) || i + 1u == site.types.size() || in == end) {
+                        valid = false;
+                        break;
+                    }
+
+                    if (*in != '\0') {
+                        valid = false;
+                        break;
+                    }
+
+                    name = value.data();
+                    ++in; // Null terminator
+                    type = site.types[++i];
+                }
+
+                auto add = [&]<typename T>(std::type_identity<T>) {
+                    T value;
+                    if (read(&value, sizeof(T))) {
+                        if (name) {
+                            store.push_back(fmt::arg(name, value));
+                        }
+                        else {
+                            store.push_back(value);
+                        }
+                    }
+                };
+
+                switch (type) {
+                    case ArgumentType::Bool: {
+                        // Any other value is not a valid representation of bool
+                        std::uint8_t value;
+                        if (read(&value, sizeof(value))) {
+                            if (value > 1u) {
+                                valid = false;
+                            }
+                            else if (name) {
+                                store.push_back(fmt::arg(name, value != 0u));
+                            }
+                            else {
+                                store.push_back(value != 0u);
+                            }
+                        }
+                        break;
+                    }
+                    case ArgumentType::Char:
+                        add(std::type_identity<char>());
+                        break;
+                    case ArgumentType::Int8:
+                        add(std::type_identity<std::int8_t>());
+                        break;
+                    case ArgumentType::Int16:
+                        add(std::type_identity<std::int16_t>());
+                        break;
+                    case ArgumentType::Int32:
+                        add(std::type_identity<std::int32_t>());
+                        break;
+                    case ArgumentType::Int64:
+                        add(std::type_identity<std::int64_t>());
+                        break;
+                    case ArgumentType::UInt8:
+                        add(std::type_identity<std::uint8_t>());
+                        break;
+                    case ArgumentType::UInt16:
+                        add(std::type_identity<std::uint16_t>());
+                        break;
+                    case ArgumentType::UInt32:
+                        add(std::type_identity<std::uint32_t>());
+                        break;
+                    case ArgumentType::UInt64:
+                        add(std::type_identity<std::uint64_t>());
+                        break;
+                    case ArgumentType::Float:
+                        add(std::type_identity<float>());
+                        break;
+                    case ArgumentType::Double:
+                        add(std::type_identity<double>());
+                        break;
+                    case ArgumentType::LongDouble:
+                        add(std::type_identity<long double>());
+                        break;
+                    case ArgumentType::Pointer:
+                        add(std::type_identity<const void*>());
+                        break;
+                    case ArgumentType::String: {
+                        std::string_view value;
+                        if (read_string(value)) {
+                            if (name) {
+                                store.push_back(fmt::arg(name, value));
+                            }
+                            else {
+                                store.push_back(value);
+                            }
+                        }
+                        break;
+                    }
+                    default:
+                        valid = false;
+                        break;
+                }
+            }
+
+            message.clear();
+            if (!valid) {
+                fmt::format_to(fmt::appender(message), "failed to decode message arguments (format string '{}')", site.format);
+            }
+            else {
+                try {
+                    fmt::vformat_to(fmt::appender(message), site.format, store);
+                }
+                catch (const std::exception& e) {
+                    message.clear();
+                    fmt::format_to(fmt::appender(message), "failed to format message: {}", e.what());
+                }
+            }
+
+            callback(DecodedMessage {
+                std::chrono::system_clock::time_point(std::chrono::duration_cast<std::chrono::system_clock::duration>(std::chrono::nanoseconds(time))),
+                static_cast<std::size_t>(thread),
+                static_cast<spdlog::level::level_enum>(entry & 0x0f),
+                site.file,
+                site.line,
+                site.function,
+                std::string_view(message.data(), message.size())
+            });
+        }
+
+        if (stream.bad()) {
+            return Result<void>::NOT_OK("failed to read binary log");
+        }
+
+        return Result<void>::OK();
+    }
+
 }
@@ -1,26 +1,209 @@
 
 #include "utils/string.hpp"
+#include "utils/flat_hash_map.hpp"
+#include "utils/hash.hpp"
+#include "utils/static_map.hpp"
+#include <spdlog/fmt/compile.h>
 
+#include <algorithm> // std::min
 #include <limits>
+#include <memory> // std::unique_ptr
+#include <atomic> // std::atomic
 #include <charconv>
 #include <cerrno>
 #include <cstdlib>
 #include <stdexcept>
+#include <bit> // std::countr_zero
+#include <cstring> // std::memcmp, std::memcpy
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+    #define UTILS_STRING_SSE2 1
+    #include <emmintrin.h>
+#endif
+
+#if defined(__AVX2__)
+    #define UTILS_STRING_AVX2 1
+    #include <immintrin.h>
+#endif
 
 namespace utils {
 
     [[nodiscard]] std::vector<std::string_view> split(std::string_view in, std::string_view delimiter) {
         std::vector<std::string_view> components { };
 
-        std::size_t position;
-        do {
-            position = in.find(delimiter);
-            components.emplace_back(in.substr(0, position));
-            in = in.substr(position + delimiter.length());
+        for (std::string_view component : split_view(in, delimiter)) {
+            components.emplace_back(component);
+        }
+
+        return components;
+    }
+
+    SplitView::Iterator::Iterator() : m_length(0),
+                                      m_done(true) {
+    }
+
+    SplitView::Iterator::Iterator(std::string_view remaining, std::string_view delimiter) : m_remaining(remaining),
+                                                                                            m_delimiter(delimiter),
+                                                                                            m_length(delimiter.empty() ? std::string_view::npos : detail::find_delimiter(remaining, delimiter)),
+                                                                                            m_done(false) {
+    }
+
+    std::string_view SplitView::Iterator::operator*() const {
+        return m_remaining.substr(0, m_length);
+    }
+
+    SplitView::Iterator& SplitView::Iterator::operator++() {
+        if (m_length == std::string_view::npos) {
+            // The last piece (which extends to the end of the input) has been consumed
+            m_done = true;
+            return *this;
+        }
+
+        m_remaining.remove_prefix(m_length + m_delimiter.length());
+        m_length = detail::find_delimiter(m_remaining, m_delimiter);
+        return *this;
+    }
+
+    SplitView::Iterator SplitView::Iterator::operator++(int) {
+        Iterator copy = *this;
+        ++(*this);
+        return copy;
+    }
+
+    bool SplitView::Iterator::operator==(const Iterator& other) const {
+        if (m_done || other.m_done) {
+            return m_done == other.m_done;
+        }
+        return m_remaining.data() == other.m_remaining.data();
+    }
+
+    bool SplitView::Iterator::operator==(std::default_sentinel_t) const {
+        return m_done;
+    }
+
+    SplitView::SplitView(std::string_view in, std::string_view delimiter) : m_in(in),
+                                                                            m_delimiter(delimiter) {
+    }
+
+    SplitView::Iterator SplitView::begin() const {
+        return Iterator(m_in, m_delimiter);
+    }
+
+    std::default_sentinel_t SplitView::end() const {
+        return std::default_sentinel;
+    }
+
+    SplitView split_view(std::string_view in, std::string_view delimiter) {
+        return SplitView(in, delimiter);
+    }
+
+    std::size_t split_into(std::string_view in, std::string_view delimiter, std::span<std::string_view> out) {
+        if (out.empty()) {
+            return 0;
+        }
+
+        std::size_t count = 0;
+        while (count + 1 < out.size() && !delimiter.empty()) {
+            std::size_t position = detail::find_delimiter(in, delimiter);
+            if (position == std::string_view::npos) {
+                break;
+            }
+
+            out[count++] = in.substr(0, position);
+            in.remove_prefix(position + delimiter.length());
+        }
+
+        out[count++] = in;
+        return count;
+    }
+
+    namespace detail {
+
+        std::size_t find_delimiter(std::string_view in, char delimiter) {
+            const char* data = in.data();
+            std::size_t length = in.length();
+            std::size_t i = 0;
+
+            #if defined(UTILS_STRING_AVX2)
+                __m256i pattern256 = _mm256_set1_epi8(delimiter);
+                for (; i + 32 <= length; i += 32) {
+                    __m256i block = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + i));
+                    std::uint32_t mask = static_cast<std::uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(block, pattern256)));
+                    if (mask) {
+                        return i + static_cast<std::size_t>(std::countr_zero(mask));
+                    }
+                }
+            #endif
+
+            #if defined(UTILS_STRING_SSE2)
+                __m128i pattern = _mm_set1_epi8(delimiter);
+                for (; i + 16 <= length; i += 16) {
+                    __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i));
+                    std::uint32_t mask = static_cast<std::uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(block, pattern)));
+                    if (mask) {
+                        return i + static_cast<std::size_t>(std::countr_zero(mask));
+                    }
+                }
+            #endif
+
+            for (; i < length; ++i) {
+                if (data[i] == delimiter) {
+                    return i;
+                }
+            }
+
+            return std::string_view::npos;
+        }
+
+        std::size_t find_delimiter(std::string_view in, std::string_view delimiter) {
+            std::size_t size = delimiter.length();
+            if (size == 1) {
+                return find_delimiter(in, delimiter[0]);
+            }
+
+            const char* data = in.data();
+            std::size_t length = in.length();
+
+            if (size == 0) {
+                return 0;
+            }
+            if (size > length) {
+                return std::string_view::npos;
+            }
+
+            // Candidate positions are those where both the first and the last byte of the delimiter match, only those are compared in full
+            char first = delimiter.front();
+            char last = delimiter.back();
+            std::size_t i = 0;
+
+            #if defined(UTILS_STRING_SSE2)
+                __m128i first_pattern = _mm_set1_epi8(first);
+                __m128i last_pattern = _mm_set1_epi8(last);
+
+                for (; i + size - 1 + 16 <= length; i += 16) {
+                    __m128i first_block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i));
+                    __m128i last_block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i + size - 1));
+
+                    std::uint32_t mask = static_cast<std::uint32_t>(_mm_movemask_epi8(_mm_and_si128(_mm_cmpeq_epi8(first_block, first_pattern), _mm_cmpeq_epi8(last_block, last_pattern))));
+                    while (mask) {
+                        std::size_t candidate = i + static_cast<std::size_t>(std::countr_zero(mask));
+                        if (std::memcmp(data + candidate + 1, delimiter.data() + 1, size - 2) == 0) {
+                            return candidate;
+                        }
+                        mask &= mask - 1;
+                    }
+                }
+            #endif
+
+            for (; i + size <= length; ++i) {
+                if (data[i] == first && data[i + size - 1] == last && std::memcmp(data + i + 1, delimiter.data() + 1, size - 2) == 0) {
+                    return i;
+                }
+            }
+
+            return std::string_view::npos;
         }
-        while (position != std::string::npos);
 
-        return std::move(components);
     }
 
     [[nodiscard]] std::string_view trim(std::string_view in) {
@@ -29,25 +212,212 @@ namespace utils {
         }
 
         std::size_t start = 0;
-        while (std::isspace(in[start])) {
+        while (start != in.length() && std::isspace(static_cast<unsigned char>(in[start]))) {
             ++start;
         }
 
+        if (start == in.length()) {
+            return "";
+        }
+
         std::size_t end = in.length() - 1;
-        while (end != start && std::isspace(in[end])) {
+        while (end != start && std::isspace(static_cast<unsigned char>(in[end]))) {
             --end;
         }
 
-        return in.substr(start, end + 1);
+        return in.substr(start, end - start + 1);
+    }
+
+    namespace detail {
+
+        // Converts the 8 bytes of 'word' to lowercase at once
+        std::uint64_t to_lowercase(std::uint64_t word) {
+            // Adding to the lower 7 bits of each byte sets the high bit (without carrying into the next byte) for bytes >= 'A' and for bytes > 'Z', respectively
+            std::uint64_t heptets = word & 0x7f7f7f7f7f7f7f7full;
+            std::uint64_t at_least_a = heptets + 0x3f3f3f3f3f3f3f3full;
+            std::uint64_t above_z = heptets + 0x2525252525252525ull;
+
+            // Bytes with the high bit set are never letters
+            std::uint64_t uppercase = at_least_a & ~above_z & ~word & 0x8080808080808080ull;
+            return word | (uppercase >> 2);
+        }
+
+        #if defined(UTILS_STRING_AVX2)
+            __m256i to_lowercase(__m256i bytes) {
+                // Offsetting 'A' to -128 selects 'A'-'Z' with a single signed comparison
+                __m256i offset = _mm256_add_epi8(bytes, _mm256_set1_epi8(static_cast<char>(-128 - 'A')));
+                __m256i uppercase = _mm256_cmpgt_epi8(_mm256_set1_epi8(static_cast<char>(-128 + 26)), offset);
+                return _mm256_or_si256(bytes, _mm256_and_si256(uppercase, _mm256_set1_epi8(0x20)));
+            }
+        #endif
+
+        #if defined(UTILS_STRING_SSE2)
+            __m128i to_lowercase(__m128i bytes) {
+                // Offsetting 'A' to -128 selects 'A'-'Z' with a single signed comparison
+                __m128i offset = _mm_add_epi8(bytes, _mm_set1_epi8(static_cast<char>(-128 - 'A')));
+                __m128i uppercase = _mm_cmplt_epi8(offset, _mm_set1_epi8(static_cast<char>(-128 + 26)));
+                return _mm_or_si128(bytes, _mm_and_si128(uppercase, _mm_set1_epi8(0x20)));
+            }
+        #endif
+
+        bool icase_equal(const char* first, const char* second, std::size_t length) {
+            std::size_t i = 0;
+
+            #if defined(UTILS_STRING_AVX2)
+                for (; i + 32 <= length; i += 32) {
+                    __m256i a = to_lowercase(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(first + i)));
+                    __m256i b = to_lowercase(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(second + i)));
+                    if (_mm256_movemask_epi8(_mm256_cmpeq_epi8(a, b)) != -1) {
+                        return false;
+                    }
+                }
+            #endif
+
+            #if defined(UTILS_STRING_SSE2)
+                for (; i + 16 <= length; i += 16) {
+                    __m128i a = to_lowercase(_mm_loadu_si128(reinterpret_cast<const __m128i*>(first + i)));
+                    __m128i b = to_lowercase(_mm_loadu_si128(reinterpret_cast<const __m128i*>(second + i)));
+                    if (_mm_movemask_epi8(_mm_cmpeq_epi8(a, b)) != 0xffff) {
+                        return false;
+                    }
+                }
+            #endif
+
+            for (; i + 8 <= length; i += 8) {
+                std::uint64_t a;
+                std::uint64_t b;
+                std::memcpy(&a, first + i, sizeof(a));
+                std::memcpy(&b, second + i, sizeof(b));
+
+                // Identical words (the common case for equal strings) skip the conversion
+                if (a != b && to_lowercase(a) != to_lowercase(b)) {
+                    return false;
+                }
+            }
+
+            for (; i < length; ++i) {
+                if (first[i] != second[i] && ascii_to_lower(first[i]) != ascii_to_lower(second[i])) {
+                    return false;
+                }
+            }
+
+            return true;
+        }
+
+        void to_lowercase(const char* in, std::size_t length, char* out) {
+            std::size_t i = 0;
+
+            #if defined(UTILS_STRING_AVX2)
+                for (; i + 32 <= length; i += 32) {
+                    _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + i), to_lowercase(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(in + i))));
+                }
+            #endif
+
+            #if defined(UTILS_STRING_SSE2)
+                for (; i + 16 <= length; i += 16) {
+                    _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i), to_lowercase(_mm_loadu_si128(reinterpret_cast<const __m128i*>(in + i))));
+                }
+            #endif
+
+            for (; i + 8 <= length; i += 8) {
+                std::uint64_t word;
+                std::memcpy(&word, in + i, sizeof(word));
+                word = to_lowercase(word);
+                std::memcpy(out + i, &word, sizeof(word));
+            }
+
+            for (; i < length; ++i) {
+                out[i] = ascii_to_lower(in[i]);
+            }
+        }
+
+    }
+
+    bool icase_starts_with(std::string_view in, std::string_view prefix) {
+        return in.length() >= prefix.length() && detail::icase_equal(in.data(), prefix.data(), prefix.length());
+    }
+
+    bool icase_ends_with(std::string_view in, std::string_view suffix) {
+        return in.length() >= suffix.length() && detail::icase_equal(in.data() + in.length() - suffix.length(), suffix.data(), suffix.length());
+    }
+
+    std::size_t icase_find(std::string_view in, std::string_view needle) {
+        std::size_t size = needle.length();
+        std::size_t length = in.length();
+
+        if (size == 0) {
+            return 0;
+        }
+        if (size > length) {
+            return std::string_view::npos;
+        }
+
+        const char* data = in.data();
+
+        // Candidate positions are those where both the first and the last byte of the needle match, only those are compared in full
+        char first = detail::ascii_to_lower(needle.front());
+        char last = detail::ascii_to_lower(needle.back());
+        std::size_t i = 0;
+
+        #if defined(UTILS_STRING_SSE2)
+            __m128i first_pattern = _mm_set1_epi8(first);
+            __m128i last_pattern = _mm_set1_epi8(last);
+
+            for (; i + size - 1 + 16 <= length; i += 16) {
+                __m128i first_block = detail::to_lowercase(_mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i)));
+                __m128i last_block = detail::to_lowercase(_mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i + size - 1)));
+
+                std::uint32_t mask = static_cast<std::uint32_t>(_mm_movemask_epi8(_mm_and_si128(_mm_cmpeq_epi8(first_block, first_pattern), _mm_cmpeq_epi8(last_block, last_pattern))));
+                while (mask) {
+                    std::size_t candidate = i + static_cast<std::size_t>(std::countr_zero(mask));
+                    if (size <= 2 || detail::icase_equal(data + candidate + 1, needle.data() + 1, size - 2)) {
+                        return candidate;
+                    }
+                    mask &= mask - 1;
+                }
+            }
+        #endif
+
+        for (; i + size <= length; ++i) {
+            if (detail::ascii_to_lower(data[i]) == first && detail::ascii_to_lower(data[i + size - 1]) == last && (size <= 2 || detail::icase_equal(data + i + 1, needle.data() + 1, size - 2))) {
+                return i;
+            }
+        }
+
+        return std::string_view::npos;
+    }
+
+    std::size_t ICaseHash::operator()(std::string_view value) const {
+        // Hashes the lowercase form of the string, converted in blocks so that no allocation is necessary
+        char buffer[256];
+
+        if (value.length() <= sizeof(buffer)) {
+            detail::to_lowercase(value.data(), value.length(), buffer);
+            return static_cast<std::size_t>(hash64(std::string_view(buffer, value.length())));
+        }
+
+        Hasher64 hasher { };
+        for (std::size_t offset = 0; offset < value.length(); offset += sizeof(buffer)) {
+            std::size_t size = std::min(sizeof(buffer), value.length() - offset);
+            detail::to_lowercase(value.data() + offset, size, buffer);
+            hasher.update(std::string_view(buffer, size));
+        }
+
+        return static_cast<std::size_t>(hasher.digest());
+    }
+
+    bool ICaseEqual::operator()(std::string_view first, std::string_view second) const {
+        return first.length() == second.length() && detail::icase_equal(first.data(), second.data(), first.length());
     }
 
     template <typename T>
-    inline std::size_t fundamental_from_string(std::string_view in, T& out, int base) {
+    // 'offset' receives the position of the first digit in 'in' (after any whitespace, sign, or base prefix), the returned count is relative to the beginning of 'in'
+    inline FromStringResult fundamental_try_from_string(std::string_view in, T& out, int base, std::size_t& offset) {
         // Leading whitespace is not ignored
         std::string_view str = trim(in);
 
         if (str.empty()) {
-            // throw FormattedError("");
+            return { 0, std::errc::invalid_argument };
         }
 
         // Only a leading '-' is permitted at the beginning
@@ -89,13 +459,20 @@ namespace utils {
         else {
             // Falls back to strtold since std::from_chars has no floating-point overload for T on this standard library (some implementations, such as libc++, only implement one for float and double, not long double)
             // std::strtold does not take a string length, so copy it into a null-terminated buffer to avoid overrun
-            std::string buffer { str };
+            // The buffer lives on the stack to keep this path allocation-free, longer inputs are not valid numbers in practice and are rejected
+            char buffer[128];
+            if (str.length() >= sizeof(buffer)) {
+                return { 0, std::errc::invalid_argument };
+            }
+
+            std::memcpy(buffer, str.data(), str.length());
+            buffer[str.length()] = '\0';
 
             errno = 0;
             char* parsed_end = nullptr;
-            out = std::strtold(buffer.c_str(), &parsed_end);
+            T value = std::strtold(buffer, &parsed_end);
 
-            std::size_t character_count = static_cast<std::size_t>(parsed_end - buffer.c_str());
+            std::size_t character_count = static_cast<std::size_t>(parsed_end - buffer);
             if (character_count == 0) {
                 result = { start, std::errc::invalid_argument };
             }
@@ -103,22 +480,30 @@ namespace utils {
                 result = { start + character_count, std::errc::result_out_of_range };
             }
             else {
+                out = value;
                 result = { start + character_count, std::errc { } };
             }
         }
 
-        const auto& [ptr, error_code] = result;
+        offset = static_cast<std::size_t>(start - in.data());
+        return { static_cast<std::size_t>(result.ptr - in.data()), result.ec };
+    }
 
-        if (error_code == std::errc::invalid_argument) {
+    template <typename T>
+    inline std::size_t fundamental_from_string(std::string_view in, T& out, int base) {
+        std::size_t offset = 0;
+        FromStringResult result = fundamental_try_from_string(in, out, base, offset);
+
+        if (result.error == std::errc::invalid_argument) {
             throw std::runtime_error(format("Failed to convert '{}' to a number", in));
         }
 
-        if (error_code == std::errc::result_out_of_range) {
+        if (result.error == std::errc::result_out_of_range) {
             out = std::numeric_limits<T>::max();
         }
 
-        // Return the number of characters processed
-        return ptr - start;
+        // Number of characters processed
+        return result.count - offset;
     }
 
     std::size_t from_string(std::string_view in, unsigned char& out, int base) {
@@ -169,18 +554,245 @@ namespace utils {
         return fundamental_from_string(in, out, 0);
     }
 
+    FromStringResult::operator bool() const {
+        return error == std::errc { };
+    }
+
+    FromStringResult try_from_string(std::string_view in, unsigned char& out, int base) {
+        std::size_t offset;
+        return fundamental_try_from_string(in, out, base, offset);
+    }
+
+    FromStringResult try_from_string(std::string_view in, short& out, int base) {
+        std::size_t offset;
+        return fundamental_try_from_string(in, out, base, offset);
+    }
+
+    FromStringResult try_from_string(std::string_view in, unsigned short& out, int base) {
+        std::size_t offset;
+        return fundamental_try_from_string(in, out, base, offset);
+    }
+
+    FromStringResult try_from_string(std::string_view in, int& out, int base) {
+        std::size_t offset;
+        return fundamental_try_from_string(in, out, base, offset);
+    }
+
+    FromStringResult try_from_string(std::string_view in, unsigned& out, int base) {
+        std::size_t offset;
+        return fundamental_try_from_string(in, out, base, offset);
+    }
+
+    FromStringResult try_from_string(std::string_view in, long& out, int base) {
+        std::size_t offset;
+        return fundamental_try_from_string(in, out, base, offset);
+    }
+
+    FromStringResult try_from_string(std::string_view in, unsigned long& out, int base) {
+        std::size_t offset;
+        return fundamental_try_from_string(in, out, base, offset);
+    }
+
+    FromStringResult try_from_string(std::string_view in, long long& out, int base) {
+        std::size_t offset;
+        return fundamental_try_from_string(in, out, base, offset);
+    }
+
+    FromStringResult try_from_string(std::string_view in, unsigned long long& out, int base) {
+        std::size_t offset;
+        return fundamental_try_from_string(in, out, base, offset);
+    }
+
+    FromStringResult try_from_string(std::string_view in, float& out) {
+        std::size_t offset;
+        return fundamental_try_from_string(in, out, 0, offset);
+    }
+
+    FromStringResult try_from_string(std::string_view in, double& out) {
+        std::size_t offset;
+        return fundamental_try_from_string(in, out, 0, offset);
+    }
+
+    FromStringResult try_from_string(std::string_view in, long double& out) {
+        std::size_t offset;
+        return fundamental_try_from_string(in, out, 0, offset);
+    }
+
     FormatString::FormatString(const std::string& format, std::source_location source) : format(format),
-                                                                                         source(source) {
+                                                                                         source(source),
+                                                                                         literal(false) {
     }
 
     FormatString::FormatString(std::string_view format, std::source_location source) : format(format),
-                                                                                       source(source) {
+                                                                                       source(source),
+                                                                                       literal(false) {
     }
 
-    FormatString::FormatString(const char* format, std::source_location source) : format(format),
-                                                                                  source(source) {
+    FormatString::~FormatString() = default;
+
+    namespace detail {
+
+        // Format string split into literal text and replacement fields
+        struct ParsedFormatString {
+            struct Segment {
+                std::string_view text; // Empty for replacement fields
+                int index; // -1 for named fields and literal text
+                std::string_view name;
+                std::string_view specification;
+
+                // Formatter for the argument type this field was last used with, with the specification already parsed (the type is identified by the
+                // address of formatter_type_tag<T>, nullptr if no formatter is cached)
+                const void* formatter_type = nullptr;
+                alignas(std::max_align_t) std::byte formatter[64];
+            };
+
+            void on_text(std::string_view text) {
+                Segment& segment = segments.emplace_back();
+                segment.text = text;
+                segment.index = -1;
+            }
+
+            void on_field(int index, std::string_view name, std::string_view specification) {
+                nested = nested || specification.find('{') != std::string_view::npos;
+
+                Segment& segment = segments.emplace_back();
+                segment.index = index;
+                segment.name = name;
+                segment.specification = specification;
+            }
+
+            std::size_t length = 0; // Guards against a format string of a different length at the same address
+            std::vector<Segment> segments;
+            bool nested = false; // Specifications refer to other arguments, which is left to fmt
+        };
+
+        struct PointerHash {
+            std::size_t operator()(const char* pointer) const {
+                return Hash<std::uintptr_t> { }(reinterpret_cast<std::uintptr_t>(pointer));
+            }
+        };
+
+        // Returns the parsed form of a literal format string, or nullptr if the format string must be formatted by fmt directly
+        ParsedFormatString* parsed_format_string(std::string_view format) {
+            // Literals are immutable and have static storage duration, so their address identifies them
+            // Values are allocated individually so that pointers remain valid if formatting an argument formats (and caches) another string
+            thread_local FlatHashMap<const char*, std::unique_ptr<ParsedFormatString>, PointerHash> cache;
+
+            auto iterator = cache.find(format.data());
+            if (iterator == cache.end()) {
+                std::unique_ptr<ParsedFormatString> parsed = std::make_unique<ParsedFormatString>();
+                parsed->length = format.length();
+
+                // Validated at compile time
+                parse_format_string(format, *parsed);
+
+                iterator = cache.emplace(format.data(), std::move(parsed)).first;
+            }
+
+            ParsedFormatString* parsed = iterator->second.get();
+            if (parsed->length != format.length() || parsed->nested) {
+                return nullptr;
+            }
+
+            return parsed;
+        }
+
+        template <typename T>
+        inline constexpr char formatter_type_tag = 0;
+
+        // Formats a single argument according to the specification of its field
+        struct ArgumentFormatter {
+            template <typename T>
+            void operator()(T value) {
+                if constexpr (std::is_same<T, fmt::monostate>::value) {
+                    throw fmt::format_error("argument not found");
+                }
+                else if constexpr (std::is_same<T, fmt::basic_format_arg<fmt::format_context>::handle>::value) {
+                    // User-defined formatters parse their specification on every call, as they may hold arbitrary state
+                    fmt::format_parse_context parse_context(fmt::string_view(segment.specification.data(), segment.specification.length()));
+                    value.format(parse_context, context);
+                }
+                else if (segment.specification.empty()) {
+                    // Default formatting is compiled for each argument type, bypassing format specifications entirely
+                    context.advance_to(fmt::format_to(context.out(), FMT_COMPILE("{}"), value));
+                }
+                else if constexpr (sizeof(fmt::formatter<T>) <= sizeof(segment.formatter) && std::is_trivially_copyable<fmt::formatter<T>>::value) {
+                    // Built-in formatters only hold the parsed specification, parse it on first use (for this argument type) and reuse the result afterwards
+                    if (segment.formatter_type != &formatter_type_tag<T>) {
+                        fmt::formatter<T> formatter = parse<T>();
+                        std::memcpy(segment.formatter, &formatter, sizeof(formatter));
+                        segment.formatter_type = &formatter_type_tag<T>;
+                    }
+
+                    context.advance_to(reinterpret_cast<const fmt::formatter<T>*>(segment.formatter)->format(value, context));
+                }
+                else {
+                    context.advance_to(parse<T>().format(value, context));
+                }
+            }
+
+            template <typename T>
+            fmt::formatter<T> parse() const {
+                fmt::format_parse_context parse_context(fmt::string_view(segment.specification.data(), segment.specification.length()));
+
+                fmt::formatter<T> formatter { };
+                if (formatter.parse(parse_context) != parse_context.end()) {
+                    throw fmt::format_error("unknown format specifier");
+                }
+
+                return formatter;
+            }
+
+            ParsedFormatString::Segment& segment;
+            fmt::format_context& context;
+        };
+
+        void invalid_format_string(const char* error) {
+            throw fmt::format_error(error);
+        }
+
+        fmt::appender vformat_to(fmt::appender out, const FormatString& str, fmt::format_args args) {
+            try {
+                ParsedFormatString* parsed = str.literal ? parsed_format_string(str.format) : nullptr;
+                if (!parsed) {
+                    return fmt::vformat_to(out, fmt::string_view(str.format.data(), str.format.length()), args);
+                }
+
+                fmt::format_context context(out, args);
+
+                for (ParsedFormatString::Segment& segment : parsed->segments) {
+                    if (segment.index < 0 && segment.name.empty()) {
+                        // Copied into the underlying buffer in one piece
+                        context.advance_to(fmt::format_to(context.out(), FMT_COMPILE("{}"), fmt::string_view(segment.text.data(), segment.text.length())));
+                        continue;
+                    }
+
+                    fmt::basic_format_arg<fmt::format_context> argument = segment.name.empty() ? args.get(segment.index) : args.get(fmt::string_view(segment.name.data(), segment.name.length()));
+                    fmt::visit_format_arg(ArgumentFormatter { segment, context }, argument);
+                }
+
+                return context.out();
+            }
+            catch (const fmt::format_error& error) {
+                throw std::runtime_error(fmt::format("{} ({}:{})", error.what(), str.source.file_name(), str.source.line()));
+            }
+        }
+
     }
 
-    FormatString::~FormatString() = default;
+    namespace detail {
+
+        // Large enough for any container that is meant to be read in a log line
+        std::atomic<std::size_t> container_format_limit { 256 };
+
+    }
+
+    void set_container_format_limit(std::size_t limit) {
+        detail::container_format_limit.store(limit, std::memory_order_relaxed);
+    }
+
+    std::size_t container_format_limit() {
+        return detail::container_format_limit.load(std::memory_order_relaxed);
+    }
 
 }
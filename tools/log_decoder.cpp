@@ -0,0 +1,38 @@
+
+#include "utils/logging.hpp"
+#include <spdlog/fmt/chrono.h>
+#include <cstdio> // std::fputs, stderr
+#include <fstream> // std::ifstream
+
+// Prints the messages of binary logs written by utils::logging::enable_binary(), one per line
+// Usage: utils-log-decoder <file>...
+
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        std::fputs("usage: utils-log-decoder <file>...\n", stderr);
+        return 1;
+    }
+
+    int status = 0;
+
+    for (int i = 1; i < argc; ++i) {
+        std::ifstream file(argv[i], std::ios::binary);
+        if (!file) {
+            fmt::print(stderr, "{}: failed to open file\n", argv[i]);
+            status = 1;
+            continue;
+        }
+
+        utils::Result<void> result = utils::logging::decode_binary_log(file, [](const utils::logging::DecodedMessage& message) {
+            spdlog::string_view_t level = spdlog::level::to_string_view(message.level);
+            fmt::print("[{:%Y-%m-%d %H:%M:%S}] [{}] [{}] {} ({}:{})\n", message.time, std::string_view(level.data(), level.size()), message.thread, message.message, message.file, message.line);
+        });
+
+        if (!result.ok()) {
+            fmt::print(stderr, "{}: {}\n", argv[i], result.error());
+            status = 1;
+        }
+    }
+
+    return status;
+}